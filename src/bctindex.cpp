@@ -0,0 +1,70 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bctindex.h>
+
+#include <base58.h>
+#include <chain.h>
+#include <clientversion.h>
+#include <consensus/params.h>
+#include <primitives/block.h>
+#include <script/standard.h>
+#include <util.h>
+
+static const char DB_BCT = 'b';
+
+std::unique_ptr<CBCTIndex> pbctindex;
+
+CBCTIndex::CBCTIndex(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "bctindex", nCacheSize, fMemory, fWipe), nHits(0), nMisses(0)
+{
+}
+
+bool CBCTIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex, const CDiskBlockPos& blockPos, const Consensus::Params& consensusParams)
+{
+    if (block.IsForgeMined(consensusParams))    // No BCTs will be found in Forgemined blocks
+        return true;
+
+    CScript scriptPubKeyBCF = GetScriptForDestination(DecodeDestination(consensusParams.hammerCreationAddress));
+    CScript scriptPubKeyCF;
+
+    CDBBatch batch(*this);
+    CDiskTxPos pos(blockPos, GetSizeOfCompactSize(block.vtx.size()));
+    for (const auto& tx : block.vtx) {
+        if (tx->IsBCT(consensusParams, scriptPubKeyBCF)) {
+            if (scriptPubKeyCF.empty())
+                scriptPubKeyCF = GetScriptForDestination(DecodeDestination(consensusParams.forgeCommunityAddress));
+
+            CBCTLocator locator;
+            locator.hashBlock = pindex->GetBlockHash();
+            locator.nHeight = pindex->nHeight;
+            locator.pos = pos;
+            locator.hammerValue = tx->vout[0].nValue;
+            locator.scriptPubKey = tx->vout[0].scriptPubKey;
+            if (tx->vout.size() > 1 && tx->vout[1].scriptPubKey == scriptPubKeyCF) {
+                locator.fCommunityContrib = true;
+                locator.donationAmount = tx->vout[1].nValue;
+            }
+            batch.Write(std::make_pair(DB_BCT, tx->GetHash()), locator);
+        }
+        pos.nTxOffset += ::GetSerializeSize(*tx, SER_DISK, CLIENT_VERSION);
+    }
+
+    if (batch.SizeEstimate() == 0)
+        return true;
+    return WriteBatch(batch);
+}
+
+bool CBCTIndex::Lookup(const uint256& txid, const CBlockIndex* pindexPrev, CBCTLocator& locator)
+{
+    if (Read(std::make_pair(DB_BCT, txid), locator) && locator.nHeight <= pindexPrev->nHeight) {
+        const CBlockIndex* pindex = pindexPrev->GetAncestor(locator.nHeight);
+        if (pindex && pindex->GetBlockHash() == locator.hashBlock) {
+            nHits++;
+            return true;
+        }
+    }
+
+    nMisses++;
+    return false;
+}
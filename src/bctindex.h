@@ -0,0 +1,91 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BCTINDEX_H
+#define BITCOIN_BCTINDEX_H
+
+#include <amount.h>
+#include <dbwrapper.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <txdb.h>
+#include <uint256.h>
+
+#include <atomic>
+#include <memory>
+
+class CBlock;
+class CBlockIndex;
+
+namespace Consensus { struct Params; };
+
+//! -bctindex default
+static const bool DEFAULT_BCTINDEX = false;
+//! max. -dbcache (MiB) used for the BCT index
+static const int64_t nMaxBCTIndexCache = 8;
+
+/** Thor: Forge: Where a BCT was mined, and the outputs CheckForgeProof needs from it. */
+struct CBCTLocator
+{
+    uint256 hashBlock;
+    int nHeight;
+    CDiskTxPos pos;             // Block position and offset of the BCT within it
+    CAmount hammerValue;        // vout[0] value
+    CScript scriptPubKey;       // vout[0] scriptPubKey (the BCT script, carrying the gold address)
+    bool fCommunityContrib;     // Whether vout[1] pays the community fund
+    CAmount donationAmount;     // vout[1] value, if it does
+
+    CBCTLocator() : nHeight(0), hammerValue(0), fCommunityContrib(false), donationAmount(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(VARINT(nHeight));
+        READWRITE(pos);
+        READWRITE(hammerValue);
+        READWRITE(scriptPubKey);
+        READWRITE(fCommunityContrib);
+        READWRITE(donationAmount);
+    }
+};
+
+/**
+ * Thor: Forge: Optional BCT locator index (blocks/bctindex/), keyed by BCT txid.
+ *
+ * Lets CheckForgeProof find a BCT that isn't in the UTXO set (eg during
+ * -reindex or -reindex-chainstate) with a single key lookup instead of
+ * reading and scanning the block at the claimed height. Entries are written
+ * as blocks are accepted, so on reindex a BCT is indexed before the Forge
+ * blocks using it are checked, and the index lives outside the block tree DB
+ * so it survives -reindex. An entry is only used if its block is on the chain
+ * being validated; anything else counts as a miss and the caller falls back
+ * to reading the block.
+ */
+class CBCTIndex : public CDBWrapper
+{
+private:
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+
+public:
+    explicit CBCTIndex(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+    CBCTIndex(const CBCTIndex&) = delete;
+    CBCTIndex& operator=(const CBCTIndex&) = delete;
+
+    /** Record the BCTs in a block stored at blockPos */
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex, const CDiskBlockPos& blockPos, const Consensus::Params& consensusParams);
+
+    /** Look up a BCT mined in an ancestor of (or at) pindexPrev; counts a hit or a miss */
+    bool Lookup(const uint256& txid, const CBlockIndex* pindexPrev, CBCTLocator& locator);
+
+    uint64_t GetHits() const { return nHits.load(); }
+    uint64_t GetMisses() const { return nMisses.load(); }
+};
+
+extern std::unique_ptr<CBCTIndex> pbctindex;
+
+#endif // BITCOIN_BCTINDEX_H
@@ -37,7 +37,10 @@ main(int argc, char** argv)
                   << HelpMessageOpt("-printer=(console|plot)", strprintf(_("Choose printer format. console: print data to console. plot: Print results as HTML graph (default: %s)"), DEFAULT_BENCH_PRINTER))
                   << HelpMessageOpt("-plot-plotlyurl=<uri>", strprintf(_("URL to use for plotly.js (default: %s)"), DEFAULT_PLOT_PLOTLYURL))
                   << HelpMessageOpt("-plot-width=<x>", strprintf(_("Plot width in pixel (default: %u)"), DEFAULT_PLOT_WIDTH))
-                  << HelpMessageOpt("-plot-height=<x>", strprintf(_("Plot height in pixel (default: %u)"), DEFAULT_PLOT_HEIGHT));
+                  << HelpMessageOpt("-plot-height=<x>", strprintf(_("Plot height in pixel (default: %u)"), DEFAULT_PLOT_HEIGHT))
+                  << HelpMessageOpt("-forgeblockinterval=<n>", _("Forge benchmarks: make one synthetic block in <n> Forgemined, 0 for none (default: 4)"))
+                  << HelpMessageOpt("-forgebctinterval=<n>", _("Forge benchmarks: put a pair of BCTs in one synthetic PoW block in <n>, 0 for none (default: 8)"))
+                  << HelpMessageOpt("-forgelifespan=<n>", _("Forge benchmarks: hammer lifespan in blocks, which also sets the synthetic chain length (default: the chain's own)"));
 
         return 0;
     }
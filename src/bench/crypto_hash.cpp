@@ -52,6 +52,45 @@ static void SHA256_32b(benchmark::State& state)
     }
 }
 
+static void SHA256D64_1024(benchmark::State& state)
+{
+    std::vector<uint8_t> in(64 * 1024, 0);
+    while (state.KeepRunning()) {
+        SHA256D64(in.data(), in.data(), 1024);
+    }
+}
+
+/* Per-kernel SHA256 throughput. Each case restricts SHA256AutoDetect() to one
+ * implementation for its duration; on CPUs (or builds) without that kernel it
+ * falls back to the next best one, so compare against the "standard" case. */
+static void SHA256Kernel(benchmark::State& state, sha256_implementation::UseImplementation use_implementation)
+{
+    uint8_t hash[CSHA256::OUTPUT_SIZE];
+    std::vector<uint8_t> in(BUFFER_SIZE,0);
+    SHA256AutoDetect(use_implementation);
+    while (state.KeepRunning())
+        CSHA256().Write(in.data(), in.size()).Finalize(hash);
+    SHA256AutoDetect();
+}
+
+static void SHA256D64Kernel(benchmark::State& state, sha256_implementation::UseImplementation use_implementation)
+{
+    std::vector<uint8_t> in(64 * 1024, 0);
+    SHA256AutoDetect(use_implementation);
+    while (state.KeepRunning())
+        SHA256D64(in.data(), in.data(), 1024);
+    SHA256AutoDetect();
+}
+
+static void SHA256_STANDARD(benchmark::State& state) { SHA256Kernel(state, sha256_implementation::STANDARD); }
+static void SHA256_SSE4(benchmark::State& state) { SHA256Kernel(state, sha256_implementation::USE_SSE4); }
+static void SHA256_SHANI(benchmark::State& state) { SHA256Kernel(state, sha256_implementation::USE_SSE4_AND_SHANI); }
+
+static void SHA256D64_1024_STANDARD(benchmark::State& state) { SHA256D64Kernel(state, sha256_implementation::STANDARD); }
+static void SHA256D64_1024_SSE4(benchmark::State& state) { SHA256D64Kernel(state, sha256_implementation::USE_SSE4); }
+static void SHA256D64_1024_AVX2(benchmark::State& state) { SHA256D64Kernel(state, sha256_implementation::USE_SSE4_AND_AVX2); }
+static void SHA256D64_1024_SHANI(benchmark::State& state) { SHA256D64Kernel(state, sha256_implementation::USE_SSE4_AND_SHANI); }
+
 static void SHA512(benchmark::State& state)
 {
     uint8_t hash[CSHA512::OUTPUT_SIZE];
@@ -92,7 +131,16 @@ BENCHMARK(SHA1, 570);
 BENCHMARK(SHA256, 340);
 BENCHMARK(SHA512, 330);
 
+BENCHMARK(SHA256_STANDARD, 270);
+BENCHMARK(SHA256_SSE4, 270);
+BENCHMARK(SHA256_SHANI, 1400);
+
 BENCHMARK(SHA256_32b, 4700 * 1000);
+BENCHMARK(SHA256D64_1024, 7400);
+BENCHMARK(SHA256D64_1024_STANDARD, 1100);
+BENCHMARK(SHA256D64_1024_SSE4, 1700);
+BENCHMARK(SHA256D64_1024_AVX2, 4700);
+BENCHMARK(SHA256D64_1024_SHANI, 6600);
 BENCHMARK(SipHash_32b, 40 * 1000 * 1000);
 BENCHMARK(FastRandom_32bit, 110 * 1000 * 1000);
 BENCHMARK(FastRandom_1bit, 440 * 1000 * 1000);
@@ -0,0 +1,118 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/forgechain.h>
+
+#include <chainparams.h>
+#include <pow.h>
+#include <util.h>
+#include <validation.h>
+
+#include <assert.h>
+
+// Thor: Forge: The Forge consensus paths on a synthetic mainnet-shaped chain held in memory.
+// The chain shape is set with -forgeblockinterval, -forgebctinterval and -forgelifespan (see
+// ForgeChainOptions); hammer check throughput is measured by ForgeCheck1M.
+
+/* Number of distinct Forge blocks checked per iteration */
+static const int FORGE_BLOCK_COUNT = 16;
+
+/* Number of blocks retargeted per iteration */
+static const int RETARGET_BLOCK_COUNT = 1000;
+
+static void BuildForgeBlocks(const SyntheticForgeChain& chain, std::vector<CBlock>& blocks)
+{
+    // Use BCTs spread over the mature part of the lifespan window
+    const int nTipHeight = chain.vIndex.back().nHeight;
+    std::vector<const ForgeChainBCT*> mature;
+    for (const ForgeChainBCT& bct : chain.vBCTs) {
+        int nDepth = nTipHeight + 1 - bct.nHeight;
+        if (nDepth >= chain.consensus.hammerGestationBlocks && nDepth <= chain.consensus.hammerGestationBlocks + chain.consensus.hammerLifespanBlocks)
+            mature.push_back(&bct);
+    }
+    assert(!mature.empty());
+
+    const size_t nStep = std::max<size_t>(1, mature.size() / FORGE_BLOCK_COUNT);
+    for (size_t i = 0; i < mature.size() && blocks.size() < FORGE_BLOCK_COUNT; i += nStep) {
+        CBlock block;
+        if (BuildForgeBlock(chain, *mature[i], block))
+            blocks.push_back(block);
+    }
+    assert(!blocks.empty());
+}
+
+static void ForgeProofCheck(benchmark::State& state, bool fCache)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    SyntheticForgeChain chain;
+    BuildSyntheticForgeChain(chain, ForgeChainOptions::FromArgs());
+    ForgeChainContext context(chain);
+
+    std::vector<CBlock> blocks;
+    BuildForgeBlocks(chain, blocks);
+
+    // A cache this small never holds the block about to be checked again
+    if (!fCache)
+        gArgs.ForceSetArg("-maxforgeproofcachesize", "0");
+    InitForgeProofCache();
+
+    while (state.KeepRunning()) {
+        for (const CBlock& block : blocks) {
+            bool fValid = CheckForgeProof(&block, chain.consensus);
+            assert(fValid);
+        }
+    }
+
+    gArgs.ForceSetArg("-maxforgeproofcachesize", std::to_string(DEFAULT_MAX_FORGE_PROOF_CACHE_SIZE));
+    InitForgeProofCache();
+}
+
+static void ForgeProofValidate(benchmark::State& state)
+{
+    ForgeProofCheck(state, false);
+}
+
+static void ForgeProofCached(benchmark::State& state)
+{
+    ForgeProofCheck(state, true);
+}
+
+// Retarget on each of the last RETARGET_BLOCK_COUNT blocks, as a node does for each block it connects
+static void ForgeTargetRetarget(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    SyntheticForgeChain chain;
+    BuildSyntheticForgeChain(chain, ForgeChainOptions::FromArgs());
+    ForgeChainContext context(chain);
+
+    const int nSamples = std::min((int)chain.vIndex.size(), RETARGET_BLOCK_COUNT);
+    while (state.KeepRunning()) {
+        unsigned int nBitsSum = 0;
+        for (int i = chain.vIndex.size() - nSamples; i < (int)chain.vIndex.size(); i++)
+            nBitsSum += GetNextForgeWorkRequired(&chain.vIndex[i], chain.consensus);
+        assert(nBitsSum != 0);
+    }
+}
+
+// Total up the network's hammer population over the lifespan window, as getforgeinfo does
+static void ForgeNetworkInfo(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    SyntheticForgeChain chain;
+    BuildSyntheticForgeChain(chain, ForgeChainOptions::FromArgs());
+    ForgeChainContext context(chain);
+
+    while (state.KeepRunning()) {
+        int createdHammers, createdBCTs, readyHammers, readyBCTs;
+        CAmount potentialLifespanRewards;
+        bool fOk = GetNetworkForgeInfo(createdHammers, createdBCTs, readyHammers, readyBCTs, potentialLifespanRewards, chain.consensus);
+        assert(fOk && createdBCTs + readyBCTs > 0);
+    }
+}
+
+BENCHMARK(ForgeProofValidate, 500);
+BENCHMARK(ForgeProofCached, 100000);
+BENCHMARK(ForgeTargetRetarget, 100);
+BENCHMARK(ForgeNetworkInfo, 4000);
@@ -0,0 +1,218 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/forgechain.h>
+
+#include <arith_uint256.h>
+#include <base58.h>
+#include <chainparams.h>
+#include <consensus/merkle.h>
+#include <crypto/common.h>
+#include <hammerhash.h>
+#include <hammerpopindex.h>
+#include <hash.h>
+#include <pow.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <assert.h>
+
+ForgeChainOptions ForgeChainOptions::FromArgs()
+{
+    ForgeChainOptions options;
+    options.nForgeInterval = gArgs.GetArg("-forgeblockinterval", options.nForgeInterval);
+    options.nBCTInterval = gArgs.GetArg("-forgebctinterval", options.nBCTInterval);
+    options.nLifespan = gArgs.GetArg("-forgelifespan", options.nLifespan);
+    return options;
+}
+
+void BuildSyntheticForgeChain(SyntheticForgeChain& chain, const ForgeChainOptions& options)
+{
+    chain.consensus = Params().GetConsensus();
+    Consensus::Params& consensusParams = chain.consensus;
+    if (options.nLifespan > 0)
+        consensusParams.hammerLifespanBlocks = options.nLifespan;
+    // Synthetic blocks never signal, so settle the Forge 1.1 and 1.2 deployments as a synced node has
+    consensusParams.vDeployments[Consensus::DEPLOYMENT_FORGE_1_1].nStartTime = Consensus::BIP9Deployment::ALWAYS_ACTIVE;
+    consensusParams.vDeployments[Consensus::DEPLOYMENT_FORGE_1_2].nStartTime = Consensus::BIP9Deployment::ALWAYS_ACTIVE;
+
+    int nBlocks = options.nBlocks > 0 ? options.nBlocks : consensusParams.hammerGestationBlocks + consensusParams.hammerLifespanBlocks;
+    if (options.nForgeInterval > 0 && (nBlocks - 1) % options.nForgeInterval == options.nForgeInterval - 1)
+        nBlocks++;      // Forge blocks must follow a PoW block
+
+    chain.goldKey.MakeNewKey(true);
+    CScript scriptPubKeyBCF = GetScriptForDestination(DecodeDestination(consensusParams.hammerCreationAddress));
+    CScript scriptPubKeyCF = GetScriptForDestination(DecodeDestination(consensusParams.forgeCommunityAddress));
+    CScript scriptPubKeyGold = GetScriptForDestination(chain.goldKey.GetPubKey().GetID());
+    CScript scriptPubKeyBCT = scriptPubKeyBCF;
+    scriptPubKeyBCT << OP_RETURN << OP_HAMMER;
+    scriptPubKeyBCT += scriptPubKeyGold;
+
+    chain.vHashes.resize(nBlocks);
+    chain.vIndex.resize(nBlocks);
+    chain.vBlockData.resize(nBlocks);
+    chain.vBlocks.resize(nBlocks);
+    chain.vBCTs.clear();
+
+    // End the chain now, so the node doesn't think it's still in initial block download
+    const int64_t nStartTime = GetTime() - (int64_t)nBlocks * consensusParams.nPowTargetSpacing;
+    const unsigned int nBitsPow = UintToArith256(consensusParams.powLimit).GetCompact();
+    const unsigned int nBitsForge = UintToArith256(consensusParams.powLimitForge).GetCompact();
+
+    chain.vPrefixHashes.resize(options.nStartHeight);
+    chain.vPrefix.resize(options.nStartHeight);
+    for (int nHeight = 0; nHeight < options.nStartHeight; nHeight++) {
+        CBlockIndex& index = chain.vPrefix[nHeight];
+        chain.vPrefixHashes[nHeight] = ArithToUint256(arith_uint256(nHeight + 1));
+        index.phashBlock = &chain.vPrefixHashes[nHeight];
+        index.pprev = nHeight > 0 ? &chain.vPrefix[nHeight - 1] : nullptr;
+        index.nHeight = nHeight;
+        index.nTime = nStartTime - (int64_t)(options.nStartHeight - nHeight) * consensusParams.nPowTargetSpacing;
+        index.nBits = nBitsPow;
+        index.nChainWork = nHeight + 1;
+        index.BuildSkip();
+        index.BuildForgeCounters(consensusParams);
+    }
+
+    for (int i = 0; i < nBlocks; i++) {
+        int nHeight = options.nStartHeight + i;
+        bool fForge = options.nForgeInterval > 0 && i % options.nForgeInterval == options.nForgeInterval - 1;
+        CBlock& block = chain.vBlocks[i];
+        block.nTime = nStartTime + (int64_t)i * consensusParams.nPowTargetSpacing;
+        block.nBits = fForge ? nBitsForge : nBitsPow;
+        block.nNonce = fForge ? consensusParams.forgeNonceMarker : i;
+        block.hashPrevBlock = i > 0 ? chain.vHashes[i - 1] : chain.vPrefix.empty() ? uint256() : chain.vPrefixHashes.back();
+
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.vin[0].scriptSig = CScript() << nHeight << OP_0;
+        coinbase.vout.resize(1);
+        coinbase.vout[0].scriptPubKey = scriptPubKeyGold;
+        coinbase.vout[0].nValue = GetBlockSubsidy(nHeight, consensusParams);
+        block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+
+        if (!fForge && options.nBCTInterval > 0 && i % options.nBCTInterval == 0) {
+            CAmount hammerCost = GetHammerCost(nHeight, consensusParams);
+            for (int j = 0; j < 2; j++) {
+                CMutableTransaction bct;
+                bct.vin.resize(1);
+                bct.vin[0].prevout.hash = ArithToUint256(arith_uint256(i * 2 + j + 1));
+                bct.vout.resize(j == 0 ? 1 : 2);
+                bct.vout[0].scriptPubKey = scriptPubKeyBCT;
+                bct.vout[0].nValue = hammerCost * (9 + i % 100) * (j == 0 ? 10 : 9);
+                if (j == 1) {
+                    bct.vout[1].scriptPubKey = scriptPubKeyCF;
+                    bct.vout[1].nValue = bct.vout[0].nValue / 9;
+                }
+                ForgeChainBCT entry = {bct.GetHash(), nHeight, bct.vout[0].nValue + (j == 1 ? bct.vout[1].nValue : 0), j == 1};
+                chain.vBCTs.push_back(entry);
+                block.vtx.push_back(MakeTransactionRef(std::move(bct)));
+            }
+        }
+        block.hashMerkleRoot = BlockMerkleRoot(block);
+
+        chain.vHashes[i] = block.GetHash();
+        CBlockIndex& index = chain.vIndex[i];
+        index = CBlockIndex(block);
+        index.phashBlock = &chain.vHashes[i];
+        index.pprev = i > 0 ? &chain.vIndex[i - 1] : chain.vPrefix.empty() ? nullptr : &chain.vPrefix.back();
+        index.nHeight = nHeight;
+        index.nChainWork = (index.pprev ? index.pprev->nChainWork : arith_uint256()) + 1;
+        index.nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA;
+        index.BuildSkip();
+        index.BuildForgeCounters(consensusParams);
+
+        CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+        ss << block;
+        chain.vBlockData[i].assign(ss.begin(), ss.end());
+    }
+}
+
+bool BuildForgeBlock(const SyntheticForgeChain& chain, const ForgeChainBCT& bct, CBlock& block)
+{
+    const Consensus::Params& consensusParams = chain.consensus;
+    const CBlockIndex* pindexPrev = &chain.vIndex.back();
+
+    CDeterministicRand deterministicRand = GetDeterministicRand(pindexPrev);
+    arith_uint256 hammerHashTarget;
+    hammerHashTarget.SetCompact(GetNextForgeWorkRequired(pindexPrev, consensusParams));
+
+    // Find the first of the BCT's hammers that meets the target, as BusyHammers would
+    const std::string txid = bct.txid.GetHex();
+    const CHammerHasher bctHasher = CHammerHasher(deterministicRand).ForBCT(txid);
+    const uint32_t hammerCount = bct.nValue / GetHammerCost(bct.nHeight, consensusParams);
+    uint32_t hammerNonce = 0;
+    while (hammerNonce < hammerCount && !bctHasher.CheckHash(hammerNonce, hammerHashTarget))
+        hammerNonce++;
+    if (hammerNonce == hammerCount)
+        return false;
+
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << deterministicRand;
+    std::vector<unsigned char> messageProofVec;
+    if (!chain.goldKey.SignCompact(ss.GetHash(), messageProofVec))
+        return false;
+
+    unsigned char hammerNonceEncoded[4];
+    WriteLE32(hammerNonceEncoded, hammerNonce);
+    unsigned char bctHeightEncoded[4];
+    WriteLE32(bctHeightEncoded, bct.nHeight);
+    CScript forgeProofScript;
+    forgeProofScript << OP_RETURN << OP_HAMMER << std::vector<unsigned char>(hammerNonceEncoded, hammerNonceEncoded + 4)
+        << std::vector<unsigned char>(bctHeightEncoded, bctHeightEncoded + 4) << (bct.fCommunityContrib ? OP_TRUE : OP_FALSE)
+        << std::vector<unsigned char>(txid.begin(), txid.end()) << messageProofVec;
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << (pindexPrev->nHeight + 1) << OP_0;
+    coinbase.vout.resize(2);
+    coinbase.vout[0].scriptPubKey = forgeProofScript;
+    coinbase.vout[0].nValue = 0;
+    coinbase.vout[1].scriptPubKey = GetScriptForDestination(chain.goldKey.GetPubKey().GetID());
+    coinbase.vout[1].nValue = GetBlockSubsidy(pindexPrev->nHeight + 1, consensusParams);
+
+    block.SetNull();
+    block.hashPrevBlock = pindexPrev->GetBlockHash();
+    block.nTime = pindexPrev->nTime + consensusParams.nPowTargetSpacing;
+    block.nBits = hammerHashTarget.GetCompact();
+    block.nNonce = consensusParams.forgeNonceMarker;
+    block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    return true;
+}
+
+ForgeChainContext::ForgeChainContext(SyntheticForgeChain& chainIn) : chain(chainIn)
+{
+    LOCK(cs_main);
+    for (CBlockIndex& index : chain.vIndex)
+        mapBlockIndex.emplace(index.GetBlockHash(), &index);
+    chainActive.SetTip(chain.Tip());
+    PublishTipSnapshot();
+
+    coinsBase.reset(new CCoinsView());
+    coinsPrev = std::move(pcoinsTip);
+    pcoinsTip.reset(new CCoinsViewCache(coinsBase.get()));
+    for (size_t i = 0; i < chain.vBlocks.size(); i++)
+        for (size_t j = 1; j < chain.vBlocks[i].vtx.size(); j++)
+            AddCoins(*pcoinsTip, *chain.vBlocks[i].vtx[j], chain.vIndex[i].nHeight);
+
+    hammerPopIndex.Init(chain.consensus);
+    for (size_t i = 0; i < chain.vBlocks.size(); i++)
+        hammerPopIndex.BlockConnected(chain.vBlocks[i], &chain.vIndex[i], chain.consensus, false);
+}
+
+ForgeChainContext::~ForgeChainContext()
+{
+    LOCK(cs_main);
+    hammerPopIndex.Init(chain.consensus);
+    pcoinsTip = std::move(coinsPrev);
+    chainActive.SetTip(nullptr);
+    PublishTipSnapshot();
+    versionbitscache.Clear();       // Keyed by CBlockIndex pointer, and these are about to go
+    for (const CBlockIndex& index : chain.vIndex)
+        mapBlockIndex.erase(index.GetBlockHash());
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BENCH_FORGECHAIN_H
+#define BITCOIN_BENCH_FORGECHAIN_H
+
+#include <chain.h>
+#include <coins.h>
+#include <consensus/params.h>
+#include <key.h>
+#include <primitives/block.h>
+#include <uint256.h>
+
+#include <memory>
+#include <vector>
+
+// Thor: Forge: A synthetic in-memory chain for the Forge benchmarks. Every block gets a
+// CBlockIndex, so the difficulty adjust, hammer population and proof checks see the same
+// shape of chain they would on a node; blocks are kept in memory and never touch disk.
+
+/** Shape of a synthetic Forge chain; the defaults approximate mainnet after the Forge 1.3 fork */
+struct ForgeChainOptions
+{
+    int nStartHeight;       //!< Height of the first block; the heights below it only get a CBlockIndex
+    int nBlocks;            //!< Number of blocks; 0 means one gestation + lifespan window
+    int nForgeInterval;     //!< One block in this many is Forgemined; 0 for none
+    int nBCTInterval;       //!< One PoW block in this many carries a pair of BCTs; 0 for none
+    int nLifespan;          //!< Hammer lifespan in blocks; 0 keeps the chain's own
+
+    ForgeChainOptions() : nStartHeight(200000), nBlocks(0), nForgeInterval(4), nBCTInterval(8), nLifespan(0) {}
+
+    /** Defaults, overridden by -forgeblockinterval, -forgebctinterval and -forgelifespan */
+    static ForgeChainOptions FromArgs();
+};
+
+/** A BCT in the synthetic chain */
+struct ForgeChainBCT
+{
+    uint256 txid;
+    int nHeight;
+    CAmount nValue;             //!< Hammer creation output, plus the donation if there is one
+    bool fCommunityContrib;
+};
+
+struct SyntheticForgeChain
+{
+    Consensus::Params consensus;        //!< The chain's params with the options applied
+    CKey goldKey;                       //!< Owns the gold address every BCT pays to
+    std::vector<uint256> vPrefixHashes;
+    std::vector<CBlockIndex> vPrefix;   //!< PoW headers from genesis up to the first block, so ancestor walks never run out
+    std::vector<uint256> vHashes;
+    std::vector<CBlockIndex> vIndex;
+    std::vector<CBlock> vBlocks;
+    std::vector<std::vector<unsigned char>> vBlockData;    //!< Each block serialized as on disk
+    std::vector<ForgeChainBCT> vBCTs;
+
+    CBlockIndex* Tip() { return &vIndex.back(); }
+};
+
+/** Build a synthetic chain over the selected chain's params. The tip is always a PoW block. */
+void BuildSyntheticForgeChain(SyntheticForgeChain& chain, const ForgeChainOptions& options);
+
+/**
+ * Build a Forge block on the chain tip with a valid proof from the given BCT, which must be
+ * mature at the tip. Returns false if none of the BCT's hammers meet the target.
+ */
+bool BuildForgeBlock(const SyntheticForgeChain& chain, const ForgeChainBCT& bct, CBlock& block);
+
+/**
+ * Install a synthetic chain as the node's active chain for the lifetime of this object: the
+ * block index, chainActive, a UTXO set holding its BCTs, and the hammer population index.
+ */
+class ForgeChainContext
+{
+private:
+    SyntheticForgeChain& chain;
+    std::unique_ptr<CCoinsView> coinsBase;
+    std::unique_ptr<CCoinsViewCache> coinsPrev;
+
+public:
+    explicit ForgeChainContext(SyntheticForgeChain& chainIn);
+    ~ForgeChainContext();
+};
+
+#endif // BITCOIN_BENCH_FORGECHAIN_H
@@ -0,0 +1,56 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <arith_uint256.h>
+#include <hammerhash.h>
+#include <miner.h>
+#include <uint256.h>
+#include <util.h>
+#include <wallet/wallet.h>
+
+#include <boost/thread/thread.hpp>
+
+// Thor: Forge: Sweep a wallet of 1M hammers on the hammer check workers, as BusyHammers does
+// when no hammer meets the target. Run with -forgecheckthreads=<n> to size hardware; the
+// per-iteration time is the time a check takes to cover every hammer.
+
+/* Number of hammers in the simulated wallet */
+static const int HAMMER_COUNT = 1000000;
+
+static void ForgeCheck1M(benchmark::State& state)
+{
+    CDeterministicRand deterministicRand;
+    deterministicRand.nHashes = CDeterministicRand::MAX_HASHES;
+    for (int i = 0; i < deterministicRand.nHashes; i++)
+        deterministicRand.hashes[i] = ArithToUint256(arith_uint256(i + 1) << 200);
+
+    // BCTs of uneven sizes, as a real wallet has
+    std::vector<CHammerRange> ranges;
+    int totalHammers = 0;
+    for (int i = 0; totalHammers < HAMMER_COUNT; i++) {
+        int count = std::min(100 + (i * 7919) % 3900, HAMMER_COUNT - totalHammers);
+        CHammerRange range = {ArithToUint256(arith_uint256(i + 1)).GetHex(), "", false, 0, count};
+        ranges.push_back(range);
+        totalHammers += count;
+    }
+
+    boost::thread_group tg;
+    for (int i = 0; i < GetForgeCheckThreads() - 1; i++)
+        tg.create_thread(&ThreadHammerCheck);
+
+    const arith_uint256 hammerHashTarget;   // Nothing meets a zero target, so every hammer is checked
+    CHammerRange solvingRange;
+    uint32_t solvingHammer;
+    while (state.KeepRunning()) {
+        bool fSolved = CheckHammers(SplitHammerChunks(ranges), deterministicRand, hammerHashTarget, 0, false, solvingRange, solvingHammer);
+        assert(!fSolved);
+    }
+
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+BENCHMARK(ForgeCheck1M, 1);
@@ -0,0 +1,61 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <arith_uint256.h>
+#include <hammerhash.h>
+#include <hash.h>
+#include <uint256.h>
+
+#include <string>
+
+// Thor: Forge: Hash a BCT's worth of hammers the way CheckBin used to (CHashWriter over the
+// full strings, then a hex round trip) and with the midstate-cached hammer hash kernel.
+
+/* Number of hammers to check per iteration */
+static const int HAMMER_COUNT = 1000;
+
+static std::string BenchRandString()
+{
+    std::string deterministicRandString;
+    for (int i = 0; i < 6; i++)
+        deterministicRandString += ArithToUint256(arith_uint256(i + 1) << 200).GetHex();
+    return deterministicRandString;
+}
+
+static void HammerHashWriter(benchmark::State& state)
+{
+    const std::string deterministicRandString = BenchRandString();
+    const std::string txid = ArithToUint256(arith_uint256(0xb0ca)).GetHex();
+    const arith_uint256 hammerHashTarget = arith_uint256(1) << 200;
+    int found = 0;
+    while (state.KeepRunning()) {
+        for (int i = 0; i < HAMMER_COUNT; i++) {
+            std::string hashHex = (CHashWriter(SER_GETHASH, 0) << deterministicRandString << txid << i).GetHash().GetHex();
+            if (arith_uint256(hashHex) < hammerHashTarget)
+                found++;
+        }
+    }
+    assert(found >= 0);
+}
+
+static void HammerHashKernel(benchmark::State& state)
+{
+    const std::string deterministicRandString = BenchRandString();
+    const std::string txid = ArithToUint256(arith_uint256(0xb0ca)).GetHex();
+    const arith_uint256 hammerHashTarget = arith_uint256(1) << 200;
+    int found = 0;
+    while (state.KeepRunning()) {
+        CHammerHasher bctHasher = CHammerHasher(deterministicRandString).ForBCT(txid);
+        for (int i = 0; i < HAMMER_COUNT; i++) {
+            if (bctHasher.CheckHash(i, hammerHashTarget))
+                found++;
+        }
+    }
+    assert(found >= 0);
+}
+
+BENCHMARK(HammerHashWriter, 400);
+BENCHMARK(HammerHashKernel, 2000);
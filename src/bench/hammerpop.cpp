@@ -0,0 +1,72 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/forgechain.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <hammerpopindex.h>
+#include <streams.h>
+
+// Thor: Forge: Compare counting the network hammer population by re-reading
+// every block in the hammer lifespan window (as GetNetworkForgeInfo used to)
+// against summing the per-block entries of the hammer population index.
+//
+// The synthetic chain (see bench/forgechain.h) spans a full lifespan window;
+// by default one block in four is Forgemined and one PoW block in eight
+// carries a pair of BCTs. The scan side deserializes each block from memory,
+// so it excludes the disk I/O and PoW/Forge proof checks the real scan also
+// paid for.
+
+static void HammerPopScan(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    SyntheticForgeChain chain;
+    BuildSyntheticForgeChain(chain, ForgeChainOptions::FromArgs());
+    const Consensus::Params& consensusParams = chain.consensus;
+
+    while (state.KeepRunning()) {
+        int hammers = 0;
+        for (int i = chain.vIndex.size() - 1; i >= 0; i--) {
+            const CBlockIndex* pindex = &chain.vIndex[i];
+            if (pindex->GetBlockHeader().IsForgeMined(consensusParams))
+                continue;
+            const std::vector<unsigned char>& data = chain.vBlockData[i];
+            CDataStream ss(data, SER_DISK, PROTOCOL_VERSION);
+            CBlock block;
+            ss >> block;
+            hammers += CHammerPopIndex::ComputeEntry(block, pindex->nHeight, consensusParams).nHammers;
+        }
+        assert(hammers > 0);
+    }
+}
+
+static void HammerPopIndexLookup(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    SyntheticForgeChain chain;
+    BuildSyntheticForgeChain(chain, ForgeChainOptions::FromArgs());
+    const Consensus::Params& consensusParams = chain.consensus;
+
+    CHammerPopIndex index;
+    index.Init(consensusParams);
+    for (size_t i = 0; i < chain.vBlocks.size(); i++)
+        index.BlockConnected(chain.vBlocks[i], &chain.vIndex[i], consensusParams, false);
+
+    while (state.KeepRunning()) {
+        int hammers = 0;
+        for (int i = chain.vIndex.size() - 1; i >= 0; i--) {
+            const CBlockIndex* pindex = &chain.vIndex[i];
+            CHammerPopEntry entry;
+            bool found = index.GetEntry(pindex, consensusParams, entry);
+            assert(found);
+            hammers += entry.nHammers;
+        }
+        assert(hammers > 0);
+    }
+}
+
+BENCHMARK(HammerPopScan, 5);
+BENCHMARK(HammerPopIndexLookup, 500);
@@ -0,0 +1,113 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chainparams.h>
+#include <hash.h>
+#include <net.h>
+#include <primitives/block.h>
+#include <protocol.h>
+#include <random.h>
+#include <streams.h>
+#include <version.h>
+
+#include <assert.h>
+
+// Thor: The receive path from socket bytes to blocks and transactions: framing, the message
+// buffers, and deserializing straight from them. The wire holds a block and then each of its
+// transactions as tx messages. NetRecvCopy passes every read through the socket handler's own
+// buffer; NetRecvInPlace reads large message bodies straight into their buffers, as the socket
+// handler does.
+
+/* Number of transactions in the block */
+static const int TX_COUNT = 2000;
+
+static void PushMessage(CDataStream& wire, const char* pszCommand, const CDataStream& payload)
+{
+    CMessageHeader hdr(Params().MessageStart(), pszCommand, payload.size());
+    uint256 hash = Hash(payload.begin(), payload.end());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+    wire << hdr;
+    wire.write(payload.data(), payload.size());
+}
+
+static void BuildWire(CDataStream& wire)
+{
+    FastRandomContext rand(true);
+    CBlock block;
+    for (int i = 0; i < TX_COUNT; i++) {
+        // One P2PKH input, two P2PKH outputs
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(rand.rand256(), i);
+        tx.vin[0].scriptSig = CScript() << rand.randbytes(72) << rand.randbytes(33);
+        tx.vout.resize(2);
+        for (CTxOut& txout : tx.vout) {
+            txout.scriptPubKey = CScript() << OP_DUP << OP_HASH160 << rand.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG;
+            txout.nValue = rand.randrange(COIN);
+        }
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+    }
+
+    PushMessage(wire, NetMsgType::BLOCK, CDataStream(SER_NETWORK, PROTOCOL_VERSION, block));
+    for (const CTransactionRef& tx : block.vtx)
+        PushMessage(wire, NetMsgType::TX, CDataStream(SER_NETWORK, PROTOCOL_VERSION, tx));
+}
+
+static void NetRecv(benchmark::State& state, bool fInPlace)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    CDataStream wire(SER_NETWORK, PROTOCOL_VERSION);
+    BuildWire(wire);
+
+    CNode node(0, NODE_NETWORK, 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", false);
+    char pchBuf[0x10000];
+    while (state.KeepRunning()) {
+        size_t nPos = 0;
+        while (nPos < wire.size()) {
+            unsigned int nBytes = 0;
+            char* pch = fInPlace ? node.GetRecvBuffer(nBytes) : nullptr;
+            if (!pch) {
+                pch = pchBuf;
+                nBytes = sizeof(pchBuf);
+            }
+            nBytes = std::min<size_t>(nBytes, wire.size() - nPos);
+            memcpy(pch, &wire[nPos], nBytes);   // as recv() would
+            nPos += nBytes;
+
+            bool complete = false;
+            bool fOk = node.ReceiveMsgBytes(pch, nBytes, complete);
+            assert(fOk);
+            if (!complete)
+                continue;
+
+            std::list<CNetMessage> msgs;
+            node.TakeCompleteMessages(msgs);
+            for (CNetMessage& msg : msgs) {
+                if (msg.hdr.GetCommand() == NetMsgType::BLOCK) {
+                    CBlock block;
+                    msg.vRecv >> block;
+                    assert(block.vtx.size() == TX_COUNT);
+                } else {
+                    CTransactionRef tx;
+                    msg.vRecv >> tx;
+                }
+            }
+        }
+    }
+}
+
+static void NetRecvCopy(benchmark::State& state)
+{
+    NetRecv(state, false);
+}
+
+static void NetRecvInPlace(benchmark::State& state)
+{
+    NetRecv(state, true);
+}
+
+BENCHMARK(NetRecvCopy, 50);
+BENCHMARK(NetRecvInPlace, 50);
@@ -0,0 +1,42 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <crypto/scrypt.h>
+#include <primitives/block.h>
+
+// Thor: Scrypt PoW hashing of a batch of headers at each multi-lane kernel width.
+// Every iteration hashes SCRYPT_BENCH_HEADERS headers, so headers/second is
+// SCRYPT_BENCH_HEADERS divided by the reported time per iteration. Widths above
+// scrypt_multi_lanes() fall back to the widest kernel the CPU supports.
+
+static const size_t SCRYPT_BENCH_HEADERS = 64;
+
+static void ScryptHeaders(benchmark::State& state, int lanes)
+{
+    (void) scrypt_detect_multi();
+    std::vector<CBlockHeader> headers(SCRYPT_BENCH_HEADERS);
+    std::vector<const CBlockHeader*> vHeaders;
+    for (size_t i = 0; i < headers.size(); i++) {
+        headers[i].nVersion = 0x20000000;
+        headers[i].nTime = 1585891944 + i;
+        headers[i].nBits = 0x1e0ffff0;
+        headers[i].nNonce = i;
+        vHeaders.push_back(&headers[i]);
+    }
+    std::vector<uint256> hashes;
+    while (state.KeepRunning()) {
+        GetPoWHashes(vHeaders, hashes, lanes);
+        headers[0].nNonce++;
+    }
+}
+
+static void ScryptHeaders_1way(benchmark::State& state) { ScryptHeaders(state, 1); }
+static void ScryptHeaders_4way(benchmark::State& state) { ScryptHeaders(state, 4); }
+static void ScryptHeaders_8way(benchmark::State& state) { ScryptHeaders(state, 8); }
+
+BENCHMARK(ScryptHeaders_1way, 16);
+BENCHMARK(ScryptHeaders_4way, 16);
+BENCHMARK(ScryptHeaders_8way, 16);
@@ -122,6 +122,17 @@ void CBlockIndex::BuildSkip()
         pskip = pprev->GetAncestor(GetSkipHeight(nHeight));
 }
 
+void CBlockIndex::BuildForgeCounters(const Consensus::Params& consensusParams)
+{
+    bool fForge = IsForgeMined(consensusParams);
+    nForgeBlocksAtTip = fForge ? (pprev ? pprev->nForgeBlocksAtTip : 0) + 1 : 0;
+    nPoWBlocksAtTip = fForge ? 0 : (pprev ? pprev->nPoWBlocksAtTip : 0) + 1;
+    nChainForgeBlocks = (pprev ? pprev->nChainForgeBlocks : 0) + (fForge ? 1 : 0);
+    nChainForgeTarget = pprev ? pprev->nChainForgeTarget : arith_uint256();
+    if (fForge)
+        nChainForgeTarget += arith_uint256().SetCompact(nBits);
+}
+
 // Thor: Forge: Grant forge-mined blocks bonus work value - they get the work value of
 // their own block plus that of the PoW block behind them
 arith_uint256 GetBlockProof(const CBlockIndex& block)
@@ -143,15 +154,13 @@ arith_uint256 GetBlockProof(const CBlockIndex& block)
     // or ~bnTarget / (bnTarget+1) + 1.
     arith_uint256 bnTargetScaled = (~bnTarget / (bnTarget + 1)) + 1;
 
-    if (block.GetBlockHeader().IsForgeMined(consensusParams)) {
+    if (block.IsForgeMined(consensusParams)) {
         assert(block.pprev);
 
         // LitecoinCash: Hive 1.1: Set bnPreviousTarget from nBits in most recent pow block, not just assuming it's one back. Note this logic is still valid for Hive 1.0 so doesn't need to be gated.
-        CBlockIndex* pindexTemp = block.pprev;
-        while (pindexTemp->GetBlockHeader().IsForgeMined(consensusParams)) {
-            assert(pindexTemp->pprev);
-            pindexTemp = pindexTemp->pprev;
-        }
+        // Thor: Forge: The Forge counters tell us how many Forge blocks to skip
+        const CBlockIndex* pindexTemp = block.pprev->GetAncestor(block.pprev->nHeight - block.pprev->nForgeBlocksAtTip);
+        assert(pindexTemp);
 
         arith_uint256 bnPreviousTarget;
         bnPreviousTarget.SetCompact(pindexTemp->nBits, &fNegative, &fOverflow);
@@ -196,19 +205,14 @@ arith_uint256 GetBlockProof(const CBlockIndex& block)
 	}
 
         // Find last forge block
-        CBlockIndex *currBlock = block.pprev;
-        int blocksSinceForge;
+        int blocksSinceForge = std::min(block.pprev->nPoWBlocksAtTip, consensusParams.maxKPow);
         double lastForgeDifficulty = 0;
 
-        for (blocksSinceForge = 0; blocksSinceForge < consensusParams.maxKPow; blocksSinceForge++) {
-            if (currBlock->GetBlockHeader().IsForgeMined(consensusParams)) {
-                lastForgeDifficulty = GetDifficulty(currBlock, true);
-                if (verbose) LogPrintf("**** Got last Forge diff = %.12f, at %s\n", lastForgeDifficulty, currBlock->GetBlockHash().ToString());
-                break;
-            }
-
-            assert(currBlock->pprev);
-            currBlock = currBlock->pprev;
+        if (blocksSinceForge < consensusParams.maxKPow) {
+            const CBlockIndex* currBlock = block.pprev->GetAncestor(block.pprev->nHeight - blocksSinceForge);
+            assert(currBlock);
+            lastForgeDifficulty = GetDifficulty(currBlock, true);
+            if (verbose) LogPrintf("**** Got last Forge diff = %.12f, at %s\n", lastForgeDifficulty, currBlock->GetBlockHash().ToString());
         }
 
         if (verbose) LogPrintf("**** Pow blocks since last Forge block = %d\n", blocksSinceForge);
@@ -232,19 +236,13 @@ arith_uint256 GetBlockProof(const CBlockIndex& block)
 
     } else if (IsForge12Enabled(&block, consensusParams)) {
 
-        CBlockIndex *currBlock = block.pprev;
-        int blocksSinceForge;
+        int blocksSinceForge = std::min(block.pprev->nPoWBlocksAtTip, consensusParams.maxKPow);
         double lastForgeDifficulty = 0;
 
-        for (blocksSinceForge = 0; blocksSinceForge < consensusParams.maxKPow; blocksSinceForge++) {
-            if (currBlock->GetBlockHeader().IsForgeMined(consensusParams)) {
-                lastForgeDifficulty = GetDifficulty(currBlock, true);
-
-                break;
-            }
-
-            assert(currBlock->pprev);
-            currBlock = currBlock->pprev;
+        if (blocksSinceForge < consensusParams.maxKPow) {
+            const CBlockIndex* currBlock = block.pprev->GetAncestor(block.pprev->nHeight - blocksSinceForge);
+            assert(currBlock);
+            lastForgeDifficulty = GetDifficulty(currBlock, true);
         }
 
         unsigned int k = consensusParams.maxKPow - blocksSinceForge;
@@ -271,7 +269,7 @@ arith_uint256 GetNumHashes(const CBlockIndex& block)
     bool fOverflow;
 
     bnTarget.SetCompact(block.nBits, &fNegative, &fOverflow);
-    if (fNegative || fOverflow || bnTarget == 0 || block.GetBlockHeader().IsForgeMined(Params().GetConsensus()))
+    if (fNegative || fOverflow || bnTarget == 0 || block.IsForgeMined(Params().GetConsensus()))
         return 0;
 
     // We need to compute 2**256 / (bnTarget+1), but we can't represent 2**256
@@ -160,6 +160,8 @@ enum BlockStatus: uint32_t {
     BLOCK_FAILED_MASK        =   BLOCK_FAILED_VALID | BLOCK_FAILED_CHILD,
 
     BLOCK_OPT_WITNESS       =   128, //!< block data in blk*.data was received with a witness-enforcing client
+
+    BLOCK_POW_VERIFIED       =   256, //!< Thor: scrypt PoW of the header checked against nBits (PoW blocks above SKIP_BLOCKHEADER_POW only)
 };
 
 /** The block chain is a tree shaped structure starting with the
@@ -219,6 +221,18 @@ public:
     //! (memory only) Maximum nTime in the chain up to and including this block.
     unsigned int nTimeMax;
 
+    //! (memory only) Thor: Forge: Number of consecutive Forge blocks ending at this block (0 for a PoW block)
+    int nForgeBlocksAtTip;
+
+    //! (memory only) Thor: Forge: Number of consecutive PoW blocks ending at this block (0 for a Forge block)
+    int nPoWBlocksAtTip;
+
+    //! (memory only) Thor: Forge: Number of Forge blocks in the chain up to and including this block
+    int nChainForgeBlocks;
+
+    //! (memory only) Thor: Forge: Sum (mod 2^256) of the Forge block targets in the chain up to and including this block
+    arith_uint256 nChainForgeTarget;
+
     void SetNull()
     {
         phashBlock = nullptr;
@@ -234,6 +248,10 @@ public:
         nStatus = 0;
         nSequenceId = 0;
         nTimeMax = 0;
+        nForgeBlocksAtTip = 0;
+        nPoWBlocksAtTip = 0;
+        nChainForgeBlocks = 0;
+        nChainForgeTarget = arith_uint256();
 
         nVersion       = 0;
         hashMerkleRoot = uint256();
@@ -299,6 +317,12 @@ public:
         return GetBlockHeader().GetPoWHash();
     }
 
+    // Thor: Forge: Check if this block is forgemined, without building the header
+    bool IsForgeMined(const Consensus::Params& consensusParams) const
+    {
+        return nNonce == consensusParams.forgeNonceMarker;
+    }
+
     int64_t GetBlockTime() const
     {
         return (int64_t)nTime;
@@ -359,6 +383,9 @@ public:
     //! Build the skiplist pointer for this entry.
     void BuildSkip();
 
+    //! Thor: Forge: Derive the Forge counters of this entry from its predecessor's.
+    void BuildForgeCounters(const Consensus::Params& consensusParams);
+
     //! Efficiently find an ancestor of this block.
     CBlockIndex* GetAncestor(int height);
     const CBlockIndex* GetAncestor(int height) const;
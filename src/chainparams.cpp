@@ -11,6 +11,7 @@
 #include <util.h>
 #include <utilstrencodings.h>
 #include <base58.h> // Thor: Needed for DecodeDestination()
+#include <subsidy.h> // Thor: Needed for BuildSubsidySchedule()
 
 #include <assert.h>
 
@@ -136,6 +137,8 @@ public:
         consensus.forgeBlockSpacingTargetTypical_1_1 = 2;
         consensus.forgeNonceMarker = 192;                    // Nonce marker for forgemined blocks
 
+        BuildSubsidySchedule(consensus);                     // Thor: Precompute subsidy and hammer cost per height range
+
         // Thor: Forge 1.1-related consensus fields
         consensus.minK = 2;                                 // Minimum chainwork scale for Forge blocks (see Forge whitepaper section 5)
         consensus.maxK = 16;                                 // Maximum chainwork scale for Forge blocks (see Forge whitepaper section 5)
@@ -282,6 +285,8 @@ public:
         consensus.forgeBlockSpacingTargetTypical_1_1 = 2;
         consensus.forgeNonceMarker = 192;                    // Nonce marker for forgemined blocks
 
+        BuildSubsidySchedule(consensus);                     // Thor: Precompute subsidy and hammer cost per height range
+
         // Thor: Forge 1.1-related consensus fields
         consensus.minK = 1;                                 // Minimum chainwork scale for Forge blocks (see Forge whitepaper section 5)
         consensus.maxK = 7;                                 // Maximum chainwork scale for Forge blocks (see Forge whitepaper section 5)
@@ -381,6 +386,7 @@ public:
         consensus.slowStartBlocks = 0;                     // Scale post-fork block reward up over this many blocks
 
         consensus.totalMoneySupplyHeight = 7560000;
+        // Thor: hammerCostFactor is not set for regtest, so no subsidy schedule is built; GetBlockSubsidy() computes per height
 
         consensus.forgeNonceMarker = 192;
 
@@ -8,6 +8,7 @@
 #include <sync.h>
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 #include <boost/thread/condition_variable.hpp>
@@ -62,8 +63,12 @@ private:
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
+    //! Thor: Worker threads started so far, and how many of them may take work; the rest wait
+    int nWorkers;
+    int nMaxWorkers;
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster = false)
+    bool Loop(bool fMaster = false, int nWorker = 0)
     {
         boost::condition_variable& cond = fMaster ? condMaster : condWorker;
         std::vector<T> vChecks;
@@ -85,7 +90,7 @@ private:
                     nTotal++;
                 }
                 // logically, the do loop starts here
-                while (queue.empty()) {
+                while (queue.empty() || (!fMaster && nWorker >= nMaxWorkers)) {
                     if (fMaster && nTodo == 0) {
                         nTotal--;
                         bool fRet = fAllOk;
@@ -95,9 +100,13 @@ private:
                         // return the current status
                         return fRet;
                     }
-                    nIdle++;
+                    // Thor: Parked workers don't count as idle ones about to help
+                    const bool fParked = !fMaster && nWorker >= nMaxWorkers;
+                    if (!fParked)
+                        nIdle++;
                     cond.wait(lock); // wait
-                    nIdle--;
+                    if (!fParked)
+                        nIdle--;
                 }
                 // Decide how many work units to process now.
                 // * Do not try to do everything at once, but aim for increasingly smaller batches so
@@ -128,12 +137,27 @@ public:
     boost::mutex ControlMutex;
 
     //! Create a new check queue
-    explicit CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), nBatchSize(nBatchSizeIn) {}
+    explicit CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), nBatchSize(nBatchSizeIn), nWorkers(0), nMaxWorkers(std::numeric_limits<int>::max()) {}
 
     //! Worker thread
     void Thread()
     {
-        Loop();
+        int nWorker;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            nWorker = nWorkers++;
+        }
+        Loop(false, nWorker);
+    }
+
+    //! Thor: Let only the first nMaxWorkersIn worker threads take work; the others wait until allowed again
+    void SetMaxWorkers(int nMaxWorkersIn)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (nMaxWorkersIn == nMaxWorkers)
+            return;
+        nMaxWorkers = nMaxWorkersIn;
+        condWorker.notify_all();
     }
 
     //! Wait until execution finishes, and return whether all evaluations were successful.
@@ -151,8 +175,10 @@ public:
             check.swap(queue.back());
         }
         nTodo += vChecks.size();
-        if (vChecks.size() == 1)
+        if (vChecks.size() == 1 && nWorkers <= nMaxWorkers)
             condWorker.notify_one();
+        else if (vChecks.size() == 1)
+            condWorker.notify_all();    // Thor: notify_one could wake a parked worker
         else if (vChecks.size() > 1)
             condWorker.notify_all();
     }
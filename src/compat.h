@@ -86,8 +86,17 @@ typedef int32_t ssize_t;
 size_t strnlen( const char *start, size_t max_len);
 #endif // HAVE_DECL_STRNLEN
 
+// Thor: Wait on sockets with poll(), and on Linux with epoll, so they aren't limited to FD_SETSIZE.
+// Windows keeps select(), whose fd_set there is a list of sockets rather than a bitmap.
+#ifndef WIN32
+#define USE_POLL
+#if defined(__linux__)
+#define USE_EPOLL
+#endif
+#endif
+
 bool static inline IsSelectableSocket(const SOCKET& s) {
-#ifdef WIN32
+#if defined(WIN32) || defined(USE_POLL)
     return true;
 #else
     return (s < FD_SETSIZE);
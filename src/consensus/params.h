@@ -10,6 +10,7 @@
 #include <limits>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <script/script.h>  // Thor: Needed for CScript
 #include <amount.h>         // Thor: Needed for CAmount
@@ -49,6 +50,16 @@ struct BIP9Deployment {
     static constexpr int64_t ALWAYS_ACTIVE = -1;
 };
 
+/**
+ * Thor: One step of the emission schedule. The subsidy and hammer cost hold from
+ * nHeight up to the next entry's height.
+ */
+struct SubsidyScheduleEntry {
+    int nHeight;
+    CAmount nSubsidy;
+    CAmount nHammerCost;
+};
+
 /**
  * Parameters that influence chain consensus.
  */
@@ -121,6 +132,9 @@ struct Params {
     int maxConsecutiveForgeBlocks;       // Maximum hive blocks that can occur consecutively before a PoW block is required
     int forgeDifficultyWindow;           // How many blocks the SMA averages over in hive difficulty adjust
     int forgeDifficultyWindow2; 
+
+    // Thor: Emission schedule precomputed from the fields above by BuildSubsidySchedule(); empty means compute per height
+    std::vector<SubsidyScheduleEntry> subsidySchedule;
 };
 } // namespace Consensus
 
@@ -27,6 +27,10 @@
  * online backup system.
  */
 
+#if defined(HAVE_CONFIG_H)
+#include "config/bitcoin-config.h"
+#endif
+
 #include "crypto/scrypt.h"
 //#include "util.h"
 #include <stdlib.h>
@@ -34,7 +38,7 @@
 #include <string.h>
 #include <openssl/sha.h>
 
-#if defined(USE_SSE2) && !defined(USE_SSE2_ALWAYS)
+#if (defined(USE_SSE2) && !defined(USE_SSE2_ALWAYS)) || (defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL))
 #ifdef _MSC_VER
 // MSVC 64bit is unable to use inline asm
 #include <intrin.h>
@@ -330,3 +334,80 @@ void scrypt_1024_1_1_256(const char *input, char *output)
 	char scratchpad[SCRYPT_SCRATCHPAD_SIZE];
     scrypt_1024_1_1_256_sp(input, output, scratchpad);
 }
+
+// Thor: Multi-lane scrypt kernels, for hashing many headers at once
+#if defined(__SSE2__)
+namespace scrypt_sse2_4way
+{
+void scrypt_1024_1_1_256_sp_4way(const char *const *input, char *const *output, char *scratchpad);
+}
+#endif
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+namespace scrypt_avx2_8way
+{
+void scrypt_1024_1_1_256_sp_8way(const char *const *input, char *const *output, char *scratchpad);
+}
+#endif
+
+#if defined(__SSE2__)
+static int nMultiLanes = 4;
+#else
+static int nMultiLanes = 1;
+#endif
+
+int scrypt_multi_lanes()
+{
+	return nMultiLanes;
+}
+
+std::string scrypt_detect_multi()
+{
+#if defined(__SSE2__)
+	nMultiLanes = 4;
+	std::string ret = "scrypt: using sse2(4way)";
+#else
+	nMultiLanes = 1;
+	std::string ret = "scrypt: using no";
+#endif
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+	uint32_t eax, ebx, ecx, edx;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && ((ecx >> 27) & 1) && ((ecx >> 28) & 1) && __get_cpuid_max(0, nullptr) >= 7) {
+		uint32_t xcr0_lo, xcr0_hi;
+		__asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+		if ((xcr0_lo & 6) == 6 && ((ebx >> 5) & 1)) {
+			nMultiLanes = 8;
+			ret += ",avx2(8way)";
+		}
+	}
+#endif
+	return ret + " multi-lane kernels";
+}
+
+void scrypt_1024_1_1_256_multi(const char *const *input, char *const *output, size_t count, int maxLanes)
+{
+	int lanes = nMultiLanes;
+	if (maxLanes > 0 && maxLanes < lanes)
+		lanes = maxLanes;
+
+	char *scratchpad = (char *)malloc((size_t)lanes * 131072 + 63);
+	if (!scratchpad) {
+		for (size_t i = 0; i < count; i++)
+			scrypt_1024_1_1_256(input[i], output[i]);
+		return;
+	}
+
+	size_t i = 0;
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+	for (; lanes >= 8 && count - i >= 8; i += 8)
+		scrypt_avx2_8way::scrypt_1024_1_1_256_sp_8way(input + i, output + i, scratchpad);
+#endif
+#if defined(__SSE2__)
+	for (; lanes >= 4 && count - i >= 4; i += 4)
+		scrypt_sse2_4way::scrypt_1024_1_1_256_sp_4way(input + i, output + i, scratchpad);
+#endif
+	for (; i < count; i++)
+		scrypt_1024_1_1_256_sp(input[i], output[i], scratchpad);
+
+	free(scratchpad);
+}
@@ -2,12 +2,22 @@
 #define SCRYPT_H
 #include <stdlib.h>
 #include <stdint.h>
+#include <string>
 
 static const int SCRYPT_SCRATCHPAD_SIZE = 131072 + 63;
 
 void scrypt_1024_1_1_256(const char *input, char *output);
 void scrypt_1024_1_1_256_sp_generic(const char *input, char *output, char *scratchpad);
 
+/** Scrypt(1024,1,1,256) of count independent 80-byte inputs. Runs of inputs are hashed
+ *  together by interleaved 4/8-lane kernels, never wider than maxLanes (0 = widest
+ *  kernel selected by scrypt_detect_multi). */
+void scrypt_1024_1_1_256_multi(const char *const *input, char *const *output, size_t count, int maxLanes = 0);
+/** Width of the widest multi-lane kernel in use. */
+int scrypt_multi_lanes();
+/** Select the widest multi-lane scrypt kernel this CPU supports. */
+std::string scrypt_detect_multi();
+
 #if defined(USE_SSE2)
 #include <string>
 #if defined(_M_X64) || defined(__x86_64__) || defined(_M_AMD64) || (defined(MAC_OSX) && defined(__i386__))
@@ -0,0 +1,97 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// 8-way scrypt(1024,1,1,256) using AVX2 intrinsics. Same lane layout as the
+// SSE2 4-way kernel; scratchpad reads use a gather per state word.
+
+#ifdef ENABLE_AVX2
+
+#include <crypto/scrypt.h>
+
+#include <string.h>
+
+#include <immintrin.h>
+
+namespace scrypt_avx2_8way {
+namespace {
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+template<int n> __m256i inline Rotl(__m256i x) { return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n)); }
+
+#define QUARTER(a, b, c, d) \
+    b = Xor(b, Rotl<7>(Add(a, d))); \
+    c = Xor(c, Rotl<9>(Add(b, a))); \
+    d = Xor(d, Rotl<13>(Add(c, b))); \
+    a = Xor(a, Rotl<18>(Add(d, c)));
+
+void inline xor_salsa8(__m256i B[16], const __m256i Bx[16])
+{
+    __m256i x[16];
+    for (int i = 0; i < 16; i++)
+        x[i] = B[i] = Xor(B[i], Bx[i]);
+    for (int i = 0; i < 8; i += 2) {
+        /* Operate on columns. */
+        QUARTER(x[ 0], x[ 4], x[ 8], x[12]);
+        QUARTER(x[ 5], x[ 9], x[13], x[ 1]);
+        QUARTER(x[10], x[14], x[ 2], x[ 6]);
+        QUARTER(x[15], x[ 3], x[ 7], x[11]);
+        /* Operate on rows. */
+        QUARTER(x[ 0], x[ 1], x[ 2], x[ 3]);
+        QUARTER(x[ 5], x[ 6], x[ 7], x[ 4]);
+        QUARTER(x[10], x[11], x[ 8], x[ 9]);
+        QUARTER(x[15], x[12], x[13], x[14]);
+    }
+    for (int i = 0; i < 16; i++)
+        B[i] = Add(B[i], x[i]);
+}
+
+#undef QUARTER
+
+} // namespace
+
+void scrypt_1024_1_1_256_sp_8way(const char *const *input, char *const *output, char *scratchpad)
+{
+    uint8_t B[8][128];
+    alignas(32) uint32_t W[32][8];
+    __m256i X[32];
+    __m256i *V = (__m256i *)(((uintptr_t)(scratchpad) + 63) & ~ (uintptr_t)(63));
+    const int *Vw = (const int *)V;
+    const __m256i lane = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m256i mask = _mm256_set1_epi32(1023);
+
+    for (int l = 0; l < 8; l++) {
+        PBKDF2_SHA256((const uint8_t *)input[l], 80, (const uint8_t *)input[l], 80, 1, B[l], 128);
+        for (int k = 0; k < 32; k++)
+            W[k][l] = le32dec(&B[l][4 * k]);
+    }
+    for (int k = 0; k < 32; k++)
+        X[k] = _mm256_load_si256((const __m256i *)W[k]);
+
+    for (uint32_t i = 0; i < 1024; i++) {
+        memcpy(&V[i * 32], X, sizeof(X));
+        xor_salsa8(&X[0], &X[16]);
+        xor_salsa8(&X[16], &X[0]);
+    }
+    for (uint32_t i = 0; i < 1024; i++) {
+        // Word k of lane l lives at element (j * 32 + k) * 8 + l.
+        __m256i idx = Add(_mm256_slli_epi32(_mm256_and_si256(X[16], mask), 8), lane);
+        for (int k = 0; k < 32; k++)
+            X[k] = Xor(X[k], _mm256_i32gather_epi32(Vw + k * 8, idx, 4));
+        xor_salsa8(&X[0], &X[16]);
+        xor_salsa8(&X[16], &X[0]);
+    }
+
+    for (int k = 0; k < 32; k++)
+        _mm256_store_si256((__m256i *)W[k], X[k]);
+    for (int l = 0; l < 8; l++) {
+        for (int k = 0; k < 32; k++)
+            le32enc(&B[l][4 * k], W[k][l]);
+        PBKDF2_SHA256((const uint8_t *)input[l], 80, B[l], 128, 1, (uint8_t *)output[l], 32);
+    }
+}
+
+} // namespace scrypt_avx2_8way
+
+#endif
@@ -0,0 +1,98 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// 4-way scrypt(1024,1,1,256) using SSE2 intrinsics. Each __m128i holds the same
+// salsa20/8 state word of four independent hashes, so the salsa rounds need no
+// shuffles and the four scratchpad walks hide each other's memory latency.
+
+#if defined(__SSE2__)
+
+#include <crypto/scrypt.h>
+
+#include <string.h>
+
+#include <emmintrin.h>
+
+namespace scrypt_sse2_4way {
+namespace {
+
+__m128i inline Add(__m128i x, __m128i y) { return _mm_add_epi32(x, y); }
+__m128i inline Xor(__m128i x, __m128i y) { return _mm_xor_si128(x, y); }
+template<int n> __m128i inline Rotl(__m128i x) { return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n)); }
+
+#define QUARTER(a, b, c, d) \
+    b = Xor(b, Rotl<7>(Add(a, d))); \
+    c = Xor(c, Rotl<9>(Add(b, a))); \
+    d = Xor(d, Rotl<13>(Add(c, b))); \
+    a = Xor(a, Rotl<18>(Add(d, c)));
+
+void inline xor_salsa8(__m128i B[16], const __m128i Bx[16])
+{
+    __m128i x[16];
+    for (int i = 0; i < 16; i++)
+        x[i] = B[i] = Xor(B[i], Bx[i]);
+    for (int i = 0; i < 8; i += 2) {
+        /* Operate on columns. */
+        QUARTER(x[ 0], x[ 4], x[ 8], x[12]);
+        QUARTER(x[ 5], x[ 9], x[13], x[ 1]);
+        QUARTER(x[10], x[14], x[ 2], x[ 6]);
+        QUARTER(x[15], x[ 3], x[ 7], x[11]);
+        /* Operate on rows. */
+        QUARTER(x[ 0], x[ 1], x[ 2], x[ 3]);
+        QUARTER(x[ 5], x[ 6], x[ 7], x[ 4]);
+        QUARTER(x[10], x[11], x[ 8], x[ 9]);
+        QUARTER(x[15], x[12], x[13], x[14]);
+    }
+    for (int i = 0; i < 16; i++)
+        B[i] = Add(B[i], x[i]);
+}
+
+#undef QUARTER
+
+} // namespace
+
+void scrypt_1024_1_1_256_sp_4way(const char *const *input, char *const *output, char *scratchpad)
+{
+    uint8_t B[4][128];
+    alignas(16) uint32_t W[32][4];
+    __m128i X[32];
+    __m128i *V = (__m128i *)(((uintptr_t)(scratchpad) + 63) & ~ (uintptr_t)(63));
+    const uint32_t *Vw = (const uint32_t *)V;
+
+    for (int l = 0; l < 4; l++) {
+        PBKDF2_SHA256((const uint8_t *)input[l], 80, (const uint8_t *)input[l], 80, 1, B[l], 128);
+        for (int k = 0; k < 32; k++)
+            W[k][l] = le32dec(&B[l][4 * k]);
+    }
+    for (int k = 0; k < 32; k++)
+        X[k] = _mm_load_si128((const __m128i *)W[k]);
+
+    for (uint32_t i = 0; i < 1024; i++) {
+        memcpy(&V[i * 32], X, sizeof(X));
+        xor_salsa8(&X[0], &X[16]);
+        xor_salsa8(&X[16], &X[0]);
+    }
+    for (uint32_t i = 0; i < 1024; i++) {
+        alignas(16) uint32_t j[4];
+        _mm_store_si128((__m128i *)j, X[16]);
+        for (int l = 0; l < 4; l++)
+            j[l] = (j[l] & 1023) * 32 * 4 + l;
+        for (int k = 0; k < 32; k++)
+            X[k] = Xor(X[k], _mm_set_epi32(Vw[j[3] + k * 4], Vw[j[2] + k * 4], Vw[j[1] + k * 4], Vw[j[0] + k * 4]));
+        xor_salsa8(&X[0], &X[16]);
+        xor_salsa8(&X[16], &X[0]);
+    }
+
+    for (int k = 0; k < 32; k++)
+        _mm_store_si128((__m128i *)W[k], X[k]);
+    for (int l = 0; l < 4; l++) {
+        for (int k = 0; k < 32; k++)
+            le32enc(&B[l][4 * k], W[k][l]);
+        PBKDF2_SHA256((const uint8_t *)input[l], 80, B[l], 128, 1, (uint8_t *)output[l], 32);
+    }
+}
+
+} // namespace scrypt_sse2_4way
+
+#endif
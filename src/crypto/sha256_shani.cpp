@@ -0,0 +1,186 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// SHA-256 using the Intel SHA extensions (SHA-NI), following the structure of
+// Intel's reference code: the state is kept as ABEF/CDGH register pairs and
+// each _mm_sha256rnds2_epu32 performs two rounds.
+
+#ifdef ENABLE_SHANI
+
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace {
+
+alignas(16) const uint32_t K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+alignas(16) const uint32_t INIT[8] = {0x6a09e667ul, 0xbb67ae85ul, 0x3c6ef372ul, 0xa54ff53aul, 0x510e527ful, 0x9b05688cul, 0x1f83d9abul, 0x5be0cd19ul};
+
+/** Byte order mask turning big-endian words into native ones (and back) */
+const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+
+/** Four rounds, using message words m and round constants k[0..3] */
+void inline __attribute__((always_inline)) QuadRound(__m128i& state0, __m128i& state1, __m128i m, const uint32_t* k)
+{
+    const __m128i msg = _mm_add_epi32(m, _mm_load_si128((const __m128i*)k));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0e));
+}
+
+void inline __attribute__((always_inline)) ShiftMessageA(__m128i& m0, __m128i m1)
+{
+    m0 = _mm_sha256msg1_epu32(m0, m1);
+}
+
+void inline __attribute__((always_inline)) ShiftMessageC(__m128i& m0, __m128i m1, __m128i& m2)
+{
+    m2 = _mm_sha256msg2_epu32(_mm_add_epi32(m2, _mm_alignr_epi8(m1, m0, 4)), m1);
+}
+
+void inline __attribute__((always_inline)) ShiftMessageB(__m128i& m0, __m128i m1, __m128i& m2)
+{
+    ShiftMessageC(m0, m1, m2);
+    ShiftMessageA(m0, m1);
+}
+
+/** Convert ABCD/EFGH state words to the ABEF/CDGH layout used by the SHA instructions */
+void inline __attribute__((always_inline)) Shuffle(__m128i& s0, __m128i& s1)
+{
+    const __m128i t1 = _mm_shuffle_epi32(s0, 0xB1);
+    const __m128i t2 = _mm_shuffle_epi32(s1, 0x1B);
+    s0 = _mm_alignr_epi8(t1, t2, 0x08);
+    s1 = _mm_blend_epi16(t2, t1, 0xF0);
+}
+
+/** Inverse of Shuffle */
+void inline __attribute__((always_inline)) Unshuffle(__m128i& s0, __m128i& s1)
+{
+    const __m128i t1 = _mm_shuffle_epi32(s0, 0x1B);
+    const __m128i t2 = _mm_shuffle_epi32(s1, 0xB1);
+    s0 = _mm_blend_epi16(t1, t2, 0xF0);
+    s1 = _mm_alignr_epi8(t2, t1, 0x08);
+}
+
+__m128i inline __attribute__((always_inline)) Load(const unsigned char* in)
+{
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)in), MASK);
+}
+
+void inline __attribute__((always_inline)) Save(unsigned char* out, __m128i s)
+{
+    _mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(s, MASK));
+}
+
+/** All 64 rounds over the message words m0..m3 (which are clobbered), adding the result into s0/s1 */
+void inline __attribute__((always_inline)) Rounds(__m128i& s0, __m128i& s1, __m128i m0, __m128i m1, __m128i m2, __m128i m3)
+{
+    const __m128i so0 = s0;
+    const __m128i so1 = s1;
+
+    QuadRound(s0, s1, m0, K256 + 0);
+    QuadRound(s0, s1, m1, K256 + 4);
+    ShiftMessageA(m0, m1);
+    QuadRound(s0, s1, m2, K256 + 8);
+    ShiftMessageA(m1, m2);
+    QuadRound(s0, s1, m3, K256 + 12);
+    ShiftMessageB(m2, m3, m0);
+    QuadRound(s0, s1, m0, K256 + 16);
+    ShiftMessageB(m3, m0, m1);
+    QuadRound(s0, s1, m1, K256 + 20);
+    ShiftMessageB(m0, m1, m2);
+    QuadRound(s0, s1, m2, K256 + 24);
+    ShiftMessageB(m1, m2, m3);
+    QuadRound(s0, s1, m3, K256 + 28);
+    ShiftMessageB(m2, m3, m0);
+    QuadRound(s0, s1, m0, K256 + 32);
+    ShiftMessageB(m3, m0, m1);
+    QuadRound(s0, s1, m1, K256 + 36);
+    ShiftMessageB(m0, m1, m2);
+    QuadRound(s0, s1, m2, K256 + 40);
+    ShiftMessageB(m1, m2, m3);
+    QuadRound(s0, s1, m3, K256 + 44);
+    ShiftMessageB(m2, m3, m0);
+    QuadRound(s0, s1, m0, K256 + 48);
+    ShiftMessageB(m3, m0, m1);
+    QuadRound(s0, s1, m1, K256 + 52);
+    ShiftMessageC(m0, m1, m2);
+    QuadRound(s0, s1, m2, K256 + 56);
+    ShiftMessageC(m1, m2, m3);
+    QuadRound(s0, s1, m3, K256 + 60);
+
+    s0 = _mm_add_epi32(s0, so0);
+    s1 = _mm_add_epi32(s1, so1);
+}
+
+/** Initial state in ABEF/CDGH layout */
+void inline __attribute__((always_inline)) InitState(__m128i& s0, __m128i& s1)
+{
+    s0 = _mm_load_si128((const __m128i*)INIT);
+    s1 = _mm_load_si128((const __m128i*)(INIT + 4));
+    Shuffle(s0, s1);
+}
+
+/** Double-SHA256 of one 64-byte input */
+void inline __attribute__((always_inline)) TransformD64(unsigned char* out, const unsigned char* in)
+{
+    __m128i s0, s1;
+
+    // Transform 1: the 64-byte input
+    InitState(s0, s1);
+    Rounds(s0, s1, Load(in), Load(in + 16), Load(in + 32), Load(in + 48));
+
+    // Transform 2: padding for a 64-byte message
+    Rounds(s0, s1, _mm_set_epi32(0, 0, 0, 0x80000000), _mm_setzero_si128(), _mm_setzero_si128(), _mm_set_epi32(0x200, 0, 0, 0));
+
+    // Transform 3: hash the 32-byte result, whose words are exactly the state words
+    Unshuffle(s0, s1);
+    const __m128i m0 = s0;
+    const __m128i m1 = s1;
+    InitState(s0, s1);
+    Rounds(s0, s1, m0, m1, _mm_set_epi32(0, 0, 0, 0x80000000), _mm_set_epi32(0x100, 0, 0, 0));
+
+    Unshuffle(s0, s1);
+    Save(out, s0);
+    Save(out + 16, s1);
+}
+
+}
+
+namespace sha256_shani {
+void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks)
+{
+    __m128i s0 = _mm_loadu_si128((const __m128i*)s);
+    __m128i s1 = _mm_loadu_si128((const __m128i*)(s + 4));
+    Shuffle(s0, s1);
+
+    while (blocks--) {
+        Rounds(s0, s1, Load(chunk), Load(chunk + 16), Load(chunk + 32), Load(chunk + 48));
+        chunk += 64;
+    }
+
+    Unshuffle(s0, s1);
+    _mm_storeu_si128((__m128i*)s, s0);
+    _mm_storeu_si128((__m128i*)(s + 4), s1);
+}
+}
+
+namespace sha256d64_shani {
+void Transform_2way(unsigned char* out, const unsigned char* in)
+{
+    // The two inputs are independent, so the out-of-order core can overlap their rounds
+    TransformD64(out, in);
+    TransformD64(out + 32, in + 64);
+}
+}
+
+#endif
@@ -0,0 +1,54 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <forgeproofcache.h>
+
+#include <crypto/sha256.h>
+#include <primitives/block.h>
+#include <random.h>
+
+CForgeProofCache::CForgeProofCache() : nHits(0), nMisses(0)
+{
+    GetRandBytes(nonce.begin(), 32);
+    setValid.setup(2);      // Usable before InitForgeProofCache sizes it
+}
+
+CForgeProofCache::CForgeProofCache(const uint256& nonceIn) : nonce(nonceIn), nHits(0), nMisses(0)
+{
+    setValid.setup(2);
+}
+
+void CForgeProofCache::ComputeEntry(uint256& entry, const CBlock& block) const
+{
+    uint256 hashBlock = block.GetHash();
+    uint256 hashCoinbase = block.vtx.empty() ? uint256() : block.vtx[0]->GetHash();
+    CSHA256().Write(nonce.begin(), 32).Write(hashBlock.begin(), 32).Write(hashCoinbase.begin(), 32).Finalize(entry.begin());
+}
+
+bool CForgeProofCache::Check(const CBlock& block, const std::function<bool()>& fnCheck)
+{
+    uint256 entry;
+    ComputeEntry(entry, block);
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_forgeproofcache);
+        if (setValid.contains(entry, false)) {
+            nHits++;
+            return true;
+        }
+    }
+    nMisses++;
+
+    if (!fnCheck())
+        return false;
+
+    boost::unique_lock<boost::shared_mutex> lock(cs_forgeproofcache);
+    setValid.insert(entry);
+    return true;
+}
+
+uint32_t CForgeProofCache::setup_bytes(size_t n)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_forgeproofcache);
+    return setValid.setup_bytes(n);
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_FORGEPROOFCACHE_H
+#define BITCOIN_FORGEPROOFCACHE_H
+
+#include <cuckoocache.h>
+#include <script/sigcache.h>
+#include <uint256.h>
+
+#include <atomic>
+#include <functional>
+
+#include <boost/thread/shared_mutex.hpp>
+
+class CBlock;
+
+/**
+ * Thor: Forge: Cache of successfully validated forge proofs, so a Forge block is only checked
+ * once, and not again when it's read from disk, reconnected on a reorg, or (if we mined it)
+ * comes back through ProcessNewBlock. Entries are SHA256(nonce || block hash || coinbase hash):
+ * the block hash commits to the previous block, and so to the target and the BCT history the
+ * proof was checked against, and the coinbase carries the proof itself.
+ */
+class CForgeProofCache
+{
+private:
+    uint256 nonce;
+    CuckooCache::cache<uint256, SignatureCacheHasher> setValid;
+    boost::shared_mutex cs_forgeproofcache;
+
+public:
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+
+    CForgeProofCache();                                 // Salted with a random nonce
+    explicit CForgeProofCache(const uint256& nonceIn);
+
+    void ComputeEntry(uint256& entry, const CBlock& block) const;
+
+    /** Run fnCheck on the block's forge proof unless it's already been found valid, and remember it if it passes */
+    bool Check(const CBlock& block, const std::function<bool()>& fnCheck);
+
+    uint32_t setup_bytes(size_t n);
+};
+
+#endif // BITCOIN_FORGEPROOFCACHE_H
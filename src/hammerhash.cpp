@@ -0,0 +1,67 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <hammerhash.h>
+
+#include <crypto/common.h>
+
+namespace {
+
+/** Minimal stream feeding serialized data straight into a SHA256 context */
+class CSHA256Stream
+{
+private:
+    CSHA256& ctx;
+
+public:
+    explicit CSHA256Stream(CSHA256& ctxIn) : ctx(ctxIn) {}
+
+    void write(const char* pch, size_t size)
+    {
+        ctx.Write((const unsigned char*)pch, size);
+    }
+};
+
+} // namespace
+
+std::string CDeterministicRand::ToString() const
+{
+    std::string deterministicRandString;
+    for (int i = 0; i < nHashes; i++)
+        deterministicRandString += hashes[i].GetHex();
+    return deterministicRandString;
+}
+
+CHammerHasher::CHammerHasher(const std::string& deterministicRandString)
+{
+    CSHA256Stream s(ctx);
+    Serialize(s, deterministicRandString);
+}
+
+CHammerHasher::CHammerHasher(const CDeterministicRand& deterministicRand)
+{
+    CSHA256Stream s(ctx);
+    deterministicRand.Serialize(s);
+}
+
+CHammerHasher CHammerHasher::ForBCT(const std::string& txid) const
+{
+    CHammerHasher hasher(*this);
+    CSHA256Stream s(hasher.ctx);
+    Serialize(s, txid);
+    return hasher;
+}
+
+uint256 CHammerHasher::GetHash(uint32_t nonce) const
+{
+    unsigned char nonceData[4];
+    WriteLE32(nonceData, nonce);
+
+    unsigned char buf[CSHA256::OUTPUT_SIZE];
+    CSHA256(ctx).Write(nonceData, sizeof(nonceData)).Finalize(buf);
+
+    uint256 hash;
+    CSHA256().Write(buf, sizeof(buf)).Finalize(hash.begin());
+    return hash;
+}
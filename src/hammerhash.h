@@ -0,0 +1,84 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_HAMMERHASH_H
+#define BITCOIN_HAMMERHASH_H
+
+#include <arith_uint256.h>
+#include <crypto/sha256.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Thor: Forge: The block hashes the deterministic rand string is made of (see whitepaper
+ * section 4.1), newest first: pindexPrev and its ancestors 13, 173, 471, 1363 and 12103
+ * blocks back, as far as the chain reaches. The rand string itself is these hashes as hex,
+ * concatenated; Serialize() writes exactly what serializing that std::string would, so it
+ * can be hashed and signed without ever being built.
+ */
+struct CDeterministicRand
+{
+    static const int MAX_HASHES = 6;
+    uint256 hashes[MAX_HASHES];
+    int nHashes;
+
+    CDeterministicRand() : nHashes(0) {}
+
+    /** The rand string, for logging and callers that need the text */
+    std::string ToString() const;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        static const char hexdigits[] = "0123456789abcdef";
+        WriteCompactSize(s, nHashes * 64);
+        for (int i = 0; i < nHashes; i++) {
+            char hex[64];
+            for (int j = 0; j < 32; j++) {
+                unsigned char c = hashes[i].begin()[31 - j];
+                hex[2 * j] = hexdigits[c >> 4];
+                hex[2 * j + 1] = hexdigits[c & 15];
+            }
+            s.write(hex, sizeof(hex));
+        }
+    }
+};
+
+/**
+ * Thor: Forge: Hammer hash kernel.
+ *
+ * A hammer's hash is SHA256d(ser(deterministicRandString) || ser(txid) || LE32(nonce)),
+ * ie what CHashWriter produces for the same three fields. The string prefix is the same
+ * for every hammer in a BCT, so its SHA256 midstate is computed once and only the 4 byte
+ * nonce tail is hashed per hammer, without any allocation or hex round trip.
+ */
+class CHammerHasher
+{
+private:
+    CSHA256 ctx;
+
+public:
+    CHammerHasher() {}
+
+    /** Start from the deterministic rand string shared by all BCTs for the next block */
+    explicit CHammerHasher(const std::string& deterministicRandString);
+    explicit CHammerHasher(const CDeterministicRand& deterministicRand);
+
+    /** Derive the hasher for the hammers of a single BCT */
+    CHammerHasher ForBCT(const std::string& txid) const;
+
+    /** Hash of the hammer with the given nonce */
+    uint256 GetHash(uint32_t nonce) const;
+
+    /** Whether the hammer with the given nonce meets the target */
+    bool CheckHash(uint32_t nonce, const arith_uint256& hammerHashTarget) const
+    {
+        return UintToArith256(GetHash(nonce)) < hammerHashTarget;
+    }
+};
+
+#endif // BITCOIN_HAMMERHASH_H
@@ -0,0 +1,120 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <hammerpopindex.h>
+
+#include <base58.h>
+#include <chain.h>
+#include <consensus/params.h>
+#include <primitives/block.h>
+#include <script/standard.h>
+#include <txdb.h>
+#include <util.h>
+#include <validation.h>
+
+CHammerPopIndex hammerPopIndex;
+
+CHammerPopEntry CHammerPopIndex::ComputeEntry(const CBlock& block, int nHeight, const Consensus::Params& consensusParams)
+{
+    CHammerPopEntry entry;
+    if (block.IsForgeMined(consensusParams))    // No BCTs will be found in Forgemined blocks
+        return entry;
+
+    CScript scriptPubKeyBCF = GetScriptForDestination(DecodeDestination(consensusParams.hammerCreationAddress));
+    CScript scriptPubKeyCF = GetScriptForDestination(DecodeDestination(consensusParams.forgeCommunityAddress));
+    CAmount hammerCost = 0;
+
+    for (const auto& tx : block.vtx) {
+        CAmount hammerFeePaid;
+        if (!tx->IsBCT(consensusParams, scriptPubKeyBCF, &hammerFeePaid))
+            continue;
+        if (tx->vout.size() > 1 && tx->vout[1].scriptPubKey == scriptPubKeyCF) {    // If it has a community fund contrib...
+            CAmount donationAmount = tx->vout[1].nValue;
+            CAmount expectedDonationAmount = (hammerFeePaid + donationAmount) / consensusParams.communityContribFactor;  // ...check for valid donation amount
+            if (donationAmount != expectedDonationAmount)
+                continue;
+            hammerFeePaid += donationAmount;                                           // Add donation amount back to total paid
+        }
+        if (hammerCost == 0)
+            hammerCost = GetHammerCost(nHeight, consensusParams);
+        entry.nHammers += hammerFeePaid / hammerCost;
+        entry.nBCTs++;
+    }
+    return entry;
+}
+
+void CHammerPopIndex::Store(const CBlockIndex* pindex, const CHammerPopEntry& entry)
+{
+    LOCK(cs);
+    if (vSlots.empty())
+        return;
+    Slot& slot = vSlots[pindex->nHeight % vSlots.size()];
+    slot.hash = pindex->GetBlockHash();
+    slot.entry = entry;
+}
+
+void CHammerPopIndex::Init(const Consensus::Params& consensusParams)
+{
+    LOCK(cs);
+    vSlots.clear();
+    vSlots.resize(consensusParams.hammerGestationBlocks + consensusParams.hammerLifespanBlocks + 1);
+}
+
+bool CHammerPopIndex::BlockConnected(const CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams, bool fWriteDB)
+{
+    CHammerPopEntry entry = ComputeEntry(block, pindex->nHeight, consensusParams);
+    Store(pindex, entry);
+
+    // Forgemined blocks never create hammers; GetEntry() can tell them apart from the header alone
+    if (fWriteDB && pblocktree && !block.IsForgeMined(consensusParams))
+        return pblocktree->WriteHammerPop(pindex->GetBlockHash(), entry);
+    return true;
+}
+
+void CHammerPopIndex::BlockDisconnected(const CBlockIndex* pindex)
+{
+    LOCK(cs);
+    if (vSlots.empty())
+        return;
+    Slot& slot = vSlots[pindex->nHeight % vSlots.size()];
+    if (slot.hash == pindex->GetBlockHash())
+        slot.hash.SetNull();
+}
+
+bool CHammerPopIndex::GetEntry(const CBlockIndex* pindex, const Consensus::Params& consensusParams, CHammerPopEntry& entry)
+{
+    if (pindex->IsForgeMined(consensusParams)) {
+        entry = CHammerPopEntry();
+        return true;
+    }
+
+    const uint256 hash = pindex->GetBlockHash();
+    {
+        LOCK(cs);
+        if (!vSlots.empty()) {
+            const Slot& slot = vSlots[pindex->nHeight % vSlots.size()];
+            if (slot.hash == hash) {
+                entry = slot.entry;
+                return true;
+            }
+        }
+    }
+
+    // Not in memory: try the block tree DB, then fall back to the block itself (eg blocks connected before the index existed)
+    if (!pblocktree || !pblocktree->ReadHammerPop(hash, entry)) {
+        if (fHavePruned && !(pindex->nStatus & BLOCK_HAVE_DATA) && pindex->nTx > 0)
+            return error("%s: Block not available (pruned data) at height %d", __func__, pindex->nHeight);
+
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, consensusParams))
+            return error("%s: Block not found on disk at height %d", __func__, pindex->nHeight);
+
+        entry = ComputeEntry(block, pindex->nHeight, consensusParams);
+        if (pblocktree)
+            pblocktree->WriteHammerPop(hash, entry);
+    }
+
+    Store(pindex, entry);
+    return true;
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_HAMMERPOPINDEX_H
+#define BITCOIN_HAMMERPOPINDEX_H
+
+#include <amount.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+
+namespace Consensus { struct Params; };
+
+/** Thor: Forge: Hammers and BCTs created by a single block. */
+struct CHammerPopEntry
+{
+    int nHammers;
+    int nBCTs;
+
+    CHammerPopEntry() : nHammers(0), nBCTs(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(VARINT(nHammers));
+        READWRITE(VARINT(nBCTs));
+    }
+};
+
+/**
+ * Thor: Forge: Per-block hammer population index.
+ *
+ * Every connected block gets a CHammerPopEntry, persisted in the block tree
+ * DB keyed by block hash. The most recent hammer lifespan worth of entries is
+ * held in a ring buffer indexed by height and tagged with the block hash, so
+ * lookups along the active chain are a memory access and reorgs only ever
+ * cause a fall back to the DB (or, for blocks connected before the index
+ * existed, a single read of the block from disk).
+ */
+class CHammerPopIndex
+{
+private:
+    struct Slot {
+        uint256 hash;
+        CHammerPopEntry entry;
+    };
+
+    CCriticalSection cs;
+    std::vector<Slot> vSlots;
+
+    void Store(const CBlockIndex* pindex, const CHammerPopEntry& entry);
+
+public:
+    /** Count the BCTs and hammers created by a block at a given height */
+    static CHammerPopEntry ComputeEntry(const CBlock& block, int nHeight, const Consensus::Params& consensusParams);
+
+    /** Size the ring buffer to cover a full hammer lifespan; drops all cached entries */
+    void Init(const Consensus::Params& consensusParams);
+
+    /** Record the entry for a newly connected block (in memory and, if fWriteDB, in the block tree DB) */
+    bool BlockConnected(const CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams, bool fWriteDB = true);
+
+    /** Forget the in-memory entry for a disconnected block */
+    void BlockDisconnected(const CBlockIndex* pindex);
+
+    /** Get the entry for a block, falling back to the DB and then to the block itself */
+    bool GetEntry(const CBlockIndex* pindex, const Consensus::Params& consensusParams, CHammerPopEntry& entry);
+};
+
+extern CHammerPopIndex hammerPopIndex;
+
+#endif // BITCOIN_HAMMERPOPINDEX_H
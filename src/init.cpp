@@ -11,12 +11,14 @@
 
 #include <addrman.h>
 #include <amount.h>
+#include <bctindex.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <compat/sanity.h>
 #include <consensus/validation.h>
 #include <fs.h>
+#include <hammerpopindex.h>
 #include <httpserver.h>
 #include <httprpc.h>
 #include <key.h>
@@ -28,6 +30,7 @@
 #include <policy/feerate.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <rpc/server.h>
 #include <rpc/register.h>
 #include <rpc/safemode.h>
@@ -67,9 +70,7 @@
 #include <zmq/zmqnotificationinterface.h>
 #endif
 
-#ifdef USE_SSE2
 #include "crypto/scrypt.h"
-#endif
 
 bool fFeeEstimatesInitialized = false;
 static const bool DEFAULT_PROXYRANDOMIZE = true;
@@ -251,6 +252,7 @@ void Shutdown()
         pcoinscatcher.reset();
         pcoinsdbview.reset();
         pblocktree.reset();
+        pbctindex.reset();
     }
 #ifdef ENABLE_WALLET
     StopWallets();
@@ -376,6 +378,7 @@ std::string HelpMessage(HelpMessageMode mode)
 #ifndef WIN32
     strUsage += HelpMessageOpt("-sysperms", _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)"));
 #endif
+    strUsage += HelpMessageOpt("-bctindex", strprintf(_("Maintain an index of BCT locations, used to check Forge proofs without reading blocks during reindex (default: %u)"), DEFAULT_BCTINDEX));
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), DEFAULT_TXINDEX));
 
     strUsage += HelpMessageGroup(_("Connection options:"));
@@ -395,6 +398,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-maxreceivebuffer=<n>", strprintf(_("Maximum per-connection receive buffer, <n>*1000 bytes (default: %u)"), DEFAULT_MAXRECEIVEBUFFER));
     strUsage += HelpMessageOpt("-maxsendbuffer=<n>", strprintf(_("Maximum per-connection send buffer, <n>*1000 bytes (default: %u)"), DEFAULT_MAXSENDBUFFER));
     strUsage += HelpMessageOpt("-maxtimeadjustment", strprintf(_("Maximum allowed median peer time offset adjustment. Local perspective of time may be influenced by peers forward or backward by this amount. (default: %u seconds)"), DEFAULT_MAX_TIME_ADJUSTMENT));
+    strUsage += HelpMessageOpt("-msghandthreads=<n>", strprintf(_("Number of threads to process peer messages, each handling its own share of peers (1 to %d, default: %d)"), MAX_MSGHAND_THREADS, DEFAULT_MSGHAND_THREADS));
     strUsage += HelpMessageOpt("-onion=<ip:port>", strprintf(_("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: %s)"), "-proxy"));
     strUsage += HelpMessageOpt("-onlynet=<net>", _("Only connect to nodes in network <net> (ipv4, ipv6 or onion)"));
     strUsage += HelpMessageOpt("-permitbaremultisig", strprintf(_("Relay non-P2SH multisig (default: %u)"), DEFAULT_PERMIT_BAREMULTISIG));
@@ -439,6 +443,8 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. Also sets -checkmempool (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", defaultChainParams->DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED));
+        strUsage += HelpMessageOpt("-verifyblockreads", strprintf("Re-check PoW and Forge proofs of fully validated blocks whenever they are read from disk (default: %u)", DEFAULT_VERIFY_BLOCK_READS));
+        strUsage += HelpMessageOpt("-verifyindexpow", strprintf("Re-check the stored PoW of block index entries in the background after startup (default: %u)", DEFAULT_VERIFY_INDEX_POW));
         strUsage += HelpMessageOpt("-disablesafemode", strprintf("Disable safemode, override a real safe mode event (default: %u)", DEFAULT_DISABLE_SAFEMODE));
         strUsage += HelpMessageOpt("-deprecatedrpc=<method>", "Allows deprecated RPC method(s) to be used");
         strUsage += HelpMessageOpt("-testsafemode", strprintf("Force safe mode (default: %u)", DEFAULT_TESTSAFEMODE));
@@ -463,6 +469,7 @@ std::string HelpMessage(HelpMessageMode mode)
     {
         strUsage += HelpMessageOpt("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS));
         strUsage += HelpMessageOpt("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)");
+        strUsage += HelpMessageOpt("-maxforgeproofcachesize=<n>", strprintf("Limit the validated forge proof cache to <n> MiB (default: %u)", DEFAULT_MAX_FORGE_PROOF_CACHE_SIZE));
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit sum of signature cache and script execution cache sizes to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE));
         strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE));
     }
@@ -517,8 +524,11 @@ std::string HelpMessage(HelpMessageMode mode)
     }
 
     // LitecoinCash: Forge: Mining optimisations
-    strUsage += HelpMessageOpt("-forgecheckdelay", strprintf(_("Time between Forge checks in ms. This should be left at default unless performance degradation is observed (default: %u)"), DEFAULT_FORGE_CHECK_DELAY));
+    strUsage += HelpMessageOpt("-forgecheckdelay", strprintf(_("Time in ms to wait after a new tip before the Forge check starts. This should be left at default unless performance degradation is observed (default: %u)"), DEFAULT_FORGE_CHECK_DELAY));
     strUsage += HelpMessageOpt("-forgecheckthreads=<threads>", strprintf(_("Number of threads to use when checking hammers, -1 for all available cores, or -2 for one less than all available cores (default: %u)"), DEFAULT_FORGE_THREADS));
+    strUsage += HelpMessageOpt("-forgecheckaffinity", strprintf(_("Pin each hammer check worker thread to its own core (Linux only) (default: %u)"), DEFAULT_FORGE_CHECK_AFFINITY));
+    strUsage += HelpMessageOpt("-forgework", strprintf(_("Publish the Forge check to remote workers (see getforgework and thor-forgeworker), sharing the hammers between them and the node; set -rpcthreads to at least 2 more than the number of workers (default: %u)"), DEFAULT_FORGE_WORK));
+    strUsage += HelpMessageOpt("-forgeworkers=<n>", strprintf(_("With -forgework, the number of remote workers sharing the Forge check: the node checks one chunk in n+1 itself and publishes the rest, for workers started with -workercount=<n> (default: %u)"), DEFAULT_FORGE_WORKERS));
     strUsage += HelpMessageOpt("-forgeearlyabort", strprintf(_("Abort Forge checking as quickly as possible when a new block comes in. This should be left enabled unless performance degradation is observed. (default: %u)"), DEFAULT_FORGE_EARLY_OUT));
 
     return strUsage;
@@ -931,7 +941,9 @@ bool AppInitParameterInteraction()
     nMaxConnections = std::max(nUserMaxConnections, 0);
 
     // Trim requested connection counts, to fit into system limitations
+#ifndef USE_POLL
     nMaxConnections = std::max(std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS)), 0);
+#endif
     nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS + MAX_ADDNODE_CONNECTIONS);
     if (nFD < MIN_CORE_FILEDESCRIPTORS)
         return InitError(_("Not enough file descriptors available."));
@@ -987,6 +999,10 @@ bool AppInitParameterInteraction()
     if (gArgs.IsArgSet("-blockminsize"))
         InitWarning("Unsupported argument -blockminsize ignored.");
 
+    // Thor: Forge: getforgework long polls each hold an RPC thread, and two are kept free of them
+    if (gArgs.GetBoolArg("-forgework", DEFAULT_FORGE_WORK) && gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS) < 3)
+        InitWarning("-forgework needs -rpcthreads of at least 2 more than the number of Forge workers; with fewer than 3, workers can't long poll.");
+
     // Checkmempool and checkblockindex default to true in regtest mode
     int ratio = std::min<int>(std::max<int>(gArgs.GetArg("-checkmempool", chainparams.DefaultConsistencyChecks() ? 1 : 0), 0), 1000000);
     if (ratio != 0) {
@@ -994,6 +1010,7 @@ bool AppInitParameterInteraction()
     }
     fCheckBlockIndex = gArgs.GetBoolArg("-checkblockindex", chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled = gArgs.GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
+    fVerifyBlockReads = gArgs.GetBoolArg("-verifyblockreads", DEFAULT_VERIFY_BLOCK_READS);   // Thor: Forge
 
     hashAssumeValid = uint256S(gArgs.GetArg("-assumevalid", chainparams.GetConsensus().defaultAssumeValid.GetHex()));
     if (!hashAssumeValid.IsNull())
@@ -1246,11 +1263,14 @@ bool AppInitMain()
 
     InitSignatureCache();
     InitScriptExecutionCache();
+    InitForgeProofCache();      // Thor: Forge
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i=0; i<nScriptCheckThreads-1; i++)
+        for (int i=0; i<nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadHeaderPoWCheck);   // Thor: Headers message PoW
+        }
     }
 
     // Start the lightweight task scheduler thread
@@ -1286,6 +1306,7 @@ bool AppInitMain()
     std::string sse2detect = scrypt_detect_sse2();
     LogPrintf("%s\n", sse2detect);
 #endif
+    LogPrintf("%s\n", scrypt_detect_multi());
 
     // ********************************************************* Step 5: verify wallet database integrity
 #ifdef ENABLE_WALLET
@@ -1304,6 +1325,7 @@ bool AppInitMain()
 
     peerLogic.reset(new PeerLogicValidation(&connman, scheduler));
     RegisterValidationInterface(peerLogic.get());
+    RegisterBlockTemplateCache();   // Thor: Incremental templates
 
     // sanitize comments per BIP-0014, format user agent and check total size
     std::vector<std::string> uacomments;
@@ -1417,6 +1439,8 @@ bool AppInitMain()
     int64_t nBlockTreeDBCache = nTotalCache / 8;
     nBlockTreeDBCache = std::min(nBlockTreeDBCache, (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxBlockDBAndTxIndexCache : nMaxBlockDBCache) << 20);
     nTotalCache -= nBlockTreeDBCache;
+    int64_t nBCTIndexCache = gArgs.GetBoolArg("-bctindex", DEFAULT_BCTINDEX) ? std::min(nTotalCache / 16, nMaxBCTIndexCache << 20) : 0;   // Thor: Forge
+    nTotalCache -= nBCTIndexCache;
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
@@ -1425,6 +1449,8 @@ bool AppInitMain()
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
+    if (nBCTIndexCache > 0)
+        LogPrintf("* Using %.1fMiB for BCT index database\n", nBCTIndexCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
     bool fLoaded = false;
@@ -1445,6 +1471,10 @@ bool AppInitMain()
                 // fails if it's still open from the previous loop. Close it first:
                 pblocktree.reset();
                 pblocktree.reset(new CBlockTreeDB(nBlockTreeDBCache, false, fReset));
+                hammerPopIndex.Init(chainparams.GetConsensus());    // Thor: Forge
+                pbctindex.reset();                                   // Thor: Forge
+                if (nBCTIndexCache > 0)
+                    pbctindex.reset(new CBCTIndex(nBCTIndexCache));
 
                 if (fReset) {
                     pblocktree->WriteReindexing(true);
@@ -1708,6 +1738,7 @@ bool AppInitMain()
     connOptions.m_msgproc = peerLogic.get();
     connOptions.nSendBufferMaxSize = 1000*gArgs.GetArg("-maxsendbuffer", DEFAULT_MAXSENDBUFFER);
     connOptions.nReceiveFloodSize = 1000*gArgs.GetArg("-maxreceivebuffer", DEFAULT_MAXRECEIVEBUFFER);
+    connOptions.nMsgHandThreads = gArgs.GetArg("-msghandthreads", DEFAULT_MSGHAND_THREADS);
     connOptions.m_added_nodes = gArgs.GetArgs("-addnode");
 
     connOptions.nMaxOutboundTimeframe = nMaxOutboundTimeframe;
@@ -1755,8 +1786,16 @@ bool AppInitMain()
 
     // ********************************************************* Step 12: finished
 
-    // Thor: Forge: Start the mining thread
+    // Thor: Re-check the PoW of block index entries loaded without it
+    if (gArgs.GetBoolArg("-verifyindexpow", DEFAULT_VERIFY_INDEX_POW))
+        threadGroup.create_thread(boost::bind(&ThreadVerifyIndexPoW, boost::cref(chainparams)));
+
+    // Thor: Forge: Start the mining thread and its hammer check workers; there's a worker for every core, and the
+    // ones -forgecheckthreads (or setforgeparams) doesn't call for wait
 #ifdef ENABLE_WALLET
+    LogPrintf("Using %u threads for Forge checks\n", GetForgeCheckThreads());
+    for (int i = 0; i < GetNumVirtualCores() - 1; i++)
+        threadGroup.create_thread(&ThreadHammerCheck);
     threadGroup.create_thread(boost::bind(&HammerKeeper, boost::cref(chainparams)));
 #endif
 
@@ -14,6 +14,7 @@
 #include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <hash.h>
+#include <init.h>
 #include <crypto/scrypt.h>
 #include <validation.h>
 #include <net.h>
@@ -26,22 +27,45 @@
 #include <util.h>
 #include <utilmoneystr.h>
 #include <validationinterface.h>
+#include <checkqueue.h>
 
 #include <algorithm>
+#include <future>
+#include <limits>
+#include <map>
 #include <queue>
+#include <set>
 #include <utility>
 
 #include <wallet/wallet.h>  // Thor: Forge
 #include <rpc/server.h>     // Thor: Forge
 #include <base58.h>         // Thor: Forge
+#include <hammerhash.h>     // Thor: Forge
 #include <sync.h>           // Thor: Forge
 #include <boost/thread.hpp> // LitecoinCash: Forge: Mining optimisations
+#ifdef __linux__
+#include <pthread.h>        // Thor: Forge: Hammer check thread affinity
+#include <sched.h>
+#endif
 
 static CCriticalSection cs_solution_vars;
-std::atomic<bool> solutionFound;            // LitecoinCash: Forge: Mining optimisations: Thread-safe atomic flag to signal solution found (saves a slow mutex)
-std::atomic<bool> earlyAbort;               // LitecoinCash: Forge: Mining optimisations: Thread-safe atomic flag to signal early abort needed
-CHammerRange solvingRange;                     // LitecoinCash: Forge: Mining optimisations: The solving range (protected by mutex)
-uint32_t solvingHammer;                        // LitecoinCash: Forge: Mining optimisations: The solving hammer (protected by mutex)
+static std::atomic<bool> solutionFound;     // LitecoinCash: Forge: Mining optimisations: Thread-safe atomic flag to signal solution found (saves a slow mutex)
+static CHammerRange solutionRange;             // LitecoinCash: Forge: Mining optimisations: The solving range (protected by mutex)
+static uint32_t solutionHammer;                // LitecoinCash: Forge: Mining optimisations: The solving hammer (protected by mutex)
+
+// Thor: Forge: Bumped on every tip change; wakes the HammerKeeper and tells running bin checks their tip is stale
+static boost::mutex mutexTipGeneration;
+static boost::condition_variable condTipGeneration;
+static std::atomic<uint64_t> nTipGeneration(0);
+
+// Thor: Forge: Work published to remote workers (-forgework), and the solution one of them sent back (protected by mutexTipGeneration)
+static CForgeWork forgeWork;
+static uint64_t nForgeWorkGeneration = 0;
+static std::vector<CHammerRange> vForgeWorkRanges;
+static CHammerHasher forgeWorkHasher;
+static CHammerRange remoteSolutionRange;
+static uint32_t remoteSolutionHammer;
+static std::atomic<uint64_t> nRemoteSolutionGeneration(std::numeric_limits<uint64_t>::max());    // No generation solved yet; tip generations start at 0
 
 //////////////////////////////////////////////////////////////////////////////
 //
@@ -122,8 +146,243 @@ void BlockAssembler::resetBlock()
     nFees = 0;
 }
 
+// Thor: Incremental templates: The transactions last selected for a template on the current tip.
+// The validation interface queues transactions added to the mempool and drops the selection on a
+// tip change or when one of its transactions leaves the mempool; CreateNewBlock appends what was
+// queued instead of walking the whole mempool again. Each slot holds templates with or without BCTs.
+struct CTemplateSelection
+{
+    bool fValid;
+    uint256 hashPrevBlock;
+    int nHeight;
+    int64_t nLockTimeCutoff;
+    unsigned int nBlockMaxWeight;
+    CFeeRate blockMinFeeRate;
+    bool fIncludeWitness;
+    unsigned int nTransactionsUpdated;
+    bool fTested;                       // The body passed TestBlockValidity
+    CFeeRate lowestFeeRate;             // Lowest fee rate among the selected transactions
+
+    std::vector<CTransactionRef> vtx;   // Selected transactions, without the coinbase
+    std::vector<CAmount> vTxFees;
+    std::vector<int64_t> vTxSigOpsCost;
+    std::set<uint256> setTxids;
+    uint64_t nBlockWeight;
+    uint64_t nBlockSigOpsCost;
+    CAmount nFees;
+
+    std::vector<CTransactionRef> vAdded; // Added to the mempool since the selection was made
+
+    CTemplateSelection() : fValid(false) {}
+};
+
+static const size_t MAX_TEMPLATE_CACHE_ADDED = 10000;   // Rebuild rather than append more than this
+
+class CBlockTemplateCache : public CValidationInterface
+{
+public:
+    CCriticalSection cs;
+    CTemplateSelection slots[2];        // Indexed by fIncludeBCTs
+    std::atomic<bool> fRegistered;
+
+    CBlockTemplateCache() : fRegistered(false) {}
+
+    void Invalidate() {
+        LOCK(cs);
+        for (CTemplateSelection& slot : slots)
+            slot.fValid = false;
+    }
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override {
+        LOCK(cs);
+        for (CTemplateSelection& slot : slots)
+            if (slot.hashPrevBlock != pindexNew->GetBlockHash())
+                slot.fValid = false;
+    }
+
+    void TransactionAddedToMempool(const CTransactionRef &ptx) override {
+        LOCK(cs);
+        for (CTemplateSelection& slot : slots) {
+            if (!slot.fValid)
+                continue;
+            if (slot.vAdded.size() >= MAX_TEMPLATE_CACHE_ADDED)
+                slot.fValid = false;
+            else
+                slot.vAdded.push_back(ptx);
+        }
+    }
+
+    void TransactionRemovedFromMempool(const CTransactionRef &ptx) override {
+        LOCK(cs);
+        for (CTemplateSelection& slot : slots)
+            if (slot.fValid && slot.setTxids.count(ptx->GetHash()))
+                slot.fValid = false;
+    }
+};
+
+static CBlockTemplateCache templateCache;
+
+// Thor: Incremental templates: Fee deltas change the selection order, whoever sets them (RPC or mempool.dat)
+static void BlockTemplateCacheFeeDeltaChanged(const uint256& hash)
+{
+    templateCache.Invalidate();
+}
+
+void RegisterBlockTemplateCache()
+{
+    RegisterValidationInterface(&templateCache);
+    mempool.NotifyFeeDeltaChanged.connect(&BlockTemplateCacheFeeDeltaChanged);
+    templateCache.fRegistered = true;
+}
+
+void UnregisterBlockTemplateCache()
+{
+    templateCache.fRegistered = false;
+    mempool.NotifyFeeDeltaChanged.disconnect(&BlockTemplateCacheFeeDeltaChanged);
+    UnregisterValidationInterface(&templateCache);
+    templateCache.Invalidate();
+}
+
+void InvalidateBlockTemplateCache()
+{
+    templateCache.Invalidate();
+}
+
+bool BlockAssembler::ResumeFromTemplateCache(const CBlockIndex* pindexPrev, bool& fTested, int& nAppended)
+{
+    AssertLockHeld(mempool.cs);
+
+    LOCK(templateCache.cs);
+    CTemplateSelection& slot = templateCache.slots[fIncludeBCTs];
+    if (!slot.fValid || slot.hashPrevBlock != pindexPrev->GetBlockHash() || slot.nHeight != nHeight || slot.nLockTimeCutoff != nLockTimeCutoff ||
+        slot.nBlockMaxWeight != nBlockMaxWeight || slot.blockMinFeeRate != blockMinFeeRate || slot.fIncludeWitness != fIncludeWitness)
+        return false;
+
+    const unsigned int nTransactionsUpdated = mempool.GetTransactionsUpdated();
+    if (nTransactionsUpdated != slot.nTransactionsUpdated || !slot.vAdded.empty()) {
+        // Without the validation interface there's no telling what changed
+        if (!templateCache.fRegistered)
+            return false;
+
+        // Notifications trail the mempool, so make sure nothing selected has left it
+        for (const CTransactionRef& tx : slot.vtx)
+            if (mempool.mapTx.find(tx->GetHash()) == mempool.mapTx.end())
+                return false;
+    }
+
+    pblock->vtx.insert(pblock->vtx.end(), slot.vtx.begin(), slot.vtx.end());
+    pblocktemplate->vTxFees.insert(pblocktemplate->vTxFees.end(), slot.vTxFees.begin(), slot.vTxFees.end());
+    pblocktemplate->vTxSigOpsCost.insert(pblocktemplate->vTxSigOpsCost.end(), slot.vTxSigOpsCost.begin(), slot.vTxSigOpsCost.end());
+    nBlockWeight = slot.nBlockWeight;
+    nBlockTx = slot.vtx.size();
+    nBlockSigOpsCost = slot.nBlockSigOpsCost;
+    nFees = slot.nFees;
+
+    // Append the transactions added since, as long as selecting from scratch would have taken them too
+    nAppended = 0;
+    bool fRebuild = false;
+    for (const CTransactionRef& tx : slot.vAdded) {
+        if (slot.setTxids.count(tx->GetHash()))
+            continue;
+        CTxMemPool::txiter it = mempool.mapTx.find(tx->GetHash());
+        if (it == mempool.mapTx.end())
+            continue;
+
+        CFeeRate feeRate(it->GetModifiedFee(), it->GetTxSize());
+        if (it->GetModifiedFee() < blockMinFeeRate.GetFee(it->GetTxSize()))
+            continue;
+
+        // Packages are only selected whole; a transaction waiting on an unselected parent could pull it in
+        for (CTxMemPool::txiter parent : mempool.GetMemPoolParents(it))
+            if (!slot.setTxids.count(parent->GetTx().GetHash()))
+                fRebuild = true;
+        if (fRebuild)
+            break;
+
+        // A full block may be worth reshuffling for a better paying transaction
+        if (!TestPackage(it->GetTxSize(), it->GetSigOpCost())) {
+            if (feeRate > slot.lowestFeeRate) {
+                fRebuild = true;
+                break;
+            }
+            continue;
+        }
+
+        CTxMemPool::setEntries package;
+        package.insert(it);
+        if (!TestPackageTransactions(package))
+            continue;
+
+        AddToBlock(it);
+        slot.vtx.push_back(it->GetSharedTx());
+        slot.vTxFees.push_back(it->GetFee());
+        slot.vTxSigOpsCost.push_back(it->GetSigOpCost());
+        slot.setTxids.insert(tx->GetHash());
+        if (feeRate < slot.lowestFeeRate)
+            slot.lowestFeeRate = feeRate;
+        nAppended++;
+    }
+
+    if (fRebuild) {
+        slot.fValid = false;
+        pblock->vtx.resize(1);
+        pblocktemplate->vTxFees.resize(1);
+        pblocktemplate->vTxSigOpsCost.resize(1);
+        nBlockWeight = 4000;
+        nBlockSigOpsCost = 400;
+        nBlockTx = 0;
+        nFees = 0;
+        inBlock.clear();
+        return false;
+    }
+
+    slot.nBlockWeight = nBlockWeight;
+    slot.nBlockSigOpsCost = nBlockSigOpsCost;
+    slot.nFees = nFees;
+    slot.nTransactionsUpdated = nTransactionsUpdated;
+    slot.vAdded.clear();
+
+    // Appended transactions were each accepted to the mempool on this tip with their parents in the block
+    fTested = slot.fTested;
+    return true;
+}
+
+void BlockAssembler::StoreTemplateCache(const CBlockIndex* pindexPrev, bool fTested)
+{
+    AssertLockHeld(mempool.cs);
+
+    LOCK(templateCache.cs);
+    CTemplateSelection& slot = templateCache.slots[fIncludeBCTs];
+    slot.fValid = true;
+    slot.hashPrevBlock = pindexPrev->GetBlockHash();
+    slot.nHeight = nHeight;
+    slot.nLockTimeCutoff = nLockTimeCutoff;
+    slot.nBlockMaxWeight = nBlockMaxWeight;
+    slot.blockMinFeeRate = blockMinFeeRate;
+    slot.fIncludeWitness = fIncludeWitness;
+    slot.nTransactionsUpdated = mempool.GetTransactionsUpdated();
+    slot.fTested = fTested;
+    slot.lowestFeeRate = CFeeRate(MAX_MONEY);
+
+    slot.vtx.assign(pblock->vtx.begin() + 1, pblock->vtx.end());
+    slot.vTxFees.assign(pblocktemplate->vTxFees.begin() + 1, pblocktemplate->vTxFees.end());
+    slot.vTxSigOpsCost.assign(pblocktemplate->vTxSigOpsCost.begin() + 1, pblocktemplate->vTxSigOpsCost.end());
+    slot.setTxids.clear();
+    for (const CTxMemPool::txiter it : inBlock) {
+        slot.setTxids.insert(it->GetTx().GetHash());
+        CFeeRate feeRate(it->GetModifiedFee(), it->GetTxSize());
+        if (feeRate < slot.lowestFeeRate)
+            slot.lowestFeeRate = feeRate;
+    }
+    slot.nBlockWeight = nBlockWeight;
+    slot.nBlockSigOpsCost = nBlockSigOpsCost;
+    slot.nFees = nFees;
+    slot.vAdded.clear();
+}
+
 // Thor: Forge: If forgeProofScript is passed, create a Forge block instead of a PoW block
-std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, bool fMineWitnessTx, const CScript* forgeProofScript)
+std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, bool fMineWitnessTx, const CScript* forgeProofScript, bool fTestValidity, bool fCachedSelectionOnly)
 {
     int64_t nTimeStart = GetTimeMicros();
 
@@ -179,7 +438,16 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     if (forgeProofScript)
         fIncludeBCTs = false;
 
-    addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+    // Thor: Incremental templates: Carry on from the last selection on this tip if there is one
+    bool fTested = false;
+    int nAppended = 0;
+    const bool fCached = ResumeFromTemplateCache(pindexPrev, fTested, nAppended);
+    if (!fCached) {
+        if (fCachedSelectionOnly)
+            return nullptr;
+        addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+        StoreTemplateCache(pindexPrev, fTestValidity);
+    }
 
     int64_t nTime1 = GetTimeMicros();
 
@@ -237,14 +505,25 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     pblock->nNonce = forgeProofScript ? chainparams.GetConsensus().forgeNonceMarker : 0;
     pblocktemplate->vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
 
+    // Thor: Incremental templates: A cached body that already passed is only tested again after a rebuild
     CValidationState state;
-    if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
-        throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
+    if (fTestValidity && !(fCached && fTested)) {
+        if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
+            InvalidateBlockTemplateCache();
+            throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
+        }
+        if (fCached) {
+            LOCK(templateCache.cs);
+            templateCache.slots[fIncludeBCTs].fTested = true;
+        }
     }
 
     int64_t nTime2 = GetTimeMicros();
 
-    LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+    if (fCached)
+        LogPrint(BCLog::BENCH, "CreateNewBlock() cached selection: %.2fms (%d appended), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nAppended, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+    else
+        LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
 
     return std::move(pblocktemplate);
 }
@@ -523,6 +802,22 @@ void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned
     pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
 }
 
+// Thor: Forge: Bump the tip generation whenever the active chain moves
+class CHammerKeeperNotifier : public CValidationInterface
+{
+protected:
+    void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(mutexTipGeneration);
+            nTipGeneration++;
+        }
+        condTipGeneration.notify_all();
+    }
+};
+
+static CHammerKeeperNotifier hammerKeeperNotifier;
+
 // Thor: Forge: Hammer management thread
 void HammerKeeper(const CChainParams& chainparams) {
     const Consensus::Params& consensusParams = chainparams.GetConsensus();
@@ -530,106 +825,411 @@ void HammerKeeper(const CChainParams& chainparams) {
     LogPrintf("HammerKeeper: Thread started\n");
     RenameThread("forge-hammerkeeper");
 
-    int height;
-    {
-        LOCK(cs_main);
-        height = chainActive.Tip()->nHeight;
-    }
+    RegisterValidationInterface(&hammerKeeperNotifier);
+    uint64_t generation = nTipGeneration.load();
 
     try {
         while (true) {
+            // Thor: Forge: Sleep until the tip changes
+            {
+                boost::unique_lock<boost::mutex> lock(mutexTipGeneration);
+                while (nTipGeneration.load() == generation)
+                    condTipGeneration.wait(lock);
+            }
+
             // LitecoinCash: Forge: Mining optimisations: Parameterised sleep time
             int sleepTime = std::max((int64_t) 1, gArgs.GetArg("-forgecheckdelay", DEFAULT_FORGE_CHECK_DELAY));
             MilliSleep(sleepTime);
-            int newHeight;
-            {
-                LOCK(cs_main);
-                newHeight = chainActive.Tip()->nHeight;
-            }
-            if (newHeight != height) {
-                // Height changed; release the hammers!
-                height = newHeight;
-                try {
-                    BusyHammers(consensusParams, height);
-                } catch (const std::runtime_error &e) {
-                    LogPrintf("! HammerKeeper: Error: %s\n", e.what());
-                }
+
+            // Tip changed; release the hammers! A later tip change aborts this check and triggers the next one
+            generation = nTipGeneration.load();
+            try {
+                BusyHammers(consensusParams, generation);
+            } catch (const std::runtime_error &e) {
+                LogPrintf("! HammerKeeper: Error: %s\n", e.what());
             }
         }
     } catch (const boost::thread_interrupted&) {
+        UnregisterValidationInterface(&hammerKeeperNotifier);
         LogPrintf("!!! HammerKeeper: FATAL: Thread interrupted\n");
         throw;
     }
 }
 
-// LitecoinCash: Forge: Mining optimisations: Thread to signal abort on new block
-void AbortWatchThread(int height) {
-    // Loop until any exit condition
-    while (true) {
-        // Yield to OS
-        MilliSleep(1);
+// Thor: Forge: A chunk of hammer ranges, checked on the hammer check queue. Chunks are small and
+// idle workers take the next one off the shared queue, so uneven or busy cores just check fewer
+// of them instead of holding up the rest.
+class CHammerChunkCheck
+{
+private:
+    std::vector<CHammerRange> chunk;
+    CHammerHasher randHasher;
+    arith_uint256 hammerHashTarget;
+    uint64_t generation;
+    bool fEarlyOut;
+    int64_t nStartTime;     // When the check started, for the time to solution
+
+public:
+    CHammerChunkCheck() : generation(0), fEarlyOut(false), nStartTime(0) {}
+    CHammerChunkCheck(std::vector<CHammerRange>& chunkIn, const CHammerHasher& randHasherIn, const arith_uint256& hammerHashTargetIn, uint64_t generationIn, bool fEarlyOutIn, int64_t nStartTimeIn) :
+        randHasher(randHasherIn), hammerHashTarget(hammerHashTargetIn), generation(generationIn), fEarlyOut(fEarlyOutIn), nStartTime(nStartTimeIn) { chunk.swap(chunkIn); }
+
+    // Returns false once there's no point checking further chunks (solution found, tip moved or shutting down)
+    bool operator()();
+
+    void swap(CHammerChunkCheck& check) {
+        chunk.swap(check.chunk);
+        std::swap(randHasher, check.randHasher);
+        std::swap(hammerHashTarget, check.hammerHashTarget);
+        std::swap(generation, check.generation);
+        std::swap(fEarlyOut, check.fEarlyOut);
+        std::swap(nStartTime, check.nStartTime);
+    }
+};
+
+// Thor: Forge: Persistent workers for the hammer check; the HammerKeeper joins in as the last one
+static CCheckQueue<CHammerChunkCheck> hammercheckqueue(1);
+
+// Thor: Forge: Hammer check slot of the current thread (0 for the thread running the check, 1.. for workers)
+static thread_local int nHammerCheckSlot = 0;
+static std::atomic<int> nHammerCheckSlots(0);
+
+static CCriticalSection cs_hammer_check_stats;
+static CHammerCheckStats hammerCheckStats;
+static int64_t nSolutionTime;                   // Time to first solution of the current check (protected by cs_solution_vars)
+
+// Thor: Forge: Pin the calling thread to a core, where supported
+static void SetHammerCheckAffinity(int nCore) {
+#ifdef __linux__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(nCore, &cpuset);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (err != 0)
+        LogPrintf("ThreadHammerCheck: Couldn't pin thread to core %i (error %i)\n", nCore, err);
+#else
+    LogPrintf("ThreadHammerCheck: -forgecheckaffinity is not supported on this platform\n");
+#endif
+}
 
-        // Check pre-existing abort conditions
-        if (solutionFound.load() || earlyAbort.load())
-            return;
+void ThreadHammerCheck() {
+    RenameThread("forge-hammerch");
+    nHammerCheckSlot = ++nHammerCheckSlots;
+    if (gArgs.GetBoolArg("-forgecheckaffinity", DEFAULT_FORGE_CHECK_AFFINITY))
+        SetHammerCheckAffinity(nHammerCheckSlot % GetNumVirtualCores());   // Core 0 is left to the HammerKeeper and the rest of the node
+    hammercheckqueue.Thread();
+}
 
-        // Get tip height, keeping lock scope as short as possible
-        int newHeight;
-        {
-            LOCK(cs_main);
-            newHeight = chainActive.Tip()->nHeight;
+// Thor: Forge: Number of threads (including the HammerKeeper) to check hammers with
+int GetForgeCheckThreads() {
+    int coreCount = GetNumVirtualCores();
+    int threadCount = gArgs.GetArg("-forgecheckthreads", DEFAULT_FORGE_THREADS);
+    if (threadCount == -2)
+        threadCount = std::max(1, coreCount - 1);
+    else if (threadCount < 0 || threadCount > coreCount)
+        threadCount = coreCount;
+    else if (threadCount == 0)
+        threadCount = 1;
+    return threadCount;
+}
+
+CHammerCheckStats GetHammerCheckStats() {
+    LOCK(cs_hammer_check_stats);
+    return hammerCheckStats;
+}
+
+// Thor: Forge: Check a single chunk
+bool CHammerChunkCheck::operator()() {
+    if (solutionFound.load() || nRemoteSolutionGeneration.load() == generation || (fEarlyOut && nTipGeneration.load() != generation) || ShutdownRequested())
+        return false;
+
+    int64_t nTime = GetTimeMicros();
+    uint64_t nHammers = 0;
+    bool fSolved = false;
+    for (const CHammerRange& hammerRange : chunk) {
+        CHammerHasher bctHasher = randHasher.ForBCT(hammerRange.txid);  // Thor: Forge: Hash the txid once per range
+        for (int i = hammerRange.offset; i < hammerRange.offset + hammerRange.count && !fSolved; i++) {
+            nHammers++;
+            // Hash the hammer, compare to target and write out result if successful
+            if (bctHasher.CheckHash(i, hammerHashTarget)) {
+                LOCK(cs_solution_vars);                                 // Expensive mutex only happens at write-out
+                if (!solutionFound.load()) {
+                    solutionFound.store(true);
+                    solutionRange = hammerRange;
+                    solutionHammer = i;
+                    nSolutionTime = GetTimeMicros() - nStartTime;
+                }
+                fSolved = true;
+            }
         }
+        if (fSolved)
+            break;
+    }
+    nTime = GetTimeMicros() - nTime;
 
-        // Check for abort from tip height change
-        if (newHeight != height) {
-            //LogPrintf("*** ABORT FIRE\n");
-            earlyAbort.store(true);
-            return;
+    {
+        LOCK(cs_hammer_check_stats);
+        if (hammerCheckStats.vThreads.size() <= (size_t)nHammerCheckSlot)
+            hammerCheckStats.vThreads.resize(nHammerCheckSlot + 1);
+        CHammerCheckThreadStats& threadStats = hammerCheckStats.vThreads[nHammerCheckSlot];
+        threadStats.nChunks++;
+        threadStats.nHammers += nHammers;
+        threadStats.nTimeMicros += nTime;
+    }
+
+    return !fSolved;
+}
+
+// Thor: Forge: Cut hammer ranges into chunks of HAMMER_CHECK_CHUNK_SIZE hammers, packed across BCTs
+std::vector<std::vector<CHammerRange>> SplitHammerChunks(const std::vector<CHammerRange>& ranges) {
+    std::vector<std::vector<CHammerRange>> vChunks(1);
+    int hammersInChunk = 0;
+    for (const CHammerRange& range : ranges) {
+        int offset = range.offset;
+        while (offset < range.offset + range.count) {
+            int count = std::min(range.offset + range.count - offset, HAMMER_CHECK_CHUNK_SIZE - hammersInChunk);
+            CHammerRange part = {range.txid, range.goldAddress, range.communityContrib, offset, count};
+            vChunks.back().push_back(part);
+            offset += count;
+            hammersInChunk += count;
+            if (hammersInChunk == HAMMER_CHECK_CHUNK_SIZE) {
+                vChunks.emplace_back();
+                hammersInChunk = 0;
+            }
         }
     }
+    if (vChunks.back().empty())
+        vChunks.pop_back();
+
+    return vChunks;
 }
 
-// LitecoinCash: Forge: Mining optimisations: Thread to check a single bin
-void CheckBin(int threadID, std::vector<CHammerRange> bin, std::string deterministicRandString, arith_uint256 hammerHashTarget) {
-    // Iterate over ranges in this bin
-    int checkCount = 0;
-    for (std::vector<CHammerRange>::const_iterator it = bin.begin(); it != bin.end(); it++) {
-        CHammerRange hammerRange = *it;
-        //LogPrintf("THREAD #%i: Checking %i-%i in %s\n", threadID, hammerRange.offset, hammerRange.offset + hammerRange.count - 1, hammerRange.txid);
-        // Iterate over hammers in this range
-        for (int i = hammerRange.offset; i < hammerRange.offset + hammerRange.count; i++) {
-            // Check abort conditions (Only every N hammers. The atomic load is expensive, but much cheaper than a mutex - esp on Windows, see https://www.arangodb.com/2015/02/comparing-atomic-mutex-rwlocks/)
-            if(checkCount++ % 1000 == 0) {
-                if (solutionFound.load() || earlyAbort.load()) {
-                    //LogPrintf("THREAD #%i: Solution found elsewhere or early abort requested, ending early\n", threadID);
-                    return;
-                }
+// Thor: Forge: Check the given hammer chunks against the target on the hammer check workers
+bool CheckHammers(std::vector<std::vector<CHammerRange>> vChunks, const CDeterministicRand& deterministicRand, const arith_uint256& hammerHashTarget, uint64_t generation, bool fEarlyOut, CHammerRange& solvingRangeOut, uint32_t& solvingHammerOut) {
+    uint64_t totalHammers = 0;
+    for (const std::vector<CHammerRange>& chunk : vChunks)
+        for (const CHammerRange& part : chunk)
+            totalHammers += part.count;
+
+    // Queue a check for each chunk, for as many workers as -forgecheckthreads calls for (the caller is the last)
+    hammercheckqueue.SetMaxWorkers(GetForgeCheckThreads() - 1);
+    int64_t nStartTime = GetTimeMicros();
+    CHammerHasher randHasher(deterministicRand);                       // Thor: Forge: Hash the shared rand string prefix once per check
+    std::vector<CHammerChunkCheck> vChecks;
+    vChecks.reserve(vChunks.size());
+    for (size_t i = 0; i < vChunks.size(); i++)
+        vChecks.emplace_back(vChunks[i], randHasher, hammerHashTarget, generation, fEarlyOut, nStartTime);
+
+    {
+        LOCK(cs_solution_vars);
+        solutionFound.store(false);
+        nSolutionTime = -1;
+    }
+
+    // Wait for the chunk checks to find a solution or abort (in which case the others will all stop), or to run out of hammers
+    {
+        CCheckQueueControl<CHammerChunkCheck> control(&hammercheckqueue);
+        control.Add(vChecks);
+        control.Wait();
+    }
+
+    bool fSolved;
+    int64_t nCheckTime = GetTimeMicros() - nStartTime;
+    {
+        LOCK(cs_solution_vars);
+        fSolved = solutionFound.load();
+        if (fSolved) {
+            solvingRangeOut = solutionRange;
+            solvingHammerOut = solutionHammer;
+        }
+
+        LOCK(cs_hammer_check_stats);
+        hammerCheckStats.nChecks++;
+        hammerCheckStats.nLastHammers = totalHammers;
+        hammerCheckStats.nLastCheckMicros = nCheckTime;
+        hammerCheckStats.nLastSolutionMicros = fSolved ? nSolutionTime : -1;
+        if (fSolved) {
+            hammerCheckStats.nSolutions++;
+            hammerCheckStats.nSolutionMicros += nSolutionTime;
+        }
+    }
+
+    return fSolved;
+}
+
+// Thor: Forge: Publish chunks of a check as work for remote workers
+static void PublishForgeWork(uint64_t generation, const CBlockIndex* pindexPrev, const CDeterministicRand& deterministicRand, const arith_uint256& hammerHashTarget, const std::vector<std::vector<CHammerRange>>& vChunks) {
+    {
+        boost::unique_lock<boost::mutex> lock(mutexTipGeneration);
+        forgeWork.workId = strprintf("%u", generation);
+        forgeWork.nHeight = pindexPrev->nHeight + 1;
+        forgeWork.hashPrevBlock = pindexPrev->GetBlockHash();
+        forgeWork.deterministicRandString = deterministicRand.ToString();
+        forgeWork.hammerHashTarget = hammerHashTarget;
+        forgeWork.chunks.clear();
+        vForgeWorkRanges.clear();
+        for (const std::vector<CHammerRange>& chunk : vChunks) {
+            forgeWork.chunks.emplace_back();
+            for (const CHammerRange& part : chunk) {
+                CForgeWorkRange workRange = {part.txid, part.offset, part.count};
+                forgeWork.chunks.back().push_back(workRange);
+                vForgeWorkRanges.push_back(part);
             }
-            // Hash the hammer
-            std::string hashHex = (CHashWriter(SER_GETHASH, 0) << deterministicRandString << hammerRange.txid << i).GetHash().GetHex();
-            arith_uint256 hammerHash = arith_uint256(hashHex);
-            // Compare to target and write out result if successful
-            if (hammerHash < hammerHashTarget) {
-                //LogPrintf("THREAD #%i: Solution found, returning\n", threadID);
-                LOCK(cs_solution_vars);                                 // Expensive mutex only happens at write-out
-                solutionFound.store(true);
-                solvingRange = hammerRange;
-                solvingHammer = i;
-                return;
+        }
+        forgeWorkHasher = CHammerHasher(deterministicRand);
+        nForgeWorkGeneration = generation;
+    }
+    condTipGeneration.notify_all();
+}
+
+// Thor: Forge: Wait for a remote worker to solve the given generation; gives up when the tip moves
+static bool WaitForRemoteForgeSolution(uint64_t generation, CHammerRange& solvingRangeOut, uint32_t& solvingHammerOut) {
+    boost::unique_lock<boost::mutex> lock(mutexTipGeneration);
+    while (nRemoteSolutionGeneration.load() != generation && nTipGeneration.load() == generation)
+        condTipGeneration.wait(lock);
+
+    if (nRemoteSolutionGeneration.load() != generation)
+        return false;
+    solvingRangeOut = remoteSolutionRange;
+    solvingHammerOut = remoteSolutionHammer;
+    return true;
+}
+
+// Thor: Forge: Id of the work remote workers should be on; it goes idle as soon as the tip moves or the work is solved (call with mutexTipGeneration held)
+static std::string GetCurrentForgeWorkId() {
+    if (nForgeWorkGeneration != nTipGeneration.load() || nRemoteSolutionGeneration.load() == nForgeWorkGeneration)
+        return CForgeWork().workId;
+    return forgeWork.workId;
+}
+
+void GetForgeWork(CForgeWork& work, const std::string& longPollId, int64_t nTimeoutMillis) {
+    boost::unique_lock<boost::mutex> lock(mutexTipGeneration);
+    int64_t nDeadline = GetTimeMillis() + nTimeoutMillis;
+    while (GetCurrentForgeWorkId() == longPollId && !ShutdownRequested()) {
+        int64_t nWait = std::min(nDeadline - GetTimeMillis(), (int64_t)1000);  // Wake up now and then to notice shutdown
+        if (nWait <= 0)
+            break;
+        condTipGeneration.timed_wait(lock, boost::posix_time::milliseconds(nWait));
+    }
+
+    if (GetCurrentForgeWorkId() == forgeWork.workId)
+        work = forgeWork;
+    else
+        work = CForgeWork();
+}
+
+std::string SubmitForgeSolution(const std::string& workId, const uint256& txid, uint32_t nonce) {
+    {
+        boost::unique_lock<boost::mutex> lock(mutexTipGeneration);
+        if (workId != GetCurrentForgeWorkId())
+            return "stale";
+
+        std::string txidStr = txid.GetHex();
+        std::vector<CHammerRange>::const_iterator it = vForgeWorkRanges.begin();
+        while (it != vForgeWorkRanges.end() && !(it->txid == txidStr && (int64_t)nonce >= it->offset && (int64_t)nonce < it->offset + it->count))
+            it++;
+        if (it == vForgeWorkRanges.end())
+            return "unknown-hammer";
+
+        if (!forgeWorkHasher.ForBCT(txidStr).CheckHash(nonce, forgeWork.hammerHashTarget))
+            return "high-hash";
+
+        remoteSolutionRange = *it;
+        remoteSolutionHammer = nonce;
+        nRemoteSolutionGeneration.store(nForgeWorkGeneration);
+    }
+    condTipGeneration.notify_all();
+
+    LogPrintf("SubmitForgeSolution: Accepted remote solution with hammer #%i from BCT %s for work %s\n", nonce, txid.GetHex(), workId);
+    return "";
+}
+
+// Thor: Forge: Everything a Forge block's proof needs that doesn't depend on which hammer solves,
+// prepared as soon as the tip arrives
+struct CForgeProofPrep
+{
+    std::map<std::string, std::vector<unsigned char>> mapGoldSigs;  // Gold address -> compact sig over the deterministic rand (empty if it can't sign)
+    std::map<std::string, uint32_t> mapBCTHeights;                   // BCT txid -> height it was mined at
+};
+
+// Thor: Forge: Sign the deterministic rand once per gold address and look up each BCT's height. Ranges
+// that can't be given a proof are dropped, since a solution from one of them couldn't be used anyway.
+static void PrepareForgeProofs(CWallet* pwallet, const CDeterministicRand& deterministicRand, std::vector<CHammerRange>& hammerRanges, CForgeProofPrep& prep) {
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << deterministicRand;
+    uint256 mhash = ss.GetHash();
+
+    std::vector<CHammerRange> preparedRanges;
+    LOCK2(cs_main, pwallet->cs_wallet);
+    for (const CHammerRange& range : hammerRanges) {
+        auto itSig = prep.mapGoldSigs.find(range.goldAddress);
+        if (itSig == prep.mapGoldSigs.end()) {
+            itSig = prep.mapGoldSigs.emplace(range.goldAddress, std::vector<unsigned char>()).first;
+            CTxDestination dest = DecodeDestination(range.goldAddress);
+            const CKeyID *keyID = boost::get<CKeyID>(&dest);
+            CKey key;
+            if (!keyID || !pwallet->GetKey(*keyID, key) || !key.SignCompact(mhash, itSig->second)) {
+                LogPrintf("BusyHammers: Can't sign for gold address %s; skipping its hammers\n", range.goldAddress);
+                itSig->second.clear();
             }
         }
+        if (itSig->second.empty())
+            continue;
+
+        Coin coin;
+        if (!pcoinsTip || !pcoinsTip->GetCoin(COutPoint(uint256S(range.txid), 0), coin)) {
+            LogPrintf("BusyHammers: Couldn't get the utxo for BCT %s; skipping its hammers\n", range.txid);
+            continue;
+        }
+        prep.mapBCTHeights[range.txid] = coin.nHeight;
+        preparedRanges.push_back(range);
     }
-    //LogPrintf("THREAD #%i: Out of tasks\n", threadID);
+    hammerRanges.swap(preparedRanges);
 }
 
+// Thor: Forge: Assemble a Forge proof script (see CheckForgeProof for the layout)
+static CScript MakeForgeProofScript(uint32_t hammerNonce, uint32_t bctHeight, bool communityContrib, const std::string& txid, const std::vector<unsigned char>& messageProofVec) {
+    unsigned char hammerNonceEncoded[4];
+    WriteLE32(hammerNonceEncoded, hammerNonce);
+    std::vector<unsigned char> hammerNonceVec(hammerNonceEncoded, hammerNonceEncoded + 4);
+
+    unsigned char bctHeightEncoded[4];
+    WriteLE32(bctHeightEncoded, bctHeight);
+    std::vector<unsigned char> bctHeightVec(bctHeightEncoded, bctHeightEncoded + 4);
+
+    std::vector<unsigned char> txidVec(txid.begin(), txid.end());
+    opcodetype communityContribFlag = communityContrib ? OP_TRUE : OP_FALSE;
 
+    CScript forgeProofScript;
+    forgeProofScript << OP_RETURN << OP_HAMMER << hammerNonceVec << bctHeightVec << communityContribFlag << txidVec << messageProofVec;
+    return forgeProofScript;
+}
+
+// Thor: Forge: Build a Forge block on pindexPrev while its hammers are being checked. The proof is a placeholder of
+// the right size, so the block's weight is already final; a solution only needs writing into the coinbase. The body
+// is tested as usual (TestBlockValidity leaves the proof to ProcessNewBlock); if it fails, the solved block is built from scratch.
+static std::unique_ptr<CBlockTemplate> CreateSpeculativeForgeBlock(const CBlockIndex* pindexPrev, const CScript& goldScript) {
+    CScript placeholderProofScript = MakeForgeProofScript(0, 0, false, std::string(64, '0'), std::vector<unsigned char>(CPubKey::COMPACT_SIGNATURE_SIZE, 0));
+    std::unique_ptr<CBlockTemplate> pblocktemplate;
+    try {
+        pblocktemplate = BlockAssembler(Params()).CreateNewBlock(goldScript, true, &placeholderProofScript);
+    } catch (const std::runtime_error& e) {
+        LogPrintf("BusyHammers: Couldn't create speculative block: %s\n", e.what());
+        return nullptr;
+    }
+    if (pblocktemplate && pblocktemplate->block.hashPrevBlock != pindexPrev->GetBlockHash())
+        return nullptr;     // The tip moved while it was being built
+    return pblocktemplate;
+}
 
 // Thor: Forge: Attempt to mint the next block
-bool BusyHammers(const Consensus::Params& consensusParams, int height) {
+bool BusyHammers(const Consensus::Params& consensusParams, uint64_t generation) {
     bool verbose = LogAcceptCategory(BCLog::FORGE);
 
-    CBlockIndex* pindexPrev = chainActive.Tip();
-    assert(pindexPrev != nullptr);
+    // Thor: Work from the published tip; the checks below never need cs_main
+    CTipSnapshotRef tip = GetTipSnapshot();
+    assert(tip != nullptr);
+    const CBlockIndex* pindexPrev = tip->pindex;
 
     // Sanity checks
     if (!IsForgeEnabled(pindexPrev, consensusParams)) {
@@ -650,20 +1250,14 @@ bool BusyHammers(const Consensus::Params& consensusParams, int height) {
     }
     // LitecoinCash: Forge 1.1: Check that there aren't too many consecutive Forge blocks
     if (IsForge11Enabled(pindexPrev, consensusParams)) {
-        int forgeBlocksAtTip = 0;
-        CBlockIndex* pindexTemp = pindexPrev;
-        while (pindexTemp->GetBlockHeader().IsForgeMined(consensusParams)) {
-            assert(pindexTemp->pprev);
-            pindexTemp = pindexTemp->pprev;
-            forgeBlocksAtTip++;
-        }
+        int forgeBlocksAtTip = pindexPrev->nForgeBlocksAtTip;
         if (forgeBlocksAtTip >= consensusParams.maxConsecutiveForgeBlocks) {
             LogPrintf("BusyHammers: Skipping forge check (max Forge blocks without a POW block reached)\n");
             return false;
         }
     } else {
         // Check previous block wasn't forgemined
-        if (pindexPrev->GetBlockHeader().IsForgeMined(consensusParams)) {
+        if (pindexPrev->IsForgeMined(consensusParams)) {
             LogPrintf("BusyHammers: Skipping forge check (Forge block must follow a POW block)\n");
             return false;
         }
@@ -684,8 +1278,8 @@ bool BusyHammers(const Consensus::Params& consensusParams, int height) {
     LogPrintf("********************* Forge: Hammers at work *********************\n");
 
     // Find deterministicRandString
-    std::string deterministicRandString = GetDeterministicRandString(pindexPrev);
-    if (verbose) LogPrintf("BusyHammers: deterministicRandString   = %s\n", deterministicRandString);
+    CDeterministicRand deterministicRand = GetDeterministicRand(pindexPrev);
+    if (verbose) LogPrintf("BusyHammers: deterministicRandString   = %s\n", deterministicRand.ToString());
 
     // Find hammerHashTarget
     arith_uint256 hammerHashTarget;
@@ -693,14 +1287,16 @@ bool BusyHammers(const Consensus::Params& consensusParams, int height) {
     if (verbose) LogPrintf("BusyHammers: hammerHashTarget             = %s\n", hammerHashTarget.ToString());
 
 
+    // Collect the ready hammers
     std::vector<CHammerCreationTransactionInfo> bcts = pwallet->GetBCTs(false, false, consensusParams);
+    std::vector<CHammerRange> hammerRanges;
     int totalHammers = 0;
-    for (std::vector<CHammerCreationTransactionInfo>::const_iterator it = bcts.begin(); it != bcts.end(); it++) {
-        CHammerCreationTransactionInfo bct = *it;
-
+    for (const CHammerCreationTransactionInfo& bct : bcts) {
         if (bct.hammerStatus != "ready")
             continue;
-       totalHammers += bct.hammerCount;
+        CHammerRange range = {bct.txid, bct.goldAddress, bct.communityContrib, 0, bct.hammerCount};
+        hammerRanges.push_back(range);
+        totalHammers += bct.hammerCount;
     }
 
     if (totalHammers == 0) {
@@ -708,187 +1304,82 @@ bool BusyHammers(const Consensus::Params& consensusParams, int height) {
         return false;
     }
 
-    int coreCount = GetNumVirtualCores();
-    int threadCount = gArgs.GetArg("-forgecheckthreads", DEFAULT_FORGE_THREADS);
-    if (threadCount == -2)
-        threadCount = std::max(1, coreCount - 1);
-    else if (threadCount < 0 || threadCount > coreCount)
-        threadCount = coreCount;
-    else if (threadCount == 0)
-        threadCount = 1;
-
-    int hammersPerBin = ceil(totalHammers / (float)threadCount);  // We want to check this many hammers per thread
-
-    // Bin the hammers according to desired thead count
-    if (verbose) LogPrint(BCLog::FORGE, "BusyHammers: Binning %i hammers in %i bins (%i hammers per bin)\n", totalHammers, threadCount, hammersPerBin);
-    std::vector<CHammerCreationTransactionInfo>::const_iterator bctIterator = bcts.begin();
-    CHammerCreationTransactionInfo bct = *bctIterator;
-    std::vector<std::vector<CHammerRange>> hammerBins;
-    int hammerOffset = 0;                                      // Track offset in current BCT
-    while(bctIterator != bcts.end()) {                      // Until we're out of BCTs
-        std::vector<CHammerRange> currentBin;                  // Create a new bin
-        int hammersInBin = 0;
-        while (bctIterator != bcts.end()) {                 // Keep filling it until full
-            int spaceLeft = hammersPerBin - hammersInBin;
-            if (bct.hammerCount - hammerOffset <= spaceLeft) {    // If there's soom, add all the hammers from this BCT...
-                CHammerRange range = {bct.txid, bct.goldAddress, bct.communityContrib, hammerOffset, bct.hammerCount - hammerOffset};
-                currentBin.push_back(range);
-
-                hammersInBin += bct.hammerCount - hammerOffset;
-                hammerOffset = 0;
-
-                do {                                        // ... and iterate to next BCT
-                    bctIterator++;
-                    if (bctIterator == bcts.end())
-                        break;
-                    bct = *bctIterator;
-                } while (bct.hammerStatus != "mature");
-            } else {                                        // Can't fit the whole thing to current bin; add what we can fit and let the rest go in next bin
-                CHammerRange range = {bct.txid, bct.goldAddress, bct.communityContrib, hammerOffset, spaceLeft};
-                currentBin.push_back(range);
-                hammerOffset += spaceLeft;
-                break;
-            }
+    // Sign and locate the BCTs now, and build the block body while the hammers are checked, so a solution becomes a block at once
+    CForgeProofPrep prep;
+    PrepareForgeProofs(pwallet, deterministicRand, hammerRanges, prep);
+    totalHammers = 0;
+    for (const CHammerRange& range : hammerRanges)
+        totalHammers += range.count;
+    if (totalHammers == 0)
+        return false;
+    std::future<std::unique_ptr<CBlockTemplate>> futureTemplate = std::async(std::launch::async, CreateSpeculativeForgeBlock, pindexPrev,
+        GetScriptForDestination(DecodeDestination(hammerRanges[0].goldAddress)));
 
-        }
+    int threadCount = GetForgeCheckThreads();
+    if (verbose) LogPrint(BCLog::FORGE, "BusyHammers: Checking %i hammers from %i BCTs in chunks of %i with %i threads\n", totalHammers, hammerRanges.size(), HAMMER_CHECK_CHUNK_SIZE, threadCount);
 
-        hammerBins.push_back(currentBin);
-    }
-
-    // Create a worker thread for each bin
-    if (verbose) LogPrintf("BusyHammers: Running bins\n");
-    solutionFound.store(false);
-    earlyAbort.store(false);
-    std::vector<std::vector<CHammerRange>>::const_iterator hammerBinIterator = hammerBins.begin();
-    std::vector<boost::thread> binThreads;
+    bool fEarlyOut = gArgs.GetBoolArg("-forgeearlyout", DEFAULT_FORGE_EARLY_OUT);
+    CHammerRange solvingRange;
+    uint32_t solvingHammer;
     int64_t checkTime = GetTimeMillis();
-    int binID = 0;
-    while (hammerBinIterator != hammerBins.end()) {
-        std::vector<CHammerRange> hammerBin = *hammerBinIterator;
-
-        if (verbose) {
-            LogPrintf("BusyHammers: Bin #%i\n", binID);
-            std::vector<CHammerRange>::const_iterator hammerRangeIterator = hammerBin.begin();
-            while (hammerRangeIterator != hammerBin.end()) {
-                CHammerRange hammerRange = *hammerRangeIterator;
-                LogPrintf("offset = %i, count = %i, txid = %s\n", hammerRange.offset, hammerRange.count, hammerRange.txid);
-                hammerRangeIterator++;
-            }
-        }
-        binThreads.push_back(boost::thread(CheckBin, binID++, hammerBin, deterministicRandString, hammerHashTarget));
-
-        hammerBinIterator++;
+    std::vector<std::vector<CHammerRange>> vChunks = SplitHammerChunks(hammerRanges);
+    bool fForgeWork = gArgs.GetBoolArg("-forgework", DEFAULT_FORGE_WORK);
+    if (fForgeWork) {
+        // The node is one slot of the split, beside -forgeworkers remote workers: it keeps every slot'th chunk and publishes the rest
+        size_t nSlots = std::max(gArgs.GetArg("-forgeworkers", DEFAULT_FORGE_WORKERS), (int64_t)0) + 1;
+        std::vector<std::vector<CHammerRange>> vLocalChunks, vRemoteChunks;
+        for (size_t i = 0; i < vChunks.size(); i++)
+            (i % nSlots == 0 ? vLocalChunks : vRemoteChunks).push_back(std::move(vChunks[i]));
+        vChunks.swap(vLocalChunks);
+        PublishForgeWork(generation, pindexPrev, deterministicRand, hammerHashTarget, vRemoteChunks);
+        if (verbose) LogPrint(BCLog::FORGE, "BusyHammers: Checking %i chunks locally and publishing %i\n", vChunks.size(), vRemoteChunks.size());
     }
-
-   // Add an extra thread to watch external abort conditions (eg new incoming block)
-    bool useEarlyAbortThread = gArgs.GetBoolArg("-forgeearlyout", DEFAULT_FORGE_EARLY_OUT);
-    if (verbose && useEarlyAbortThread)
-        LogPrintf("BusyHammers: Will use early-abort thread\n");
-
-    boost::thread* earlyAbortThread;
-    if (useEarlyAbortThread)
-        earlyAbortThread = new boost::thread(AbortWatchThread, height);
-
-    // Wait for bin worker threads to find a solution or abort (in which case the others will all stop), or to run out of hammers
-    for(auto& t:binThreads)
-        t.join();
-
+    bool fSolved = CheckHammers(std::move(vChunks), deterministicRand, hammerHashTarget, generation, fEarlyOut, solvingRange, solvingHammer);
+    if (!fSolved && fForgeWork)     // Local hammers are exhausted (or a remote worker already solved); wait for the remote workers until the tip moves
+        fSolved = WaitForRemoteForgeSolution(generation, solvingRange, solvingHammer);
     checkTime = GetTimeMillis() - checkTime;
 
     // Handle early aborts
-    if (useEarlyAbortThread) {
-        if (earlyAbort.load()) {
-            LogPrintf("BusyHammers: Chain state changed (check aborted after %ims)\n", checkTime);
-            return false;
-        } else {
-            // We didn't abort; stop abort thread now
-            earlyAbort.store(true);
-            earlyAbortThread->join();
-        }
+    if (!fSolved && fEarlyOut && nTipGeneration.load() != generation) {
+        LogPrintf("BusyHammers: Chain state changed (check aborted after %ims)\n", checkTime);
+        return false;
     }
 
     // Check if a solution was found
-    if (!solutionFound.load()) {
+    if (!fSolved) {
         LogPrintf("BusyHammers: No hammer meets hash target (%i hammers checked with %i threads in %ims)\n", totalHammers, threadCount, checkTime);
         return false;
     }
 
     LogPrintf("BusyHammers: Hammer meets hash target (check aborted after %ims). Solution with hammer #%i from BCT %s. Gold address is %s.\n", checkTime, solvingHammer, solvingRange.txid, solvingRange.goldAddress);
 
-    // Assemble the Forge proof script
-    std::vector<unsigned char> messageProofVec;
-    std::vector<unsigned char> txidVec(solvingRange.txid.begin(), solvingRange.txid.end());
-    CScript forgeProofScript;
-    uint32_t bctHeight;
-    {   // Don't lock longer than needed
-        LOCK2(cs_main, pwallet->cs_wallet);
-
-        CTxDestination dest = DecodeDestination(solvingRange.goldAddress);
-        if (!IsValidDestination(dest)) {
-            LogPrintf("BusyHammers: Gold destination invalid\n");
-            return false;
-        }
-
-        const CKeyID *keyID = boost::get<CKeyID>(&dest);
-        if (!keyID) {
-            LogPrintf("BusyHammers: Wallet doesn't have privkey for gold destination\n");
-            return false;
-        }
-
-        CKey key;
-        if (!pwallet->GetKey(*keyID, key)) {
-            LogPrintf("BusyHammers: Privkey unavailable\n");
-            return false;
-        }
-
-        CHashWriter ss(SER_GETHASH, 0);
-        ss << deterministicRandString;
-        uint256 mhash = ss.GetHash();
-        if (!key.SignCompact(mhash, messageProofVec)) {
-            LogPrintf("BusyHammers: Couldn't sign the hammer proof!\n");
-            return false;
-        }
-        if (verbose) LogPrintf("BusyHammers: messageSig                = %s\n", HexStr(&messageProofVec[0], &messageProofVec[messageProofVec.size()]));
-
-        COutPoint out(uint256S(solvingRange.txid), 0);
-        Coin coin;
-        if (!pcoinsTip || !pcoinsTip->GetCoin(out, coin)) {
-            LogPrintf("BusyHammers: Couldn't get the bct utxo!\n");
+    // Fill the prepared proof into the speculative block, or build one from scratch if that didn't work out
+    int64_t nFinaliseStart = GetTimeMicros();
+    CScript forgeProofScript = MakeForgeProofScript(solvingHammer, prep.mapBCTHeights[solvingRange.txid], solvingRange.communityContrib, solvingRange.txid, prep.mapGoldSigs[solvingRange.goldAddress]);
+    CScript goldScript = GetScriptForDestination(DecodeDestination(solvingRange.goldAddress));
+    std::unique_ptr<CBlockTemplate> pblocktemplate = futureTemplate.get();
+    if (pblocktemplate) {
+        CMutableTransaction coinbaseTx(*pblocktemplate->block.vtx[0]);
+        coinbaseTx.vout[0].scriptPubKey = forgeProofScript;
+        coinbaseTx.vout[1].scriptPubKey = goldScript;
+        pblocktemplate->block.vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
+    } else {
+        pblocktemplate = BlockAssembler(Params()).CreateNewBlock(goldScript, true, &forgeProofScript);
+        if (!pblocktemplate.get()) {
+            LogPrintf("BusyHammers: Couldn't create block\n");
             return false;
         }
-        bctHeight = coin.nHeight;
-    }
-
-    unsigned char hammerNonceEncoded[4];
-    WriteLE32(hammerNonceEncoded, solvingHammer);
-    std::vector<unsigned char> hammerNonceVec(hammerNonceEncoded, hammerNonceEncoded + 4);
-
-    unsigned char bctHeightEncoded[4];
-    WriteLE32(bctHeightEncoded, bctHeight);
-    std::vector<unsigned char> bctHeightVec(bctHeightEncoded, bctHeightEncoded + 4);
-
-    opcodetype communityContribFlag = solvingRange.communityContrib ? OP_TRUE : OP_FALSE;
-    forgeProofScript << OP_RETURN << OP_HAMMER << hammerNonceVec << bctHeightVec << communityContribFlag << txidVec << messageProofVec;
-
-    // Create gold script from gold address
-    CScript goldScript = GetScriptForDestination(DecodeDestination(solvingRange.goldAddress));
-
-    // Create a Forge block
-    std::unique_ptr<CBlockTemplate> pblocktemplate(BlockAssembler(Params()).CreateNewBlock(goldScript, true, &forgeProofScript));
-    if (!pblocktemplate.get()) {
-        LogPrintf("BusyHammers: Couldn't create block\n");
-        return false;
     }
     CBlock *pblock = &pblocktemplate->block;
     pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);  // Calc the merkle root
+    LogPrint(BCLog::FORGE, "BusyHammers: Block assembled in %.2fms\n", 0.001 * (GetTimeMicros() - nFinaliseStart));
 
     // Make sure the new block's not stale
-    {
-        LOCK(cs_main);
-        if (pblock->hashPrevBlock != chainActive.Tip()->GetBlockHash()) {
-            LogPrintf("BusyHammers: Generated block is stale.\n");
-            return false;
-        }
+    CTipSnapshotRef tipNow = GetTipSnapshot();
+    assert(tipNow != nullptr);
+    if (pblock->hashPrevBlock != tipNow->hashBlock) {
+        LogPrintf("BusyHammers: Generated block is stale.\n");
+        return false;
     }
 
     if (verbose) {
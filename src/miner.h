@@ -6,8 +6,10 @@
 #ifndef BITCOIN_MINER_H
 #define BITCOIN_MINER_H
 
+#include <arith_uint256.h>
 #include <primitives/block.h>
 #include <txmempool.h>
+#include <uint256.h>
 
 #include <stdint.h>
 #include <memory>
@@ -18,8 +20,8 @@ class CBlockIndex;
 class CChainParams;
 class CScript;
 
-class arith_uint256;    // LitecoinCash: Hive: Mining optimisations
 struct CHammerRange;       // LitecoinCash: Hive: Mining optimisations
+struct CDeterministicRand; // Thor: Forge
 
 namespace Consensus { struct Params; };
 
@@ -28,6 +30,12 @@ static const bool DEFAULT_PRINTPRIORITY = false;
 static const int DEFAULT_FORGE_CHECK_DELAY = 1;
 static const int DEFAULT_FORGE_THREADS = -2;
 static const bool DEFAULT_FORGE_EARLY_OUT = true;
+static const bool DEFAULT_FORGE_CHECK_AFFINITY = false;
+static const bool DEFAULT_FORGE_WORK = false;
+static const int DEFAULT_FORGE_WORKERS = 1;
+
+/** Thor: Forge: Hammers per chunk handed to the hammer check workers */
+static const int HAMMER_CHECK_CHUNK_SIZE = 512;
 
 struct CBlockTemplate
 {
@@ -164,8 +172,11 @@ public:
     BlockAssembler(const CChainParams& params, const Options& options);
 
     /** Construct a new block template with coinbase to scriptPubKeyIn */
-    // Thor: Forge: If forgeProofScript is passed, create a Forge block instead of a PoW block
-    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, bool fMineWitnessTx=true, const CScript* forgeProofScript=nullptr);
+    // Thor: Forge: If forgeProofScript is passed, create a Forge block instead of a PoW block. fTestValidity=false skips
+    // TestBlockValidity, for templates whose proof is a placeholder until a hammer solves (ProcessNewBlock checks the result)
+    // Thor: Incremental templates: fCachedSelectionOnly returns nullptr instead of selecting from scratch when the cached
+    // selection can't be carried on
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, bool fMineWitnessTx=true, const CScript* forgeProofScript=nullptr, bool fTestValidity=true, bool fCachedSelectionOnly=false);
 
 private:
     // utility functions
@@ -199,8 +210,22 @@ private:
       * state updated assuming given transactions are inBlock. Returns number
       * of updated descendants. */
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx);
+
+    // Thor: Incremental templates
+    /** Fill the block from the selection cached for this tip, appending the transactions
+      * added to the mempool since. Returns false if the selection must be rebuilt. */
+    bool ResumeFromTemplateCache(const CBlockIndex* pindexPrev, bool& fTested, int& nAppended);
+    /** Store the block's transactions as the cached selection for this tip */
+    void StoreTemplateCache(const CBlockIndex* pindexPrev, bool fTested);
 };
 
+// Thor: Keep the block template transaction selection current between tip changes, from the
+// validation interface; templates are built from scratch while it isn't registered
+void RegisterBlockTemplateCache();
+void UnregisterBlockTemplateCache();
+// Thor: Drop the cached selection, for changes the validation interface doesn't report
+void InvalidateBlockTemplateCache();
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
@@ -208,9 +233,70 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
 // Thor: Forge: Hammer management thread
 void HammerKeeper(const CChainParams& chainparams);
 
-// Thor: Forge: Attempt to mint the next block
-bool BusyHammers(const Consensus::Params& consensusParams, int height);
-void CheckBin(int threadID, std::vector<CHammerRange> bin, std::string deterministicRandString, arith_uint256 hammerHashTarget); // LitecoinCash: Hive: Mining optimisations: Thread to process a bin of beeranges
-void AbortWatchThread(int height);
+// Thor: Forge: Attempt to mint the next block (generation is the tip generation the check was started for)
+bool BusyHammers(const Consensus::Params& consensusParams, uint64_t generation);
+
+// Thor: Forge: Hammer check worker thread
+void ThreadHammerCheck();
+
+// Thor: Forge: Number of threads (including the HammerKeeper) to check hammers with
+int GetForgeCheckThreads();
+
+// Thor: Forge: Cut hammer ranges into chunks of HAMMER_CHECK_CHUNK_SIZE hammers; a chunk may span several BCTs
+std::vector<std::vector<CHammerRange>> SplitHammerChunks(const std::vector<CHammerRange>& ranges);
+
+// Thor: Forge: Check the given hammer chunks (handed over to the checks) against the target on the hammer check workers, stopping at the first solution
+bool CheckHammers(std::vector<std::vector<CHammerRange>> vChunks, const CDeterministicRand& deterministicRand, const arith_uint256& hammerHashTarget, uint64_t generation, bool fEarlyOut, CHammerRange& solvingRangeOut, uint32_t& solvingHammerOut);
+
+// Thor: Forge: Hammer check statistics for one thread, since startup (slot 0 is the thread running the check)
+struct CHammerCheckThreadStats
+{
+    uint64_t nChunks;
+    uint64_t nHammers;
+    int64_t nTimeMicros;    // Time spent checking chunks
+
+    CHammerCheckThreadStats() : nChunks(0), nHammers(0), nTimeMicros(0) {}
+};
+
+struct CHammerCheckStats
+{
+    uint64_t nChecks;
+    uint64_t nSolutions;
+    int64_t nSolutionMicros;        // Total time to first solution, over checks that found one
+    uint64_t nLastHammers;
+    int64_t nLastCheckMicros;
+    int64_t nLastSolutionMicros;    // -1 if the last check found no solution
+    std::vector<CHammerCheckThreadStats> vThreads;
+
+    CHammerCheckStats() : nChecks(0), nSolutions(0), nSolutionMicros(0), nLastHammers(0), nLastCheckMicros(0), nLastSolutionMicros(-1) {}
+};
+
+CHammerCheckStats GetHammerCheckStats();
+
+// Thor: Forge: Hammer check work published to remote workers (-forgework)
+struct CForgeWorkRange
+{
+    std::string txid;
+    int offset;
+    int count;
+};
+
+struct CForgeWork
+{
+    std::string workId;                     // "idle" when there is no current work
+    int nHeight;                            // Height of the block a solution would mint
+    uint256 hashPrevBlock;
+    std::string deterministicRandString;
+    arith_uint256 hammerHashTarget;
+    std::vector<std::vector<CForgeWorkRange>> chunks;   // The node's chunks left to the workers
+
+    CForgeWork() : workId("idle"), nHeight(0) {}
+};
+
+/** Get the current Forge work. If longPollId is the current work id, first wait up to nTimeoutMillis for it to change. */
+void GetForgeWork(CForgeWork& work, const std::string& longPollId, int64_t nTimeoutMillis);
+
+/** Hand a remote worker's solution to the HammerKeeper. Returns an empty string if it's accepted for minting, else the reason it isn't. */
+std::string SubmitForgeSolution(const std::string& workId, const uint256& txid, uint32_t nonce);
 
 #endif // BITCOIN_MINER_H
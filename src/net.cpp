@@ -24,6 +24,16 @@
 #include <string.h>
 #else
 #include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifdef USE_POLL
+#include <poll.h>
+#endif
+
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
 #endif
 
 #ifdef USE_UPNP
@@ -42,6 +52,21 @@
 // We add a random period time (0 to 1 seconds) to feeler connections to prevent synchronization.
 #define FEELER_SLEEP_WINDOW 1
 
+// Thor: Most buffers handed to the socket in one scatter-gather send (two per queued message)
+static const int MAX_SEND_IOVECS = 64;
+
+// Thor: How long the socket handler waits for ready sockets before sweeping for disconnected nodes
+static const int SOCKET_WAIT_TIMEOUT_MS = 50;
+
+// Thor: Most socket events taken from epoll in one wait; the rest are taken by the next
+static const int MAX_SOCKET_EVENTS = 256;
+
+// Thor: What the socket handler waits on for a peer socket
+enum SocketInterest {
+    SOCKET_INTEREST_RECV = (1 << 0),
+    SOCKET_INTEREST_SEND = (1 << 1),
+};
+
 #if !defined(HAVE_MSG_NOSIGNAL)
 #define MSG_NOSIGNAL 0
 #endif
@@ -85,6 +110,8 @@ std::map<CNetAddr, LocalServiceInfo> mapLocalHost;
 static bool vfLimited[NET_MAX] = {};
 std::string strSubVersion;
 
+CRecvBufferPool g_recv_buffer_pool;
+
 limitedmap<uint256, int64_t> mapAlreadyAskedFor(MAX_INV_SZ);
 
 void CConnman::AddOneShot(const std::string& strDest)
@@ -708,6 +735,7 @@ void CNode::copyStats(CNodeStats &stats)
     {
         LOCK(cs_vRecv);
         X(mapRecvBytesPerMsgCmd);
+        X(mapRecvQueueTimePerMsgCmd);
         X(nRecvBytes);
     }
     X(fWhitelisted);
@@ -746,7 +774,7 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
         // get current incomplete message, or create a new one
         if (vRecvMsg.empty() ||
             vRecvMsg.back().complete())
-            vRecvMsg.push_back(CNetMessage(Params().MessageStart(), SER_NETWORK, INIT_PROTO_VERSION));
+            vRecvMsg.emplace_back(Params().MessageStart(), SER_NETWORK, INIT_PROTO_VERSION);
 
         CNetMessage& msg = vRecvMsg.back();
 
@@ -786,6 +814,45 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
     return true;
 }
 
+char* CNode::GetRecvBuffer(unsigned int& nBytes)
+{
+    LOCK(cs_vRecv);
+    if (vRecvMsg.empty() || !vRecvMsg.back().in_data)
+        return nullptr;
+    CNetMessage& msg = vRecvMsg.back();
+    if (msg.hdr.nMessageSize - msg.nDataPos < MIN_RECV_IN_PLACE)
+        return nullptr;
+    // Fill what's already allocated before growing the buffer
+    unsigned int nRoom = msg.vRecv.size() - msg.nDataPos;
+    nBytes = nRoom >= MIN_RECV_IN_PLACE ? nRoom : MAX_RECV_AHEAD;
+    return msg.PrepareData(nBytes);
+}
+
+size_t CNode::TakeCompleteMessages(std::list<CNetMessage>& msgs)
+{
+    LOCK(cs_vRecv);
+    size_t nSize = 0;
+    auto it(vRecvMsg.begin());
+    for (; it != vRecvMsg.end(); ++it) {
+        if (!it->complete())
+            break;
+        nSize += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
+    }
+    msgs.splice(msgs.end(), vRecvMsg, vRecvMsg.begin(), it);
+    return nSize;
+}
+
+void CNode::RecordQueueTime(const std::string& strCommand, int64_t nQueueMicros)
+{
+    LOCK(cs_vRecv);
+    // As with the bytes received, only valid commands get their own entry
+    const std::string& strKey = mapRecvBytesPerMsgCmd.count(strCommand) ? strCommand : NET_MESSAGE_COMMAND_OTHER;
+    CMsgQueueTime& queueTime = mapRecvQueueTimePerMsgCmd[strKey];
+    queueTime.nCount++;
+    queueTime.nTotalMicros += nQueueMicros;
+    queueTime.nMaxMicros = std::max(queueTime.nMaxMicros, nQueueMicros);
+}
+
 void CNode::SetSendVersion(int nVersionIn)
 {
     // Send version may only be changed in the version message, and
@@ -813,22 +880,29 @@ int CNode::GetSendVersion() const
 }
 
 
+CNetMessage::~CNetMessage()
+{
+    CSerializeData vch;
+    vRecv.SwapBuffer(vch);
+    g_recv_buffer_pool.Release(vch);
+}
+
 int CNetMessage::readHeader(const char *pch, unsigned int nBytes)
 {
     // copy data to temporary parsing buffer
-    unsigned int nRemaining = 24 - nHdrPos;
+    unsigned int nRemaining = CMessageHeader::HEADER_SIZE - nHdrPos;
     unsigned int nCopy = std::min(nRemaining, nBytes);
 
     memcpy(&hdrbuf[nHdrPos], pch, nCopy);
     nHdrPos += nCopy;
 
     // if header incomplete, exit
-    if (nHdrPos < 24)
+    if (nHdrPos < CMessageHeader::HEADER_SIZE)
         return nCopy;
 
     // deserialize to CMessageHeader
     try {
-        hdrbuf >> hdr;
+        CSpanReader(vRecv.GetType(), vRecv.GetVersion(), hdrbuf, hdrbuf + CMessageHeader::HEADER_SIZE) >> hdr;
     }
     catch (const std::exception&) {
         return -1;
@@ -844,18 +918,35 @@ int CNetMessage::readHeader(const char *pch, unsigned int nBytes)
     return nCopy;
 }
 
-int CNetMessage::readData(const char *pch, unsigned int nBytes)
+char* CNetMessage::PrepareData(unsigned int& nBytes)
 {
-    unsigned int nRemaining = hdr.nMessageSize - nDataPos;
-    unsigned int nCopy = std::min(nRemaining, nBytes);
-
-    if (vRecv.size() < nDataPos + nCopy) {
+    nBytes = std::min(nBytes, hdr.nMessageSize - nDataPos);
+    if (vRecv.size() < nDataPos + nBytes) {
         // Allocate up to 256 KiB ahead, but never more than the total message size.
-        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024));
+        // Thor: Past that, up to four times what has arrived, so a large message's
+        // buffer moves (and is copied) only a couple of times.
+        unsigned int nSize = std::max(nDataPos + std::max(nBytes, MAX_RECV_AHEAD), 4 * nDataPos);
+        CSerializeData vch;
+        vRecv.SwapBuffer(vch);
+        g_recv_buffer_pool.Resize(vch, std::min(hdr.nMessageSize, nSize), nDataPos);
+        vRecv.SwapBuffer(vch);
     }
+    return vRecv.data() + nDataPos;
+}
+
+int CNetMessage::readData(const char *pch, unsigned int nBytes)
+{
+    unsigned int nCopy = nBytes;
+    char* pchData = PrepareData(nCopy);
 
     hasher.Write((const unsigned char*)pch, nCopy);
-    memcpy(&vRecv[nDataPos], pch, nCopy);
+    // The socket handler may have received straight into the buffer
+    if (pch == pchData) {
+        g_recv_buffer_pool.CountInPlace(nCopy);
+    } else {
+        memcpy(pchData, pch, nCopy);
+        g_recv_buffer_pool.CountCopied(nCopy);
+    }
     nDataPos += nCopy;
 
     return nCopy;
@@ -869,6 +960,74 @@ const uint256& CNetMessage::GetMessageHash() const
     return data_hash;
 }
 
+void CRecvBufferPool::Resize(CSerializeData& vch, size_t nSize, size_t nKeep)
+{
+    if (nSize <= vch.capacity()) {
+        vch.resize(nSize);
+        return;
+    }
+
+    // Take a buffer of the smallest size that fits, from the pool if there is one
+    int nClass = 0;
+    while (nClass < BUFFER_SIZE_CLASSES && (MIN_BUFFER_SIZE << nClass) < nSize)
+        nClass++;
+    CSerializeData vchNew;
+    if (nClass < BUFFER_SIZE_CLASSES) {
+        std::lock_guard<std::mutex> lock(mutexFree);
+        if (!vFree[nClass].empty()) {
+            vchNew.swap(vFree[nClass].back());
+            vFree[nClass].pop_back();
+            nPooledBytes -= vchNew.capacity();
+        }
+    }
+    if (vchNew.capacity() > 0) {
+        nReuses++;
+    } else {
+        vchNew.reserve(nClass < BUFFER_SIZE_CLASSES ? MIN_BUFFER_SIZE << nClass : nSize);
+        nAllocations++;
+    }
+
+    nKeep = std::min(nKeep, vch.size());
+    vchNew.insert(vchNew.end(), vch.begin(), vch.begin() + nKeep);
+    nCopiedBytes += nKeep;
+    vchNew.resize(nSize);
+    vch.swap(vchNew);
+    Release(vchNew);
+}
+
+void CRecvBufferPool::Release(CSerializeData& vch)
+{
+    // Declared before the lock, so a buffer that isn't kept is freed after the lock is released
+    CSerializeData vchFree;
+    vchFree.swap(vch);
+    const size_t nCapacity = vchFree.capacity();
+    if (nCapacity < MIN_BUFFER_SIZE)
+        return;
+    int nClass = 0;
+    while (nClass + 1 < BUFFER_SIZE_CLASSES && (MIN_BUFFER_SIZE << (nClass + 1)) <= nCapacity)
+        nClass++;
+    vchFree.clear();
+
+    std::lock_guard<std::mutex> lock(mutexFree);
+    if (vFree[nClass].size() >= MAX_POOLED_PER_SIZE || nPooledBytes + nCapacity > MAX_POOLED_BYTES)
+        return;
+    nPooledBytes += nCapacity;
+    vFree[nClass].push_back(std::move(vchFree));
+}
+
+CRecvBufferStats CRecvBufferPool::GetStats()
+{
+    CRecvBufferStats stats;
+    stats.nAllocations = nAllocations;
+    stats.nReuses = nReuses;
+    stats.nCopiedBytes = nCopiedBytes;
+    stats.nInPlaceBytes = nInPlaceBytes;
+    std::lock_guard<std::mutex> lock(mutexFree);
+    stats.nPooledBytes = nPooledBytes;
+    return stats;
+}
+
+
 
 
 
@@ -876,6 +1035,17 @@ const uint256& CNetMessage::GetMessageHash() const
 
 
 
+#ifndef WIN32
+/** Thor: Send as much of the given buffers as the socket takes in one call, like writev() but with send() flags */
+static int SendBuffers(SOCKET hSocket, struct iovec* iov, int nIov)
+{
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = nIov;
+    return sendmsg(hSocket, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+#endif
 
 // requires LOCK(cs_vSend)
 size_t CConnman::SocketSendData(CNode *pnode) const
@@ -884,27 +1054,69 @@ size_t CConnman::SocketSendData(CNode *pnode) const
     size_t nSentSize = 0;
 
     while (it != pnode->vSendMsg.end()) {
-        const auto &data = *it;
-        assert(data.size() > pnode->nSendOffset);
+        assert((*it)->size() > pnode->nSendOffset);
+
+        // Thor: Hand the socket the unsent part of as many queued messages as fit, headers and
+        // payloads straight from their shared buffers
+        size_t nGathered = 0;
         int nBytes = 0;
+#ifndef WIN32
+        struct iovec iov[MAX_SEND_IOVECS];
+        int nIov = 0;
+        size_t nSkip = pnode->nSendOffset;
+        for (auto itGather = it; itGather != pnode->vSendMsg.end() && nIov + 2 <= MAX_SEND_IOVECS; ++itGather) {
+            for (const std::vector<unsigned char>* part : {&(*itGather)->header, &(*itGather)->data}) {
+                if (nSkip >= part->size()) {
+                    nSkip -= part->size();
+                    continue;
+                }
+                iov[nIov].iov_base = const_cast<unsigned char*>(part->data()) + nSkip;
+                iov[nIov].iov_len = part->size() - nSkip;
+                nGathered += iov[nIov].iov_len;
+                nIov++;
+                nSkip = 0;
+            }
+        }
         {
             LOCK(pnode->cs_hSocket);
             if (pnode->hSocket == INVALID_SOCKET)
                 break;
-            nBytes = send(pnode->hSocket, reinterpret_cast<const char*>(data.data()) + pnode->nSendOffset, data.size() - pnode->nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+            nBytes = SendBuffers(pnode->hSocket, iov, nIov);
         }
+#else
+        const CSharedNetMsg& msg = **it;
+        const bool fHeader = pnode->nSendOffset < msg.header.size();
+        const unsigned char* pbegin = fHeader ? msg.header.data() + pnode->nSendOffset : msg.data.data() + (pnode->nSendOffset - msg.header.size());
+        nGathered = fHeader ? msg.header.size() - pnode->nSendOffset : msg.size() - pnode->nSendOffset;
+        {
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                break;
+            nBytes = send(pnode->hSocket, reinterpret_cast<const char*>(pbegin), nGathered, MSG_NOSIGNAL | MSG_DONTWAIT);
+        }
+#endif
         if (nBytes > 0) {
             pnode->nLastSend = GetSystemTimeInSeconds();
             pnode->nSendBytes += nBytes;
-            pnode->nSendOffset += nBytes;
             nSentSize += nBytes;
-            if (pnode->nSendOffset == data.size()) {
+
+            // Retire the messages that went out in full
+            size_t nRemaining = nBytes;
+            while (nRemaining > 0) {
+                size_t nUnsent = (*it)->size() - pnode->nSendOffset;
+                if (nRemaining < nUnsent) {
+                    pnode->nSendOffset += nRemaining;
+                    break;
+                }
+                nRemaining -= nUnsent;
                 pnode->nSendOffset = 0;
-                pnode->nSendSize -= data.size();
+                pnode->nSendSize -= (*it)->size();
                 pnode->fPauseSend = pnode->nSendSize > nSendBufferMaxSize;
                 it++;
-            } else {
-                // could not send full message; stop sending more
+            }
+
+            if ((size_t)nBytes < nGathered) {
+                // could not send everything; stop sending more
                 break;
             }
         } else {
@@ -1145,229 +1357,563 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
+        RegisterNodeSocket(pnode);
     }
 }
 
-void CConnman::ThreadSocketHandler()
+void CConnman::DisconnectNodes()
 {
-    unsigned int nPrevNodeCount = 0;
-    while (!interruptNet)
     {
-        //
-        // Disconnect nodes
-        //
+        LOCK(cs_vNodes);
+        // Disconnect unused nodes
+        std::vector<CNode*> vNodesCopy = vNodes;
+        for (CNode* pnode : vNodesCopy)
         {
-            LOCK(cs_vNodes);
-            // Disconnect unused nodes
-            std::vector<CNode*> vNodesCopy = vNodes;
-            for (CNode* pnode : vNodesCopy)
+            if (pnode->fDisconnect)
             {
-                if (pnode->fDisconnect)
-                {
-                    // remove from vNodes
-                    vNodes.erase(remove(vNodes.begin(), vNodes.end(), pnode), vNodes.end());
+                // remove from vNodes
+                vNodes.erase(remove(vNodes.begin(), vNodes.end(), pnode), vNodes.end());
 
-                    // release outbound grant (if any)
-                    pnode->grantOutbound.Release();
+                // release outbound grant (if any)
+                pnode->grantOutbound.Release();
 
-                    // close socket and cleanup
-                    pnode->CloseSocketDisconnect();
+                // close socket and cleanup; closing it also takes it out of the epoll set
+                pnode->CloseSocketDisconnect();
 
-                    // hold in disconnected pool until all refs are released
-                    pnode->Release();
-                    vNodesDisconnected.push_back(pnode);
-                }
+                // hold in disconnected pool until all refs are released
+                pnode->Release();
+                vNodesDisconnected.push_back(pnode);
             }
         }
+    }
+    {
+        // Delete disconnected nodes
+        std::list<CNode*> vNodesDisconnectedCopy = vNodesDisconnected;
+        for (CNode* pnode : vNodesDisconnectedCopy)
         {
-            // Delete disconnected nodes
-            std::list<CNode*> vNodesDisconnectedCopy = vNodesDisconnected;
-            for (CNode* pnode : vNodesDisconnectedCopy)
-            {
-                // wait until threads are done using it
-                if (pnode->GetRefCount() <= 0) {
-                    bool fDelete = false;
-                    {
-                        TRY_LOCK(pnode->cs_inventory, lockInv);
-                        if (lockInv) {
-                            TRY_LOCK(pnode->cs_vSend, lockSend);
-                            if (lockSend) {
-                                fDelete = true;
-                            }
+            // wait until threads are done using it
+            if (pnode->GetRefCount() <= 0) {
+                bool fDelete = false;
+                {
+                    TRY_LOCK(pnode->cs_inventory, lockInv);
+                    if (lockInv) {
+                        TRY_LOCK(pnode->cs_vSend, lockSend);
+                        if (lockSend) {
+                            fDelete = true;
                         }
                     }
-                    if (fDelete) {
-                        vNodesDisconnected.remove(pnode);
-                        DeleteNode(pnode);
-                    }
+                }
+                if (fDelete) {
+                    vNodesDisconnected.remove(pnode);
+                    DeleteNode(pnode);
                 }
             }
         }
-        size_t vNodesSize;
+    }
+}
+
+void CConnman::InactivityCheck(CNode* pnode, int64_t nTime)
+{
+    if (nTime - pnode->nTimeConnected > 60)
+    {
+        if (pnode->nLastRecv == 0 || pnode->nLastSend == 0)
         {
-            LOCK(cs_vNodes);
-            vNodesSize = vNodes.size();
+            LogPrint(BCLog::NET, "socket no message in first 60 seconds, %d %d from %d\n", pnode->nLastRecv != 0, pnode->nLastSend != 0, pnode->GetId());
+            pnode->fDisconnect = true;
         }
-        if(vNodesSize != nPrevNodeCount) {
-            nPrevNodeCount = vNodesSize;
-            if(clientInterface)
-                clientInterface->NotifyNumConnectionsChanged(nPrevNodeCount);
+        else if (nTime - pnode->nLastSend > TIMEOUT_INTERVAL)
+        {
+            LogPrintf("socket sending timeout: %is\n", nTime - pnode->nLastSend);
+            pnode->fDisconnect = true;
+        }
+        else if (nTime - pnode->nLastRecv > (pnode->nVersion > BIP0031_VERSION ? TIMEOUT_INTERVAL : 90*60))
+        {
+            LogPrintf("socket receive timeout: %is\n", nTime - pnode->nLastRecv);
+            pnode->fDisconnect = true;
+        }
+        else if (pnode->nPingNonceSent && pnode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
+        {
+            LogPrintf("ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pnode->nPingUsecStart));
+            pnode->fDisconnect = true;
+        }
+        else if (!pnode->fSuccessfullyConnected)
+        {
+            LogPrintf("version handshake timeout from %d\n", pnode->GetId());
+            pnode->fDisconnect = true;
         }
+    }
+}
 
-        //
-        // Find which sockets have data to receive
-        //
-        struct timeval timeout;
-        timeout.tv_sec  = 0;
-        timeout.tv_usec = 50000; // frequency to poll pnode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds = false;
+// Implement the following logic:
+// * If there is data to send, wait for sending data. As this only
+//   happens when optimistic write failed, we choose to first drain the
+//   write buffer in this case before receiving more. This avoids
+//   needlessly queueing received data, if the remote peer is not themselves
+//   receiving data. This means properly utilizing TCP flow control signalling.
+// * Otherwise, if there is space left in the receive buffer (fPauseRecv is not
+//   set), wait for receiving data.
+// * Hand off all complete messages to the processor, to be handled without
+//   blocking here.
+int CConnman::GetSocketInterest(CNode* pnode)
+{
+    AssertLockHeld(pnode->cs_vSend);
+    if (!pnode->vSendMsg.empty())
+        return SOCKET_INTEREST_SEND;
 
-        for (const ListenSocket& hListenSocket : vhListenSocket) {
-            FD_SET(hListenSocket.socket, &fdsetRecv);
-            hSocketMax = std::max(hSocketMax, hListenSocket.socket);
-            have_fds = true;
+    // The message handler clears fPauseRecv before it checks fRecvInterestPaused, and this
+    // sets fRecvInterestPaused before it checks fPauseRecv, so an unpause is never missed
+    pnode->fRecvInterestPaused = true;
+    if (pnode->fPauseRecv)
+        return 0;
+    pnode->fRecvInterestPaused = false;
+    return SOCKET_INTEREST_RECV;
+}
+
+#ifdef USE_EPOLL
+static struct epoll_event EpollNodeEvent(int nInterest, CNode* pnode)
+{
+    // Edge-triggered: a socket is reported once each time it becomes ready, not on every
+    // wait while it stays ready, so paused and idle peers cost nothing
+    struct epoll_event event = {};
+    event.events = EPOLLET | EPOLLRDHUP;
+    if (nInterest & SOCKET_INTEREST_RECV)
+        event.events |= EPOLLIN;
+    if (nInterest & SOCKET_INTEREST_SEND)
+        event.events |= EPOLLOUT;
+    event.data.ptr = pnode;
+    return event;
+}
+#endif
+
+void CConnman::RegisterNodeSocket(CNode* pnode)
+{
+#ifdef USE_EPOLL
+    LOCK2(pnode->cs_vSend, pnode->cs_hSocket);
+    if (hEpoll == -1 || pnode->hSocket == INVALID_SOCKET)
+        return;
+    int nInterest = GetSocketInterest(pnode);
+    struct epoll_event event = EpollNodeEvent(nInterest, pnode);
+    if (epoll_ctl(hEpoll, EPOLL_CTL_ADD, pnode->hSocket, &event) != 0) {
+        LogPrintf("socket epoll add error %s\n", NetworkErrorString(WSAGetLastError()));
+        pnode->fDisconnect = true;
+        return;
+    }
+    pnode->nSocketInterest = nInterest;
+    pnode->fSocketRegistered = true;
+#endif
+}
+
+/**
+ * Bring the epoll interest for a node's socket up to date. With fRearm the socket may still be
+ * ready after being serviced (a full read or a partial write), and is re-armed even if the
+ * interest is unchanged, since an edge-triggered socket reports nothing new until it is.
+ */
+void CConnman::UpdateSocketInterest(CNode* pnode, bool fRearm)
+{
+#ifdef USE_EPOLL
+    LOCK2(pnode->cs_vSend, pnode->cs_hSocket);
+    if (!pnode->fSocketRegistered || pnode->hSocket == INVALID_SOCKET)
+        return;
+    int nInterest = GetSocketInterest(pnode);
+    if (nInterest == pnode->nSocketInterest && (!fRearm || nInterest == 0))
+        return;
+    struct epoll_event event = EpollNodeEvent(nInterest, pnode);
+    if (epoll_ctl(hEpoll, EPOLL_CTL_MOD, pnode->hSocket, &event) != 0) {
+        LogPrintf("socket epoll modify error %s\n", NetworkErrorString(WSAGetLastError()));
+        pnode->fDisconnect = true;
+        return;
+    }
+    pnode->nSocketInterest = nInterest;
+#endif
+}
+
+void CConnman::SocketInterestChanged(CNode* pnode)
+{
+#ifdef USE_EPOLL
+    UpdateSocketInterest(pnode, false);
+#else
+    // poll() and select() are handed each socket's interest afresh on every wait
+    WakeSocketHandler();
+#endif
+}
+
+void CConnman::WakeSocketHandler()
+{
+    if (hWakeupPipe[1] == -1 || fWakeupPending.exchange(true))
+        return;
+#ifndef WIN32
+    char c = 0;
+    if (write(hWakeupPipe[1], &c, 1) != 1)
+        LogPrint(BCLog::NET, "socket handler wakeup failed: %s\n", NetworkErrorString(WSAGetLastError()));
+#endif
+}
+
+void CConnman::DrainWakeupPipe()
+{
+    // Clear the flag first, so a wakeup that comes in while draining writes again
+    fWakeupPending = false;
+#ifndef WIN32
+    char buf[128];
+    while (read(hWakeupPipe[0], buf, sizeof(buf)) > 0) {}
+#endif
+}
+
+bool CConnman::InitSocketEvents()
+{
+#ifdef USE_POLL
+    if (pipe(hWakeupPipe) != 0) {
+        hWakeupPipe[0] = hWakeupPipe[1] = -1;
+        LogPrintf("Failed to create the socket handler wakeup pipe: %s\n", NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+    for (int fd : hWakeupPipe) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    fWakeupPending = false;
+#endif
+#ifdef USE_EPOLL
+    hEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (hEpoll == -1) {
+        LogPrintf("Failed to create the socket epoll set: %s\n", NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+
+    // The wakeup pipe and listening sockets are level-triggered, so a burst of connections
+    // is accepted one per wait, and each is identified by its epoll data
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(hEpoll, EPOLL_CTL_ADD, hWakeupPipe[0], &event) != 0) {
+        LogPrintf("Failed to add the wakeup pipe to the socket epoll set: %s\n", NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+    for (ListenSocket& hListenSocket : vhListenSocket) {
+        event.data.ptr = &hListenSocket;
+        if (epoll_ctl(hEpoll, EPOLL_CTL_ADD, hListenSocket.socket, &event) != 0) {
+            LogPrintf("Failed to add a listening socket to the socket epoll set: %s\n", NetworkErrorString(WSAGetLastError()));
+            return false;
         }
+    }
+#endif
+    return true;
+}
+
+void CConnman::CloseSocketEvents()
+{
+#ifdef USE_EPOLL
+    if (hEpoll != -1)
+        close(hEpoll);
+    hEpoll = -1;
+#endif
+#ifndef WIN32
+    for (int& fd : hWakeupPipe) {
+        if (fd != -1)
+            close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+#if defined(USE_EPOLL)
+bool CConnman::SocketEvents(std::vector<NodeSocketEvents>& vReady, std::vector<const ListenSocket*>& vListenReady)
+{
+    struct epoll_event events[MAX_SOCKET_EVENTS];
+    int nEvents = epoll_wait(hEpoll, events, MAX_SOCKET_EVENTS, SOCKET_WAIT_TIMEOUT_MS);
+    if (interruptNet)
+        return false;
+
+    if (nEvents < 0) {
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEINTR) {
+            LogPrintf("socket epoll error %s\n", NetworkErrorString(nErr));
+            if (!interruptNet.sleep_for(std::chrono::milliseconds(SOCKET_WAIT_TIMEOUT_MS)))
+                return false;
+        }
+        return true;
+    }
 
+    // Only this thread deletes nodes, after closing their sockets, which takes them out of
+    // the epoll set; so every node reported here is still alive
+    LOCK(cs_vNodes);
+    for (int i = 0; i < nEvents; i++) {
+        const void* ptr = events[i].data.ptr;
+        if (ptr == nullptr) {
+            DrainWakeupPipe();
+            continue;
+        }
+        auto itListen = std::find_if(vhListenSocket.begin(), vhListenSocket.end(), [ptr](const ListenSocket& hListenSocket) { return &hListenSocket == ptr; });
+        if (itListen != vhListenSocket.end()) {
+            vListenReady.push_back(&*itListen);
+            continue;
+        }
+
+        // A receive edge seen while paused is picked up again when the unpause re-arms the socket
+        CNode* pnode = static_cast<CNode*>(events[i].data.ptr);
+        uint32_t nFlags = events[i].events;
+        bool fRecv = (nFlags & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) || ((nFlags & EPOLLIN) && !pnode->fPauseRecv);
+        bool fSend = nFlags & EPOLLOUT;
+        if (!fRecv && !fSend)
+            continue;
+        pnode->AddRef();
+        vReady.push_back({pnode, fRecv, fSend});
+    }
+    return true;
+}
+#elif defined(USE_POLL)
+bool CConnman::SocketEvents(std::vector<NodeSocketEvents>& vReady, std::vector<const ListenSocket*>& vListenReady)
+{
+    std::vector<struct pollfd> vPollFds;
+    std::vector<CNode*> vPollNodes;
+    struct pollfd pollfd = {};
+    pollfd.events = POLLIN;
+
+    pollfd.fd = hWakeupPipe[0];
+    vPollFds.push_back(pollfd);
+    for (const ListenSocket& hListenSocket : vhListenSocket) {
+        pollfd.fd = hListenSocket.socket;
+        vPollFds.push_back(pollfd);
+    }
+    const size_t nFirstNode = vPollFds.size();
+
+    {
+        LOCK(cs_vNodes);
+        for (CNode* pnode : vNodes)
         {
-            LOCK(cs_vNodes);
-            for (CNode* pnode : vNodes)
+            int nInterest;
             {
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signalling.
-                // * Otherwise, if there is space left in the receive buffer, select() for
-                //   receiving data.
-                // * Hand off all complete messages to the processor, to be handled without
-                //   blocking here.
-
-                bool select_recv = !pnode->fPauseRecv;
-                bool select_send;
-                {
-                    LOCK(pnode->cs_vSend);
-                    select_send = !pnode->vSendMsg.empty();
-                }
+                LOCK(pnode->cs_vSend);
+                nInterest = GetSocketInterest(pnode);
+            }
 
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
 
-                FD_SET(pnode->hSocket, &fdsetError);
-                hSocketMax = std::max(hSocketMax, pnode->hSocket);
-                have_fds = true;
+            // Errors and hangups are reported even with no interest
+            pollfd.fd = pnode->hSocket;
+            pollfd.events = (nInterest & SOCKET_INTEREST_RECV ? POLLIN : 0) | (nInterest & SOCKET_INTEREST_SEND ? POLLOUT : 0);
+            vPollFds.push_back(pollfd);
+            vPollNodes.push_back(pnode);
+        }
+    }
 
-                if (select_send) {
-                    FD_SET(pnode->hSocket, &fdsetSend);
-                    continue;
-                }
-                if (select_recv) {
-                    FD_SET(pnode->hSocket, &fdsetRecv);
-                }
-            }
+    int nRet = poll(vPollFds.data(), vPollFds.size(), SOCKET_WAIT_TIMEOUT_MS);
+    if (interruptNet)
+        return false;
+
+    if (nRet < 0) {
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEINTR) {
+            LogPrintf("socket poll error %s\n", NetworkErrorString(nErr));
+            if (!interruptNet.sleep_for(std::chrono::milliseconds(SOCKET_WAIT_TIMEOUT_MS)))
+                return false;
         }
+        return true;
+    }
 
-        int nSelect = select(have_fds ? hSocketMax + 1 : 0,
-                             &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
-        if (interruptNet)
-            return;
+    if (vPollFds[0].revents)
+        DrainWakeupPipe();
+    for (size_t i = 0; i < vhListenSocket.size(); i++) {
+        if (vPollFds[1 + i].revents & POLLIN)
+            vListenReady.push_back(&vhListenSocket[i]);
+    }
+
+    // Only this thread deletes nodes, so every node polled is still alive
+    LOCK(cs_vNodes);
+    for (size_t i = 0; i < vPollNodes.size(); i++) {
+        short nFlags = vPollFds[nFirstNode + i].revents;
+        bool fRecv = nFlags & (POLLIN | POLLERR | POLLHUP);
+        bool fSend = nFlags & POLLOUT;
+        if (!fRecv && !fSend)
+            continue;
+        vPollNodes[i]->AddRef();
+        vReady.push_back({vPollNodes[i], fRecv, fSend});
+    }
+    return true;
+}
+#else
+bool CConnman::SocketEvents(std::vector<NodeSocketEvents>& vReady, std::vector<const ListenSocket*>& vListenReady)
+{
+    struct timeval timeout;
+    timeout.tv_sec  = 0;
+    timeout.tv_usec = SOCKET_WAIT_TIMEOUT_MS * 1000; // frequency to poll pnode->vSend
+
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds = false;
+
+    for (const ListenSocket& hListenSocket : vhListenSocket) {
+        FD_SET(hListenSocket.socket, &fdsetRecv);
+        hSocketMax = std::max(hSocketMax, hListenSocket.socket);
+        have_fds = true;
+    }
 
-        if (nSelect == SOCKET_ERROR)
+    std::vector<CNode*> vSelectNodes;
+    {
+        LOCK(cs_vNodes);
+        for (CNode* pnode : vNodes)
         {
-            if (have_fds)
+            int nInterest;
             {
-                int nErr = WSAGetLastError();
-                LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
+                LOCK(pnode->cs_vSend);
+                nInterest = GetSocketInterest(pnode);
             }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
-                return;
+
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+
+            FD_SET(pnode->hSocket, &fdsetError);
+            hSocketMax = std::max(hSocketMax, pnode->hSocket);
+            have_fds = true;
+            vSelectNodes.push_back(pnode);
+
+            if (nInterest & SOCKET_INTEREST_SEND)
+                FD_SET(pnode->hSocket, &fdsetSend);
+            if (nInterest & SOCKET_INTEREST_RECV)
+                FD_SET(pnode->hSocket, &fdsetRecv);
+        }
+    }
+
+    int nSelect = select(have_fds ? hSocketMax + 1 : 0,
+                         &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    if (interruptNet)
+        return false;
+
+    if (nSelect == SOCKET_ERROR)
+    {
+        if (have_fds)
+        {
+            int nErr = WSAGetLastError();
+            LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
+            for (unsigned int i = 0; i <= hSocketMax; i++)
+                FD_SET(i, &fdsetRecv);
+        }
+        FD_ZERO(&fdsetSend);
+        FD_ZERO(&fdsetError);
+        if (!interruptNet.sleep_for(std::chrono::milliseconds(SOCKET_WAIT_TIMEOUT_MS)))
+            return false;
+    }
+
+    for (const ListenSocket& hListenSocket : vhListenSocket) {
+        if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
+            vListenReady.push_back(&hListenSocket);
+    }
+
+    // Only this thread deletes nodes, so every node selected on is still alive
+    LOCK(cs_vNodes);
+    for (CNode* pnode : vSelectNodes)
+    {
+        bool fRecv = false;
+        bool fSend = false;
+        {
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+            fRecv = FD_ISSET(pnode->hSocket, &fdsetRecv) || FD_ISSET(pnode->hSocket, &fdsetError);
+            fSend = FD_ISSET(pnode->hSocket, &fdsetSend);
         }
+        if (!fRecv && !fSend)
+            continue;
+        pnode->AddRef();
+        vReady.push_back({pnode, fRecv, fSend});
+    }
+    return true;
+}
+#endif
 
+void CConnman::ThreadSocketHandler()
+{
+    unsigned int nPrevNodeCount = 0;
+    int64_t nLastInactivityCheck = 0;
+    while (!interruptNet)
+    {
         //
-        // Accept new connections
+        // Disconnect nodes
         //
-        for (const ListenSocket& hListenSocket : vhListenSocket)
+        DisconnectNodes();
+        size_t vNodesSize;
         {
-            if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
-            {
-                AcceptConnection(hListenSocket);
-            }
+            LOCK(cs_vNodes);
+            vNodesSize = vNodes.size();
+        }
+        if(vNodesSize != nPrevNodeCount) {
+            nPrevNodeCount = vNodesSize;
+            if(clientInterface)
+                clientInterface->NotifyNumConnectionsChanged(nPrevNodeCount);
         }
 
         //
-        // Service each socket
+        // Find which sockets are ready
         //
-        std::vector<CNode*> vNodesCopy;
+        std::vector<NodeSocketEvents> vReady;
+        std::vector<const ListenSocket*> vListenReady;
+        if (!SocketEvents(vReady, vListenReady))
+            return;
+
+        //
+        // Accept new connections
+        //
+        for (const ListenSocket* pListenSocket : vListenReady)
         {
-            LOCK(cs_vNodes);
-            vNodesCopy = vNodes;
-            for (CNode* pnode : vNodesCopy)
-                pnode->AddRef();
+            AcceptConnection(*pListenSocket);
         }
-        for (CNode* pnode : vNodesCopy)
+
+        //
+        // Service each ready socket
+        //
+        for (const NodeSocketEvents& events : vReady)
         {
             if (interruptNet)
                 return;
+            CNode* pnode = events.pnode;
+            bool fRearm = false;
 
             //
             // Receive
             //
-            bool recvSet = false;
-            bool sendSet = false;
-            bool errorSet = false;
-            {
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-                recvSet = FD_ISSET(pnode->hSocket, &fdsetRecv);
-                sendSet = FD_ISSET(pnode->hSocket, &fdsetSend);
-                errorSet = FD_ISSET(pnode->hSocket, &fdsetError);
-            }
-            if (recvSet || errorSet)
+            if (events.fRecv)
             {
                 // typical socket buffer is 8K-64K
                 char pchBuf[0x10000];
+                // Thor: The rest of a large message body is received straight into its buffer
+                unsigned int nRecvSize = 0;
+                char* pchRecv = pnode->GetRecvBuffer(nRecvSize);
+                if (!pchRecv) {
+                    pchRecv = pchBuf;
+                    nRecvSize = sizeof(pchBuf);
+                }
                 int nBytes = 0;
                 {
                     LOCK(pnode->cs_hSocket);
                     if (pnode->hSocket == INVALID_SOCKET)
                         continue;
-                    nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+                    nBytes = recv(pnode->hSocket, pchRecv, nRecvSize, MSG_DONTWAIT);
                 }
                 if (nBytes > 0)
                 {
+                    // A full read may have left more behind
+                    fRearm = (unsigned int)nBytes == nRecvSize;
                     bool notify = false;
-                    if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
+                    if (!pnode->ReceiveMsgBytes(pchRecv, nBytes, notify))
                         pnode->CloseSocketDisconnect();
                     RecordBytesRecv(nBytes);
                     if (notify) {
-                        size_t nSizeAdded = 0;
-                        auto it(pnode->vRecvMsg.begin());
-                        for (; it != pnode->vRecvMsg.end(); ++it) {
-                            if (!it->complete())
-                                break;
-                            nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
-                        }
+                        std::list<CNetMessage> msgs;
+                        size_t nSizeAdded = pnode->TakeCompleteMessages(msgs);
                         {
                             LOCK(pnode->cs_vProcessMsg);
-                            pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
+                            pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), msgs);
                             pnode->nProcessQueueSize += nSizeAdded;
                             pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
                         }
-                        WakeMessageHandler();
+                        WakeMessageHandler(pnode);
                     }
                 }
                 else if (nBytes == 0)
@@ -1394,63 +1940,61 @@ void CConnman::ThreadSocketHandler()
             //
             // Send
             //
-            if (sendSet)
+            if (events.fSend)
             {
                 LOCK(pnode->cs_vSend);
                 size_t nBytes = SocketSendData(pnode);
                 if (nBytes) {
                     RecordBytesSent(nBytes);
                 }
+                // A partial write may leave the socket writable
+                fRearm |= !pnode->vSendMsg.empty();
             }
 
-            //
-            // Inactivity checking
-            //
-            int64_t nTime = GetSystemTimeInSeconds();
-            if (nTime - pnode->nTimeConnected > 60)
-            {
-                if (pnode->nLastRecv == 0 || pnode->nLastSend == 0)
-                {
-                    LogPrint(BCLog::NET, "socket no message in first 60 seconds, %d %d from %d\n", pnode->nLastRecv != 0, pnode->nLastSend != 0, pnode->GetId());
-                    pnode->fDisconnect = true;
-                }
-                else if (nTime - pnode->nLastSend > TIMEOUT_INTERVAL)
-                {
-                    LogPrintf("socket sending timeout: %is\n", nTime - pnode->nLastSend);
-                    pnode->fDisconnect = true;
-                }
-                else if (nTime - pnode->nLastRecv > (pnode->nVersion > BIP0031_VERSION ? TIMEOUT_INTERVAL : 90*60))
-                {
-                    LogPrintf("socket receive timeout: %is\n", nTime - pnode->nLastRecv);
-                    pnode->fDisconnect = true;
-                }
-                else if (pnode->nPingNonceSent && pnode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
-                {
-                    LogPrintf("ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pnode->nPingUsecStart));
-                    pnode->fDisconnect = true;
-                }
-                else if (!pnode->fSuccessfullyConnected)
-                {
-                    LogPrintf("version handshake timeout from %d\n", pnode->GetId());
-                    pnode->fDisconnect = true;
-                }
-            }
+            UpdateSocketInterest(pnode, fRearm);
         }
         {
             LOCK(cs_vNodes);
-            for (CNode* pnode : vNodesCopy)
-                pnode->Release();
+            for (const NodeSocketEvents& events : vReady)
+                events.pnode->Release();
+        }
+
+        //
+        // Inactivity checking, once a second
+        //
+        int64_t nTime = GetSystemTimeInSeconds();
+        if (nTime != nLastInactivityCheck)
+        {
+            nLastInactivityCheck = nTime;
+            LOCK(cs_vNodes);
+            for (CNode* pnode : vNodes)
+                InactivityCheck(pnode, nTime);
         }
     }
 }
 
 void CConnman::WakeMessageHandler()
 {
-    {
-        std::lock_guard<std::mutex> lock(mutexMsgProc);
-        fMsgProcWake = true;
+    std::lock_guard<std::mutex> lock(mutexMsgProc);
+    for (const auto& handler : vMessageHandlers) {
+        handler->fWake = true;
+        handler->cond.notify_one();
     }
-    condMsgProc.notify_one();
+}
+
+void CConnman::WakeMessageHandler(const CNode* pnode)
+{
+    std::lock_guard<std::mutex> lock(mutexMsgProc);
+    if (vMessageHandlers.empty())
+        return;
+    MessageHandler& handler = *vMessageHandlers[GetMessageHandler(pnode)];
+    handler.fWake = true;
+    handler.cond.notify_one();
+}
+
+int CConnman::GetMessageHandler(const CNode* pnode) const
+{
+    return pnode->GetId() % nMsgHandThreads;
 }
 
 
@@ -1988,19 +2532,24 @@ void CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
+        RegisterNodeSocket(pnode);
     }
 }
 
-void CConnman::ThreadMessageHandler()
+void CConnman::ThreadMessageHandler(int nHandler)
 {
+    MessageHandler& handler = *vMessageHandlers[nHandler];
     while (!flagInterruptMsgProc)
     {
+        // Thor: Each node is handled by one thread only, so its messages are processed in order
         std::vector<CNode*> vNodesCopy;
         {
             LOCK(cs_vNodes);
-            vNodesCopy = vNodes;
-            for (CNode* pnode : vNodesCopy) {
+            for (CNode* pnode : vNodes) {
+                if (GetMessageHandler(pnode) != nHandler)
+                    continue;
                 pnode->AddRef();
+                vNodesCopy.push_back(pnode);
             }
         }
 
@@ -2014,6 +2563,9 @@ void CConnman::ThreadMessageHandler()
             // Receive messages
             bool fMoreNodeWork = m_msgproc->ProcessMessages(pnode, flagInterruptMsgProc);
             fMoreWork |= (fMoreNodeWork && !pnode->fPauseSend);
+            // Thor: Have the socket handler resume receiving as soon as the queue is back under the flood limit
+            if (pnode->fRecvInterestPaused && !pnode->fPauseRecv)
+                SocketInterestChanged(pnode);
             if (flagInterruptMsgProc)
                 return;
             // Send messages
@@ -2034,9 +2586,9 @@ void CConnman::ThreadMessageHandler()
 
         std::unique_lock<std::mutex> lock(mutexMsgProc);
         if (!fMoreWork) {
-            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this] { return fMsgProcWake; });
+            handler.cond.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [&handler] { return handler.fWake; });
         }
-        fMsgProcWake = false;
+        handler.fWake = false;
     }
 }
 
@@ -2203,6 +2755,11 @@ CConnman::CConnman(uint64_t nSeed0In, uint64_t nSeed1In) : nSeed0(nSeed0In), nSe
     nReceiveFloodSize = 0;
     flagInterruptMsgProc = false;
     SetTryNewOutboundPeer(false);
+    hWakeupPipe[0] = hWakeupPipe[1] = -1;
+    fWakeupPending = false;
+#ifdef USE_EPOLL
+    hEpoll = -1;
+#endif
 
     Options connOptions;
     Init(connOptions);
@@ -2329,7 +2886,18 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
 
     {
         std::unique_lock<std::mutex> lock(mutexMsgProc);
-        fMsgProcWake = false;
+        vMessageHandlers.clear();
+        for (int i = 0; i < nMsgHandThreads; i++)
+            vMessageHandlers.emplace_back(new MessageHandler());
+    }
+
+    if (!InitSocketEvents()) {
+        if (clientInterface) {
+            clientInterface->ThreadSafeMessageBox(
+                _("Failed to set up waiting on network sockets."),
+                "", CClientUIInterface::MSG_ERROR);
+        }
+        return false;
     }
 
     // Send and receive from sockets, accept connections
@@ -2355,7 +2923,13 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         threadOpenConnections = std::thread(&TraceThread<std::function<void()> >, "opencon", std::function<void()>(std::bind(&CConnman::ThreadOpenConnections, this, connOptions.m_specified_outgoing)));
 
     // Process messages
-    threadMessageHandler = std::thread(&TraceThread<std::function<void()> >, "msghand", std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this)));
+    for (int i = 0; i < nMsgHandThreads; i++) {
+        MessageHandler& handler = *vMessageHandlers[i];
+        handler.strName = i == 0 ? "msghand" : strprintf("msghand.%d", i);
+        handler.thread = std::thread(&TraceThread<std::function<void()> >, handler.strName.c_str(), std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this, i)));
+    }
+    if (nMsgHandThreads > 1)
+        LogPrintf("Using %d message handler threads\n", nMsgHandThreads);
 
     // Dump network addresses
     scheduler.scheduleEvery(std::bind(&CConnman::DumpData, this), DUMP_ADDRESSES_INTERVAL * 1000);
@@ -2383,10 +2957,12 @@ void CConnman::Interrupt()
     {
         std::lock_guard<std::mutex> lock(mutexMsgProc);
         flagInterruptMsgProc = true;
+        for (const auto& handler : vMessageHandlers)
+            handler->cond.notify_all();
     }
-    condMsgProc.notify_all();
 
     interruptNet();
+    WakeSocketHandler();
     InterruptSocks5(true);
 
     if (semOutbound) {
@@ -2404,8 +2980,10 @@ void CConnman::Interrupt()
 
 void CConnman::Stop()
 {
-    if (threadMessageHandler.joinable())
-        threadMessageHandler.join();
+    for (const auto& handler : vMessageHandlers) {
+        if (handler->thread.joinable())
+            handler->thread.join();
+    }
     if (threadOpenConnections.joinable())
         threadOpenConnections.join();
     if (threadOpenAddedConnections.joinable())
@@ -2428,6 +3006,7 @@ void CConnman::Stop()
         if (hListenSocket.socket != INVALID_SOCKET)
             if (!CloseSocket(hListenSocket.socket))
                 LogPrintf("CloseSocket(hListenSocket) failed with error %s\n", NetworkErrorString(WSAGetLastError()));
+    CloseSocketEvents();
 
     // clean up some globals (to help leak detection)
     for (CNode *pnode : vNodes) {
@@ -2740,6 +3319,9 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     nextSendTimeFeeFilter = 0;
     fPauseRecv = false;
     fPauseSend = false;
+    nSocketInterest = 0;
+    fSocketRegistered = false;
+    fRecvInterestPaused = false;
     nProcessQueueSize = 0;
 
     for (const std::string &msg : getAllNetMessageTypes())
@@ -2797,19 +3379,31 @@ bool CConnman::NodeFullyConnected(const CNode* pnode)
     return pnode && pnode->fSuccessfullyConnected && !pnode->fDisconnect;
 }
 
-void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
+CSharedNetMsgRef MakeSharedNetMsg(CSerializedNetMsg&& msg)
 {
-    size_t nMessageSize = msg.data.size();
-    size_t nTotalSize = nMessageSize + CMessageHeader::HEADER_SIZE;
-    LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n",  SanitizeString(msg.command.c_str()), nMessageSize, pnode->GetId());
+    std::shared_ptr<CSharedNetMsg> shared = std::make_shared<CSharedNetMsg>();
+    shared->data = std::move(msg.data);
+    shared->command = std::move(msg.command);
 
-    std::vector<unsigned char> serializedHeader;
-    serializedHeader.reserve(CMessageHeader::HEADER_SIZE);
-    uint256 hash = Hash(msg.data.data(), msg.data.data() + nMessageSize);
-    CMessageHeader hdr(Params().MessageStart(), msg.command.c_str(), nMessageSize);
+    shared->header.reserve(CMessageHeader::HEADER_SIZE);
+    uint256 hash = Hash(shared->data.data(), shared->data.data() + shared->data.size());
+    CMessageHeader hdr(Params().MessageStart(), shared->command.c_str(), shared->data.size());
     memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
 
-    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, serializedHeader, 0, hdr};
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, shared->header, 0, hdr};
+    return shared;
+}
+
+void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
+{
+    PushMessage(pnode, MakeSharedNetMsg(std::move(msg)));
+}
+
+void CConnman::PushMessage(CNode* pnode, const CSharedNetMsgRef& msg)
+{
+    size_t nMessageSize = msg->data.size();
+    size_t nTotalSize = msg->size();
+    LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n",  SanitizeString(msg->command.c_str()), nMessageSize, pnode->GetId());
 
     size_t nBytesSent = 0;
     {
@@ -2817,18 +3411,20 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         bool optimisticSend(pnode->vSendMsg.empty());
 
         //log total amount of bytes per command
-        pnode->mapSendBytesPerMsgCmd[msg.command] += nTotalSize;
+        pnode->mapSendBytesPerMsgCmd[msg->command] += nTotalSize;
         pnode->nSendSize += nTotalSize;
 
         if (pnode->nSendSize > nSendBufferMaxSize)
             pnode->fPauseSend = true;
-        pnode->vSendMsg.push_back(std::move(serializedHeader));
-        if (nMessageSize)
-            pnode->vSendMsg.push_back(std::move(msg.data));
+        pnode->vSendMsg.push_back(msg);
 
         // If write queue empty, attempt "optimistic write"
         if (optimisticSend == true)
             nBytesSent = SocketSendData(pnode);
+
+        // Thor: Anything it left behind needs the socket handler to wait until the socket can take more
+        if (optimisticSend && !pnode->vSendMsg.empty())
+            SocketInterestChanged(pnode);
     }
     if (nBytesSent)
         RecordBytesSent(nBytesSent);
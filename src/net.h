@@ -83,6 +83,9 @@ static const bool DEFAULT_BLOCKSONLY = false;
 static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
+/** Thor: -msghandthreads default, and the most allowed; each peer is always handled by the same thread */
+static const int DEFAULT_MSGHAND_THREADS = 1;
+static const int MAX_MSGHAND_THREADS = 16;
 
 // NOTE: When adjusting this, update rpcnet:setban's help ("24h")
 static const unsigned int DEFAULT_MISBEHAVING_BANTIME = 60 * 60 * 24;  // Default 24-hour ban
@@ -113,6 +116,20 @@ struct CSerializedNetMsg
     std::string command;
 };
 
+/** Thor: A message serialized and checksummed once, then queued by reference to any number of peers */
+struct CSharedNetMsg
+{
+    std::vector<unsigned char> header;
+    std::vector<unsigned char> data;
+    std::string command;
+
+    size_t size() const { return header.size() + data.size(); }
+};
+typedef std::shared_ptr<const CSharedNetMsg> CSharedNetMsgRef;
+
+/** Thor: Build the header for a serialized message, taking ownership of its payload */
+CSharedNetMsgRef MakeSharedNetMsg(CSerializedNetMsg&& msg);
+
 class NetEventsInterface;
 class CConnman
 {
@@ -137,6 +154,7 @@ public:
         NetEventsInterface* m_msgproc = nullptr;
         unsigned int nSendBufferMaxSize = 0;
         unsigned int nReceiveFloodSize = 0;
+        int nMsgHandThreads = DEFAULT_MSGHAND_THREADS;
         uint64_t nMaxOutboundTimeframe = 0;
         uint64_t nMaxOutboundLimit = 0;
         std::vector<std::string> vSeedNodes;
@@ -158,6 +176,7 @@ public:
         m_msgproc = connOptions.m_msgproc;
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
+        nMsgHandThreads = std::max(1, std::min(connOptions.nMsgHandThreads, MAX_MSGHAND_THREADS));
         {
             LOCK(cs_totalBytesSent);
             nMaxOutboundTimeframe = connOptions.nMaxOutboundTimeframe;
@@ -183,6 +202,8 @@ public:
     bool ForNode(NodeId id, std::function<bool(CNode* pnode)> func);
 
     void PushMessage(CNode* pnode, CSerializedNetMsg&& msg);
+    // Thor: Queue a message that may also be queued to other peers, without copying it
+    void PushMessage(CNode* pnode, const CSharedNetMsgRef& msg);
 
     template<typename Callable>
     void ForEachNode(Callable&& func)
@@ -314,6 +335,11 @@ public:
     unsigned int GetReceiveFloodSize() const;
 
     void WakeMessageHandler();
+    /** Wake only the message handler thread that handles this node */
+    void WakeMessageHandler(const CNode* pnode);
+
+    /** Wake the socket handler from its wait, so it sees changed interest without waiting out its timeout */
+    void WakeSocketHandler();
 private:
     struct ListenSocket {
         SOCKET socket;
@@ -322,6 +348,13 @@ private:
         ListenSocket(SOCKET socket_, bool whitelisted_) : socket(socket_), whitelisted(whitelisted_) {}
     };
 
+    /** A peer socket the socket handler found ready. fRecv includes errors and hangups, which recv() reports. */
+    struct NodeSocketEvents {
+        CNode* pnode;
+        bool fRecv;
+        bool fSend;
+    };
+
     bool BindListenPort(const CService &bindAddr, std::string& strError, bool fWhitelisted = false);
     bool Bind(const CService &addr, unsigned int flags);
     bool InitBinds(const std::vector<CService>& binds, const std::vector<CService>& whiteBinds);
@@ -329,9 +362,24 @@ private:
     void AddOneShot(const std::string& strDest);
     void ProcessOneShot();
     void ThreadOpenConnections(std::vector<std::string> connect);
-    void ThreadMessageHandler();
+    void ThreadMessageHandler(int nHandler);
+    int GetMessageHandler(const CNode* pnode) const;
     void AcceptConnection(const ListenSocket& hListenSocket);
+    void DisconnectNodes();
+    void InactivityCheck(CNode* pnode, int64_t nTime);
     void ThreadSocketHandler();
+
+    // Thor: Socket events: the socket handler waits with epoll on Linux, poll() elsewhere and select() on Windows
+    bool InitSocketEvents();
+    void CloseSocketEvents();
+    /** Wait for ready sockets. Returned nodes hold a reference. Returns false if interrupted. */
+    bool SocketEvents(std::vector<NodeSocketEvents>& vReady, std::vector<const ListenSocket*>& vListenReady);
+    void DrainWakeupPipe();
+    int GetSocketInterest(CNode* pnode);
+    void RegisterNodeSocket(CNode* pnode);
+    void UpdateSocketInterest(CNode* pnode, bool fRearm);
+    /** Called off the socket handler thread when a node's socket interest may have changed */
+    void SocketInterestChanged(CNode* pnode);
     void ThreadDNSAddressSeed();
 
     uint64_t CalculateKeyedNetGroup(const CAddress& ad) const;
@@ -385,6 +433,7 @@ private:
 
     unsigned int nSendBufferMaxSize;
     unsigned int nReceiveFloodSize;
+    int nMsgHandThreads;
 
     std::vector<ListenSocket> vhListenSocket;
     std::atomic<bool> fNetworkActive;
@@ -418,20 +467,31 @@ private:
     /** SipHasher seeds for deterministic randomness */
     const uint64_t nSeed0, nSeed1;
 
-    /** flag for waking the message processor. */
-    bool fMsgProcWake;
+    /** Thor: A message handler thread, and the flag for waking it (protected by mutexMsgProc) */
+    struct MessageHandler {
+        std::string strName;            //!< Thread name; must outlive the thread, which keeps a pointer to it
+        std::thread thread;
+        bool fWake = false;
+        std::condition_variable cond;
+    };
+    std::vector<std::unique_ptr<MessageHandler>> vMessageHandlers;
 
-    std::condition_variable condMsgProc;
     std::mutex mutexMsgProc;
     std::atomic<bool> flagInterruptMsgProc;
 
     CThreadInterrupt interruptNet;
 
+    /** Written to wake the socket handler; both ends are -1 where select() is used */
+    int hWakeupPipe[2];
+    std::atomic<bool> fWakeupPending;
+#ifdef USE_EPOLL
+    int hEpoll;
+#endif
+
     std::thread threadDNSAddressSeed;
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
-    std::thread threadMessageHandler;
 
     /** flag for deciding to connect to an extra outbound peer,
      *  in excess of nMaxOutbound
@@ -518,6 +578,17 @@ extern CCriticalSection cs_mapLocalHost;
 extern std::map<CNetAddr, LocalServiceInfo> mapLocalHost;
 typedef std::map<std::string, uint64_t> mapMsgCmdSize; //command, total bytes
 
+/** Thor: How long messages of one type waited between arriving and being processed */
+struct CMsgQueueTime
+{
+    uint64_t nCount;
+    int64_t nTotalMicros;
+    int64_t nMaxMicros;
+
+    CMsgQueueTime() : nCount(0), nTotalMicros(0), nMaxMicros(0) {}
+};
+typedef std::map<std::string, CMsgQueueTime> mapMsgCmdQueueTime;
+
 class CNodeStats
 {
 public:
@@ -538,6 +609,7 @@ public:
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     uint64_t nRecvBytes;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdQueueTime mapRecvQueueTimePerMsgCmd;
     bool fWhitelisted;
     double dPingTime;
     double dPingWait;
@@ -553,6 +625,61 @@ public:
 
 
 
+/** Thor: Counters for the receive buffer pool, reported by getnettotals */
+struct CRecvBufferStats
+{
+    uint64_t nAllocations;      //!< Message buffers allocated
+    uint64_t nReuses;           //!< Message buffers taken from the pool instead
+    uint64_t nCopiedBytes;      //!< Message bytes copied, from the socket handler's buffer or an outgrown message buffer
+    uint64_t nInPlaceBytes;     //!< Message bytes received straight into their message buffer
+    uint64_t nPooledBytes;      //!< Bytes held in the pool for reuse
+};
+
+/**
+ * Thor: Keeps the data buffers of processed messages for reuse. Buffers are sized in
+ * powers of two, so a busy peer costs neither an allocation nor the cleanse on free
+ * for each message it sends.
+ */
+class CRecvBufferPool
+{
+public:
+    /** Smallest buffer handed out; the sizes double from here to cover MAX_PROTOCOL_MESSAGE_LENGTH */
+    static const size_t MIN_BUFFER_SIZE = 64;
+    static const int BUFFER_SIZE_CLASSES = 17;
+    /**
+     * Most buffers of each size, and most bytes in all, kept for reuse; buffers released beyond
+     * these are freed. The pool is for the steady flow of messages, not a burst of them.
+     */
+    static const size_t MAX_POOLED_PER_SIZE = 256;
+    static const size_t MAX_POOLED_BYTES = 32 * 1024 * 1024;
+
+    CRecvBufferPool() : nPooledBytes(0), nAllocations(0), nReuses(0), nCopiedBytes(0), nInPlaceBytes(0) {}
+
+    /** Resize vch to nSize, keeping its first nKeep bytes. When it has to move, it moves to a pooled buffer. */
+    void Resize(CSerializeData& vch, size_t nSize, size_t nKeep);
+    /** Give vch's buffer to the pool, leaving vch empty */
+    void Release(CSerializeData& vch);
+
+    void CountCopied(size_t nBytes) { nCopiedBytes += nBytes; }
+    void CountInPlace(size_t nBytes) { nInPlaceBytes += nBytes; }
+    CRecvBufferStats GetStats();
+
+private:
+    std::mutex mutexFree;
+    std::vector<CSerializeData> vFree[BUFFER_SIZE_CLASSES];
+    size_t nPooledBytes;
+    std::atomic<uint64_t> nAllocations;
+    std::atomic<uint64_t> nReuses;
+    std::atomic<uint64_t> nCopiedBytes;
+    std::atomic<uint64_t> nInPlaceBytes;
+};
+extern CRecvBufferPool g_recv_buffer_pool;
+
+/** Thor: Smallest remaining message body the socket handler receives straight into the message buffer */
+static const unsigned int MIN_RECV_IN_PLACE = 16 * 1024;
+/** Most the message buffer is grown ahead of the data received, so a peer can't make us allocate more */
+static const unsigned int MAX_RECV_AHEAD = 256 * 1024;
+
 class CNetMessage {
 private:
     mutable CHash256 hasher;
@@ -560,22 +687,24 @@ private:
 public:
     bool in_data;                   // parsing header (false) or data (true)
 
-    CDataStream hdrbuf;             // partially received header
+    char hdrbuf[CMessageHeader::HEADER_SIZE];   // partially received header
     CMessageHeader hdr;             // complete header
     unsigned int nHdrPos;
 
-    CDataStream vRecv;              // received message data
+    CDataStream vRecv;              // received message data, in a buffer from g_recv_buffer_pool
     unsigned int nDataPos;
 
     int64_t nTime;                  // time (in microseconds) of message receipt.
 
-    CNetMessage(const CMessageHeader::MessageStartChars& pchMessageStartIn, int nTypeIn, int nVersionIn) : hdrbuf(nTypeIn, nVersionIn), hdr(pchMessageStartIn), vRecv(nTypeIn, nVersionIn) {
-        hdrbuf.resize(24);
+    CNetMessage(const CMessageHeader::MessageStartChars& pchMessageStartIn, int nTypeIn, int nVersionIn) : hdr(pchMessageStartIn), vRecv(nTypeIn, nVersionIn) {
         in_data = false;
         nHdrPos = 0;
         nDataPos = 0;
         nTime = 0;
     }
+    ~CNetMessage();
+    CNetMessage(CNetMessage&&) = default;
+    CNetMessage& operator=(CNetMessage&&) = default;
 
     bool complete() const
     {
@@ -588,12 +717,17 @@ public:
 
     void SetVersion(int nVersionIn)
     {
-        hdrbuf.SetVersion(nVersionIn);
         vRecv.SetVersion(nVersionIn);
     }
 
     int readHeader(const char *pch, unsigned int nBytes);
     int readData(const char *pch, unsigned int nBytes);
+
+    /**
+     * Thor: Where up to nBytes more of the message body can be received in place, to be passed
+     * to readData without a copy. nBytes is trimmed to what remains of the message.
+     */
+    char* PrepareData(unsigned int& nBytes);
 };
 
 
@@ -606,9 +740,9 @@ public:
     std::atomic<ServiceFlags> nServices;
     SOCKET hSocket;
     size_t nSendSize; // total size of all vSendMsg entries
-    size_t nSendOffset; // offset inside the first vSendMsg already sent
+    size_t nSendOffset; // offset inside the first vSendMsg (header and data together) already sent
     uint64_t nSendBytes;
-    std::deque<std::vector<unsigned char>> vSendMsg;
+    std::deque<CSharedNetMsgRef> vSendMsg;
     CCriticalSection cs_vSend;
     CCriticalSection cs_hSocket;
     CCriticalSection cs_vRecv;
@@ -660,18 +794,26 @@ public:
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv;
     std::atomic_bool fPauseSend;
+    // Thor: What the socket handler waits on for this socket, and whether that left out
+    // receiving because of fPauseRecv, so the message handler knows to wake it once unpaused
+    int nSocketInterest; // protected by cs_hSocket
+    bool fSocketRegistered; // protected by cs_hSocket
+    std::atomic_bool fRecvInterestPaused;
 protected:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdQueueTime mapRecvQueueTimePerMsgCmd; // protected by cs_vRecv
 
 public:
     uint256 hashContinue;
     std::atomic<int> nStartingHeight;
 
     // flood relay
-    std::vector<CAddress> vAddrToSend;
-    CRollingBloomFilter addrKnown;
+    // Thor: Other peers' message handlers relay addresses into these, so they are locked
+    CCriticalSection cs_addrSend;
+    std::vector<CAddress> vAddrToSend; // protected by cs_addrSend
+    CRollingBloomFilter addrKnown; // protected by cs_addrSend
     bool fGetAddr;
     std::set<uint256> setKnown;
     int64_t nNextAddrSend;
@@ -761,6 +903,16 @@ public:
     }
 
     bool ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete);
+    /**
+     * Thor: Where the next read from the socket should go to land straight in the message being
+     * received, with nBytes set to how much fits; or nullptr if too little of it remains to be
+     * worth a read of its own. Socket handler thread only.
+     */
+    char* GetRecvBuffer(unsigned int& nBytes);
+    /** Thor: Move the fully received messages to the end of msgs. Returns their size, headers included. Socket handler thread only. */
+    size_t TakeCompleteMessages(std::list<CNetMessage>& msgs);
+    /** Thor: Record how long a message waited in the process queue, from when it was fully received */
+    void RecordQueueTime(const std::string& strCommand, int64_t nQueueMicros);
 
     void SetRecvVersion(int nVersionIn)
     {
@@ -792,11 +944,13 @@ public:
 
     void AddAddressKnown(const CAddress& _addr)
     {
+        LOCK(cs_addrSend);
         addrKnown.insert(_addr.GetKey());
     }
 
     void PushAddress(const CAddress& _addr, FastRandomContext &insecure_rand)
     {
+        LOCK(cs_addrSend);
         // Known checking here is only to save space from duplicates.
         // SendMessages will filter it again for knowns that were added
         // after addresses were pushed.
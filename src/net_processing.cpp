@@ -130,8 +130,16 @@ namespace {
     /** When our tip was last updated. */
     std::atomic<int64_t> g_last_tip_update(0);
 
+    /** Thor: A relayed transaction, and its tx messages once a peer has asked for them */
+    struct CRelayTx {
+        CTransactionRef tx;
+        CSharedNetMsgRef msgs[2];       // Indexed by whether witnesses are included
+
+        explicit CRelayTx(CTransactionRef txIn) : tx(std::move(txIn)) {}
+    };
+
     /** Relay map, protected by cs_main. */
-    typedef std::map<uint256, CTransactionRef> MapRelay;
+    typedef std::map<uint256, CRelayTx> MapRelay;
     MapRelay mapRelay;
     /** Expiration-time ordered list of (expire time, relay map entry) pairs, protected by cs_main). */
     std::deque<std::pair<int64_t, MapRelay::iterator>> vRelayExpiration;
@@ -846,6 +854,109 @@ static std::shared_ptr<const CBlockHeaderAndShortTxIDs> most_recent_compact_bloc
 static uint256 most_recent_block_hash;
 static bool fWitnessesPresentInMostRecentCompactBlock;
 
+// Thor: Messages for the most recent block, serialized and checksummed on first use and then shared by
+// every peer they go to. Also protected by cs_most_recent_block.
+static CSharedNetMsgRef most_recent_block_msgs[2];          // block, indexed by whether witnesses are included
+static CSharedNetMsgRef most_recent_compact_block_msgs[2];  // cmpctblock, indexed by whether the peer wants witnesses
+static CSharedNetMsgRef most_recent_headers_msg;            // headers announcing just this block
+
+/** Thor: The block message for the most recent block, or null if hashBlock isn't it */
+static CSharedNetMsgRef GetRecentBlockMsg(const uint256& hashBlock, bool fWitness)
+{
+    LOCK(cs_most_recent_block);
+    if (!most_recent_block || most_recent_block_hash != hashBlock)
+        return nullptr;
+    CSharedNetMsgRef& msg = most_recent_block_msgs[fWitness];
+    if (!msg)
+        msg = MakeSharedNetMsg(CNetMsgMaker(PROTOCOL_VERSION).Make(fWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::BLOCK, *most_recent_block));
+    return msg;
+}
+
+/** Thor: The cmpctblock message for the most recent block, or null if hashBlock isn't it */
+static CSharedNetMsgRef GetRecentCompactBlockMsg(const uint256& hashBlock, bool fWantsCmpctWitness)
+{
+    LOCK(cs_most_recent_block);
+    if (!most_recent_block || most_recent_block_hash != hashBlock)
+        return nullptr;
+    CSharedNetMsgRef& msg = most_recent_compact_block_msgs[fWantsCmpctWitness];
+    if (!msg) {
+        const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+        int nSendFlags = fWantsCmpctWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
+        if (fWantsCmpctWitness || !fWitnessesPresentInMostRecentCompactBlock) {
+            msg = MakeSharedNetMsg(msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, *most_recent_compact_block));
+        } else {
+            CBlockHeaderAndShortTxIDs cmpctblock(*most_recent_block, fWantsCmpctWitness);
+            msg = MakeSharedNetMsg(msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
+        }
+    }
+    return msg;
+}
+
+/** Thor: The headers message for a lone header of the most recent block, or null for anything else */
+static CSharedNetMsgRef GetRecentHeadersMsg(const std::vector<CBlock>& vHeaders)
+{
+    if (vHeaders.size() != 1)
+        return nullptr;
+    LOCK(cs_most_recent_block);
+    if (!most_recent_block || most_recent_block_hash != vHeaders.front().GetHash())
+        return nullptr;
+    if (!most_recent_headers_msg)
+        most_recent_headers_msg = MakeSharedNetMsg(CNetMsgMaker(PROTOCOL_VERSION).Make(NetMsgType::HEADERS, vHeaders));
+    return most_recent_headers_msg;
+}
+
+// Thor: Block messages recently sent from disk, most recently used first, so peers syncing the same
+// stretch of chain share one read. Keyed by block hash and whether witnesses are included, and
+// protected by cs_raw_block_msgs.
+static const size_t MAX_RAW_BLOCK_MSGS_SIZE = 16 * 1024 * 1024;
+typedef std::pair<uint256, bool> RawBlockMsgKey;
+static CCriticalSection cs_raw_block_msgs;
+static std::list<std::pair<RawBlockMsgKey, CSharedNetMsgRef>> raw_block_msgs;
+static std::map<RawBlockMsgKey, std::list<std::pair<RawBlockMsgKey, CSharedNetMsgRef>>::iterator> raw_block_msgs_index;
+static size_t raw_block_msgs_size = 0;
+
+/**
+ * Thor: The block message for a block on disk, sending its bytes as stored, less the witness data
+ * if fWitness isn't set. Null if it can't be read that way.
+ */
+static CSharedNetMsgRef GetRawBlockMsg(const CBlockIndex* pindex, bool fWitness)
+{
+    const RawBlockMsgKey key(pindex->GetBlockHash(), fWitness);
+    {
+        LOCK(cs_raw_block_msgs);
+        auto it = raw_block_msgs_index.find(key);
+        if (it != raw_block_msgs_index.end()) {
+            raw_block_msgs.splice(raw_block_msgs.begin(), raw_block_msgs, it->second);
+            return it->second->second;
+        }
+    }
+
+    CSerializedNetMsg block;
+    block.command = NetMsgType::BLOCK;
+    if (!ReadRawBlockFromDisk(block.data, pindex, Params().MessageStart()))
+        return nullptr;
+    if (!fWitness) {
+        std::vector<unsigned char> stripped;
+        if (!StripBlockWitness(block.data, stripped))
+            return nullptr;
+        block.data.swap(stripped);
+    }
+    CSharedNetMsgRef msg = MakeSharedNetMsg(std::move(block));
+
+    LOCK(cs_raw_block_msgs);
+    if (!raw_block_msgs_index.count(key)) {
+        raw_block_msgs.emplace_front(key, msg);
+        raw_block_msgs_index.emplace(key, raw_block_msgs.begin());
+        raw_block_msgs_size += msg->size();
+        while (raw_block_msgs_size > MAX_RAW_BLOCK_MSGS_SIZE) {
+            raw_block_msgs_size -= raw_block_msgs.back().second->size();
+            raw_block_msgs_index.erase(raw_block_msgs.back().first);
+            raw_block_msgs.pop_back();
+        }
+    }
+    return msg;
+}
+
 void PeerLogicValidation::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) {
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> pcmpctblock = std::make_shared<const CBlockHeaderAndShortTxIDs> (*pblock, true);
     const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
@@ -866,10 +977,16 @@ void PeerLogicValidation::NewPoWValidBlock(const CBlockIndex *pindex, const std:
         most_recent_block = pblock;
         most_recent_compact_block = pcmpctblock;
         fWitnessesPresentInMostRecentCompactBlock = fWitnessEnabled;
+        for (int i = 0; i < 2; i++) {
+            most_recent_block_msgs[i].reset();
+            most_recent_compact_block_msgs[i].reset();
+        }
+        most_recent_headers_msg.reset();
     }
 
-    connman->ForEachNode([this, &pcmpctblock, pindex, &msgMaker, fWitnessEnabled, &hashBlock](CNode* pnode) {
-        // TODO: Avoid the repeated-serialization here
+    // Thor: Serialized once, on the first peer it goes to
+    CSharedNetMsgRef msgCmpctBlock;
+    connman->ForEachNode([this, &pcmpctblock, pindex, &msgMaker, fWitnessEnabled, &hashBlock, &msgCmpctBlock](CNode* pnode) {
         if (pnode->nVersion < INVALID_CB_NO_BAN_VERSION || pnode->fDisconnect)
             return;
         ProcessBlockAvailability(pnode->GetId());
@@ -881,7 +998,9 @@ void PeerLogicValidation::NewPoWValidBlock(const CBlockIndex *pindex, const std:
 
             LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", "PeerLogicValidation::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->GetId());
-            connman->PushMessage(pnode, msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
+            if (!msgCmpctBlock)
+                msgCmpctBlock = MakeSharedNetMsg(msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
+            connman->PushMessage(pnode, msgCmpctBlock);
             state.pindexBestHeaderSent = pindex;
         }
     });
@@ -1038,17 +1157,28 @@ static void RelayAddress(const CAddress& addr, bool fReachable, CConnman* connma
     connman->ForEachNodeThen(std::move(sortfunc), std::move(pushfunc));
 }
 
+/** Trigger the peer node to send a getblocks request for the next batch of inventory */
+static void SendContinueInv(CNode* pfrom, CConnman* connman, const CNetMsgMaker& msgMaker, const uint256& hashContinueTip)
+{
+    if (!hashContinueTip.IsNull())
+    {
+        // Bypass PushInventory, this must send even if redundant,
+        // and we want it right after the last block so they don't
+        // wait for other stuff first.
+        std::vector<CInv> vInv;
+        vInv.push_back(CInv(MSG_BLOCK, hashContinueTip));
+        connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::INV, vInv));
+        pfrom->hashContinue.SetNull();
+    }
+}
+
 void static ProcessGetBlockData(CNode* pfrom, const Consensus::Params& consensusParams, const CInv& inv, CConnman* connman, const std::atomic<bool>& interruptMsgProc)
 {
     bool send = false;
     std::shared_ptr<const CBlock> a_recent_block;
-    std::shared_ptr<const CBlockHeaderAndShortTxIDs> a_recent_compact_block;
-    bool fWitnessesPresentInARecentCompactBlock;
     {
         LOCK(cs_most_recent_block);
         a_recent_block = most_recent_block;
-        a_recent_compact_block = most_recent_compact_block;
-        fWitnessesPresentInARecentCompactBlock = fWitnessesPresentInMostRecentCompactBlock;
     }
 
     bool need_activate_chain = false;
@@ -1073,111 +1203,142 @@ void static ProcessGetBlockData(CNode* pfrom, const Consensus::Params& consensus
         ActivateBestChain(dummy, Params(), a_recent_block);
     }
 
-    LOCK(cs_main);
-    BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
-    if (mi != mapBlockIndex.end()) {
-        send = BlockRequestAllowed(mi->second, consensusParams);
-        if (!send) {
-            LogPrint(BCLog::NET, "%s: ignoring request from peer=%i for old block that isn't in the main chain\n", __func__, pfrom->GetId());
-        }
-    }
-    const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
-    // disconnect node in case we have reached the outbound limit for serving historical blocks
-    // never disconnect whitelisted nodes
-    if (send && connman->OutboundTargetReached(true) && ( ((pindexBestHeader != nullptr) && (pindexBestHeader->GetBlockTime() - mi->second->GetBlockTime() > HISTORICAL_BLOCK_AGE)) || inv.type == MSG_FILTERED_BLOCK) && !pfrom->fWhitelisted)
+    // Thor: Decide what to send under cs_main, then read and serialize the block without it, so
+    // peers fetching history from disk don't hold up validation and every other peer
+    const CBlockIndex* pindex = nullptr;
+    bool fPeerWantsWitness = false;
+    bool fSendCompact = false;
+    bool fRawRead = false;
+    uint256 hashContinueTip;
     {
-        LogPrint(BCLog::NET, "historical block serving limit reached, disconnect peer=%d\n", pfrom->GetId());
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
+        if (mi != mapBlockIndex.end()) {
+            send = BlockRequestAllowed(mi->second, consensusParams);
+            if (!send) {
+                LogPrint(BCLog::NET, "%s: ignoring request from peer=%i for old block that isn't in the main chain\n", __func__, pfrom->GetId());
+            }
+        }
+        // disconnect node in case we have reached the outbound limit for serving historical blocks
+        // never disconnect whitelisted nodes
+        if (send && connman->OutboundTargetReached(true) && ( ((pindexBestHeader != nullptr) && (pindexBestHeader->GetBlockTime() - mi->second->GetBlockTime() > HISTORICAL_BLOCK_AGE)) || inv.type == MSG_FILTERED_BLOCK) && !pfrom->fWhitelisted)
+        {
+            LogPrint(BCLog::NET, "historical block serving limit reached, disconnect peer=%d\n", pfrom->GetId());
 
-        //disconnect node
-        pfrom->fDisconnect = true;
-        send = false;
+            //disconnect node
+            pfrom->fDisconnect = true;
+            send = false;
+        }
+        // Avoid leaking prune-height by never sending blocks below the NODE_NETWORK_LIMITED threshold
+        if (send && !pfrom->fWhitelisted && (
+                (((pfrom->GetLocalServices() & NODE_NETWORK_LIMITED) == NODE_NETWORK_LIMITED) && ((pfrom->GetLocalServices() & NODE_NETWORK) != NODE_NETWORK) && (chainActive.Tip()->nHeight - mi->second->nHeight > (int)NODE_NETWORK_LIMITED_MIN_BLOCKS + 2 /* add two blocks buffer extension for possible races */) )
+           )) {
+            LogPrint(BCLog::NET, "Ignore block request below NODE_NETWORK_LIMITED threshold from peer=%d\n", pfrom->GetId());
+
+            //disconnect node and prevent it from stalling (would otherwise wait for the missing block)
+            pfrom->fDisconnect = true;
+            send = false;
+        }
+        // Pruned nodes may have deleted the block, so check whether
+        // it's available before trying to send.
+        if (!send || !(mi->second->nStatus & BLOCK_HAVE_DATA))
+            return;
+
+        pindex = mi->second;
+        if (inv.type == MSG_CMPCT_BLOCK) {
+            fPeerWantsWitness = State(pfrom->GetId())->fWantsCmpctWitness;
+            fSendCompact = CanDirectFetch(consensusParams) && pindex->nHeight >= chainActive.Height() - MAX_CMPCTBLOCK_DEPTH;
+        }
+        if (inv.hash == pfrom->hashContinue)
+            hashContinueTip = chainActive.Tip()->GetBlockHash();
+        // As ReadBlockFromDisk would, trust the proof of a block that passed validation
+        fRawRead = !fVerifyBlockReads && pindex->IsValid(BLOCK_VALID_SCRIPTS);
     }
-    // Avoid leaking prune-height by never sending blocks below the NODE_NETWORK_LIMITED threshold
-    if (send && !pfrom->fWhitelisted && (
-            (((pfrom->GetLocalServices() & NODE_NETWORK_LIMITED) == NODE_NETWORK_LIMITED) && ((pfrom->GetLocalServices() & NODE_NETWORK) != NODE_NETWORK) && (chainActive.Tip()->nHeight - mi->second->nHeight > (int)NODE_NETWORK_LIMITED_MIN_BLOCKS + 2 /* add two blocks buffer extension for possible races */) )
-       )) {
-        LogPrint(BCLog::NET, "Ignore block request below NODE_NETWORK_LIMITED threshold from peer=%d\n", pfrom->GetId());
 
-        //disconnect node and prevent it from stalling (would otherwise wait for the missing block)
-        pfrom->fDisconnect = true;
-        send = false;
+    const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
+    const bool fRecentBlock = a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash();
+
+    // Thor: A full block goes out from a message shared with every other peer fetching it: the most
+    // recent block's, or else one holding the block's bytes as they are on disk. A peer syncing the
+    // chain then costs a read and a checksum per block rather than a deserialize and serialize.
+    const bool fFullBlock = inv.type == MSG_BLOCK || inv.type == MSG_WITNESS_BLOCK || (inv.type == MSG_CMPCT_BLOCK && !fSendCompact);
+    const bool fWitness = inv.type == MSG_WITNESS_BLOCK || (inv.type == MSG_CMPCT_BLOCK && fPeerWantsWitness);
+    if (fFullBlock) {
+        CSharedNetMsgRef msg = GetRecentBlockMsg(pindex->GetBlockHash(), fWitness);
+        if (!msg && !fRecentBlock && fRawRead)
+            msg = GetRawBlockMsg(pindex, fWitness);
+        if (msg) {
+            connman->PushMessage(pfrom, msg);
+            SendContinueInv(pfrom, connman, msgMaker, hashContinueTip);
+            return;
+        }
     }
-    // Pruned nodes may have deleted the block, so check whether
-    // it's available before trying to send.
-    if (send && (mi->second->nStatus & BLOCK_HAVE_DATA))
-    {
-        std::shared_ptr<const CBlock> pblock;
-        if (a_recent_block && a_recent_block->GetHash() == (*mi).second->GetBlockHash()) {
-            pblock = a_recent_block;
-        } else {
-            // Send block from disk
-            std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
-            if (!ReadBlockFromDisk(*pblockRead, (*mi).second, consensusParams))
-                assert(!"cannot load block from disk");
-            pblock = pblockRead;
-        }
-        if (inv.type == MSG_BLOCK)
-            connman->PushMessage(pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::BLOCK, *pblock));
-        else if (inv.type == MSG_WITNESS_BLOCK)
-            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCK, *pblock));
-        else if (inv.type == MSG_FILTERED_BLOCK)
-        {
-            bool sendMerkleBlock = false;
-            CMerkleBlock merkleBlock;
+
+    std::shared_ptr<const CBlock> pblock;
+    if (fRecentBlock) {
+        pblock = a_recent_block;
+    } else {
+        // Send block from disk
+        std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
+        if (!ReadBlockFromDisk(*pblockRead, pindex, consensusParams)) {
+            // Without cs_main held, the block may have been pruned since it was checked for
             {
-                LOCK(pfrom->cs_filter);
-                if (pfrom->pfilter) {
-                    sendMerkleBlock = true;
-                    merkleBlock = CMerkleBlock(*pblock, *pfrom->pfilter);
-                }
-            }
-            if (sendMerkleBlock) {
-                connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MERKLEBLOCK, merkleBlock));
-                // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
-                // This avoids hurting performance by pointlessly requiring a round-trip
-                // Note that there is currently no way for a node to request any single transactions we didn't send here -
-                // they must either disconnect and retry or request the full block.
-                // Thus, the protocol spec specified allows for us to provide duplicate txn here,
-                // however we MUST always provide at least what the remote peer needs
-                typedef std::pair<unsigned int, uint256> PairType;
-                for (PairType& pair : merkleBlock.vMatchedTxn)
-                    connman->PushMessage(pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::TX, *pblock->vtx[pair.first]));
-            }
-            // else
-                // no response
-        }
-        else if (inv.type == MSG_CMPCT_BLOCK)
-        {
-            // If a peer is asking for old blocks, we're almost guaranteed
-            // they won't have a useful mempool to match against a compact block,
-            // and we don't feel like constructing the object for them, so
-            // instead we respond with the full, non-compact block.
-            bool fPeerWantsWitness = State(pfrom->GetId())->fWantsCmpctWitness;
-            int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-            if (CanDirectFetch(consensusParams) && mi->second->nHeight >= chainActive.Height() - MAX_CMPCTBLOCK_DEPTH) {
-                if ((fPeerWantsWitness || !fWitnessesPresentInARecentCompactBlock) && a_recent_compact_block && a_recent_compact_block->header.GetHash() == mi->second->GetBlockHash()) {
-                    connman->PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, *a_recent_compact_block));
-                } else {
-                    CBlockHeaderAndShortTxIDs cmpctblock(*pblock, fPeerWantsWitness);
-                    connman->PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
-                }
-            } else {
-                connman->PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCK, *pblock));
+                LOCK(cs_main);
+                if (pindex->nStatus & BLOCK_HAVE_DATA)
+                    assert(!"cannot load block from disk");
             }
+            LogPrint(BCLog::NET, "%s: block %s was pruned before it could be read, disconnect peer=%d\n", __func__, pindex->GetBlockHash().ToString(), pfrom->GetId());
+            pfrom->fDisconnect = true;
+            return;
         }
-
-        // Trigger the peer node to send a getblocks request for the next batch of inventory
-        if (inv.hash == pfrom->hashContinue)
+        pblock = pblockRead;
+    }
+    if (fFullBlock) {
+        connman->PushMessage(pfrom, msgMaker.Make(fWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::BLOCK, *pblock));
+    }
+    else if (inv.type == MSG_FILTERED_BLOCK)
+    {
+        bool sendMerkleBlock = false;
+        CMerkleBlock merkleBlock;
         {
-            // Bypass PushInventory, this must send even if redundant,
-            // and we want it right after the last block so they don't
-            // wait for other stuff first.
-            std::vector<CInv> vInv;
-            vInv.push_back(CInv(MSG_BLOCK, chainActive.Tip()->GetBlockHash()));
-            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::INV, vInv));
-            pfrom->hashContinue.SetNull();
+            LOCK(pfrom->cs_filter);
+            if (pfrom->pfilter) {
+                sendMerkleBlock = true;
+                merkleBlock = CMerkleBlock(*pblock, *pfrom->pfilter);
+            }
+        }
+        if (sendMerkleBlock) {
+            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MERKLEBLOCK, merkleBlock));
+            // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
+            // This avoids hurting performance by pointlessly requiring a round-trip
+            // Note that there is currently no way for a node to request any single transactions we didn't send here -
+            // they must either disconnect and retry or request the full block.
+            // Thus, the protocol spec specified allows for us to provide duplicate txn here,
+            // however we MUST always provide at least what the remote peer needs
+            typedef std::pair<unsigned int, uint256> PairType;
+            for (PairType& pair : merkleBlock.vMatchedTxn)
+                connman->PushMessage(pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::TX, *pblock->vtx[pair.first]));
+        }
+        // else
+            // no response
+    }
+    else if (inv.type == MSG_CMPCT_BLOCK)
+    {
+        // If a peer is asking for old blocks, we're almost guaranteed
+        // they won't have a useful mempool to match against a compact block,
+        // and we don't feel like constructing the object for them, so
+        // instead we respond with the full, non-compact block (fFullBlock above).
+        int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
+        CSharedNetMsgRef msg = GetRecentCompactBlockMsg(pindex->GetBlockHash(), fPeerWantsWitness);
+        if (msg) {
+            connman->PushMessage(pfrom, msg);
+        } else {
+            CBlockHeaderAndShortTxIDs cmpctblock(*pblock, fPeerWantsWitness);
+            connman->PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
         }
     }
+
+    SendContinueInv(pfrom, connman, msgMaker, hashContinueTip);
 }
 
 void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParams, CConnman* connman, const std::atomic<bool>& interruptMsgProc)
@@ -1205,7 +1366,11 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
             auto mi = mapRelay.find(inv.hash);
             int nSendFlags = (inv.type == MSG_TX ? SERIALIZE_TRANSACTION_NO_WITNESS : 0);
             if (mi != mapRelay.end()) {
-                connman->PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::TX, *mi->second));
+                // Thor: Serialize each relayed transaction once for all the peers that ask for it
+                CSharedNetMsgRef& msg = mi->second.msgs[inv.type == MSG_WITNESS_TX];
+                if (!msg)
+                    msg = MakeSharedNetMsg(msgMaker.Make(nSendFlags, NetMsgType::TX, *mi->second.tx));
+                connman->PushMessage(pfrom, msg);
                 push = true;
             } else if (pfrom->timeLastMempoolReq) {
                 auto txinfo = mempool.info(inv.hash);
@@ -2668,7 +2833,10 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         }
         pfrom->fSentAddr = true;
 
-        pfrom->vAddrToSend.clear();
+        {
+            LOCK(pfrom->cs_addrSend);
+            pfrom->vAddrToSend.clear();
+        }
         std::vector<CAddress> vAddr = connman->GetAddresses();
         FastRandomContext insecure_rand;
         for (const CAddress &addr : vAddr)
@@ -2959,6 +3127,8 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
         return fMoreWork;
     }
 
+    pfrom->RecordQueueTime(strCommand, GetTimeMicros() - msg.nTime);
+
     // Process message
     bool fRet = false;
     try
@@ -3215,6 +3385,7 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
         //
         if (pto->nNextAddrSend < nNow) {
             pto->nNextAddrSend = PoissonNextSend(nNow, AVG_ADDRESS_BROADCAST_INTERVAL);
+            LOCK(pto->cs_addrSend);
             std::vector<CAddress> vAddr;
             vAddr.reserve(pto->vAddrToSend.size());
             for (const CAddress& addr : pto->vAddrToSend)
@@ -3348,20 +3519,10 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
 
                     int nSendFlags = state.fWantsCmpctWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
 
-                    bool fGotBlockFromCache = false;
-                    {
-                        LOCK(cs_most_recent_block);
-                        if (most_recent_block_hash == pBestIndex->GetBlockHash()) {
-                            if (state.fWantsCmpctWitness || !fWitnessesPresentInMostRecentCompactBlock)
-                                connman->PushMessage(pto, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, *most_recent_compact_block));
-                            else {
-                                CBlockHeaderAndShortTxIDs cmpctblock(*most_recent_block, state.fWantsCmpctWitness);
-                                connman->PushMessage(pto, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
-                            }
-                            fGotBlockFromCache = true;
-                        }
-                    }
-                    if (!fGotBlockFromCache) {
+                    CSharedNetMsgRef msg = GetRecentCompactBlockMsg(pBestIndex->GetBlockHash(), state.fWantsCmpctWitness);
+                    if (msg) {
+                        connman->PushMessage(pto, msg);
+                    } else {
                         CBlock block;
                         bool ret = ReadBlockFromDisk(block, pBestIndex, consensusParams);
                         assert(ret);
@@ -3379,7 +3540,11 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
                         LogPrint(BCLog::NET, "%s: sending header %s to peer=%d\n", __func__,
                                 vHeaders.front().GetHash().ToString(), pto->GetId());
                     }
-                    connman->PushMessage(pto, msgMaker.Make(NetMsgType::HEADERS, vHeaders));
+                    CSharedNetMsgRef msg = GetRecentHeadersMsg(vHeaders);
+                    if (msg)
+                        connman->PushMessage(pto, msg);
+                    else
+                        connman->PushMessage(pto, msgMaker.Make(NetMsgType::HEADERS, vHeaders));
                     state.pindexBestHeaderSent = pBestIndex;
                 } else
                     fRevertToInv = true;
@@ -3531,7 +3696,7 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
                             vRelayExpiration.pop_front();
                         }
 
-                        auto ret = mapRelay.insert(std::make_pair(hash, std::move(txinfo.tx)));
+                        auto ret = mapRelay.insert(std::make_pair(hash, CRelayTx(std::move(txinfo.tx))));
                         if (ret.second) {
                             vRelayExpiration.push_back(std::make_pair(nNow + 15 * 60 * 1000000, ret.first));
                         }
@@ -18,6 +18,11 @@
 #include <sync.h>               // Thor: Forge
 #include <validation.h>         // Thor: Forge
 #include <utilstrencodings.h>   // Thor: Forge
+#include <hammerpopindex.h>      // Thor: Forge
+#include <bctindex.h>            // Thor: Forge
+#include <forgeproofcache.h>     // Thor: Forge
+#include <script/sigcache.h>     // Thor: Forge
+#include <hammerhash.h>          // Thor: Forge
 
 HammerPopGraphPoint hammerPopGraph[1024*40];       // Thor: Forge
 
@@ -34,7 +39,7 @@ unsigned int DarkGravityWave(const CBlockIndex* pindexLast, const CBlockHeader *
 
     // LitecoinCash: Forge 1.1: Skip over Forgemined blocks at tip
     if (IsForge11Enabled(pindexLast, params)) {
-        while (pindexLast->GetBlockHeader().IsForgeMined(params)) {
+        while (pindexLast->IsForgeMined(params)) {
             //LogPrintf("DarkGravityWave: Skipping forgemined block at %i\n", pindex->nHeight);
             assert(pindexLast->pprev); // should never fail
             pindexLast = pindexLast->pprev;
@@ -50,7 +55,7 @@ unsigned int DarkGravityWave(const CBlockIndex* pindexLast, const CBlockHeader *
 
     for (unsigned int nCountBlocks = 1; nCountBlocks <= nPastBlocks; nCountBlocks++) {
         // Thor: Forge: Skip over Forgemined blocks; we only want to consider PoW blocks
-        while (pindex->GetBlockHeader().IsForgeMined(params)) {
+        while (pindex->IsForgeMined(params)) {
             //LogPrintf("DarkGravityWave: Skipping forgemined block at %i\n", pindex->nHeight);
             assert(pindex->pprev); // should never fail
             pindex = pindex->pprev;
@@ -238,23 +243,47 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
     return true;
 }
 
+// Thor: Forge: Sum the Forge block targets the SMA difficulty adjust samples: step back from pindexLast
+// until nWindow Forge blocks are found or minForgeCheckBlock is reached. Uses the per-index Forge
+// counters, so the window is located with a binary search over ancestors instead of a pprev walk.
+static void GetForgeSMAWindow(const CBlockIndex* pindexLast, int nWindow, const Consensus::Params& params, arith_uint256& hammerHashTarget, int& forgeBlockCount)
+{
+    hammerHashTarget = 0;
+    forgeBlockCount = 0;
+
+    const int nLowest = std::max(1, params.minForgeCheckBlock);
+    if (pindexLast->nHeight < nLowest)
+        return;
+
+    // Lowest height sampled; the walk stops early on the block that completes the window
+    int nStart = nLowest;
+    const CBlockIndex* pindexBase = pindexLast->GetAncestor(nStart - 1);
+    if (pindexLast->nChainForgeBlocks - pindexBase->nChainForgeBlocks >= nWindow) {
+        int lo = nStart, hi = pindexLast->nHeight;
+        while (lo < hi) {
+            int mid = lo + (hi - lo + 1) / 2;
+            if (pindexLast->nChainForgeBlocks - pindexLast->GetAncestor(mid - 1)->nChainForgeBlocks >= nWindow)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        nStart = lo;
+        pindexBase = pindexLast->GetAncestor(nStart - 1);
+    }
+
+    hammerHashTarget = pindexLast->nChainForgeTarget - pindexBase->nChainForgeTarget;
+    forgeBlockCount = pindexLast->nChainForgeBlocks - pindexBase->nChainForgeBlocks;
+}
+
 // LitecoinCash: Forge 1.1: SMA Forge Difficulty Adjust
 unsigned int GetNextForge11WorkRequired(const CBlockIndex* pindexLast, const Consensus::Params& params) {
     const arith_uint256 bnPowLimit = UintToArith256(params.powLimitForge);
 
-    arith_uint256 hammerHashTarget = 0;
-    int forgeBlockCount = 0;
-    int totalBlockCount = 0;
+    arith_uint256 hammerHashTarget;
+    int forgeBlockCount;
 
     // Step back till we have found 24 hive blocks, or we ran out...
-    while (forgeBlockCount < params.forgeDifficultyWindow && pindexLast->pprev && pindexLast->nHeight >= params.minForgeCheckBlock) {
-        if (pindexLast->GetBlockHeader().IsForgeMined(params)) {
-            hammerHashTarget += arith_uint256().SetCompact(pindexLast->nBits);
-            forgeBlockCount++;
-        }
-	totalBlockCount++;
-        pindexLast = pindexLast->pprev;
-    }
+    GetForgeSMAWindow(pindexLast, params.forgeDifficultyWindow, params, hammerHashTarget, forgeBlockCount);
 
     if (forgeBlockCount == 0) {
         LogPrintf("GetNextForge11WorkRequired: No previous forge blocks found.\n");
@@ -277,19 +306,11 @@ unsigned int GetNextForge11WorkRequired(const CBlockIndex* pindexLast, const Con
 unsigned int GetNextForge12WorkRequired(const CBlockIndex* pindexLast, const Consensus::Params& params) {
     const arith_uint256 bnPowLimit = UintToArith256(params.powLimitForge2);
 
-    arith_uint256 hammerHashTarget = 0;
-    int forgeBlockCount = 0;
-    int totalBlockCount = 0;
+    arith_uint256 hammerHashTarget;
+    int forgeBlockCount;
 
     // Step back till we have found 24 hive blocks, or we ran out...
-    while (forgeBlockCount < params.forgeDifficultyWindow2 && pindexLast->pprev && pindexLast->nHeight >= params.minForgeCheckBlock) {
-        if (pindexLast->GetBlockHeader().IsForgeMined(params)) {
-            hammerHashTarget += arith_uint256().SetCompact(pindexLast->nBits);
-            forgeBlockCount++;
-        }
-	totalBlockCount++;
-        pindexLast = pindexLast->pprev;
-    }
+    GetForgeSMAWindow(pindexLast, params.forgeDifficultyWindow2, params, hammerHashTarget, forgeBlockCount);
 
     if (forgeBlockCount == 0) {
         LogPrintf("GetNextForge11WorkRequired: No previous forge blocks found.\n");
@@ -315,21 +336,17 @@ unsigned int GetNextForge13WorkRequired(const CBlockIndex* pindexLast, const Con
     int forgeBlockCount = 0;
     int targetBlockCount = params.forgeDifficultyWindow2 / params.forgeBlockSpacingTarget;
 
-    CBlockHeader block;
-    for(int i = 0; i < params.forgeDifficultyWindow2; i++) {
-        if (!pindexLast->pprev || pindexLast->nHeight < params.minForgeCheckBlock) {   // Not enough sampling window
-            LogPrintf("GetNextForge13WorkRequired: Not enough blocks in sampling window.\n");
-            return bnPowLimit.GetCompact();
-        }
-
-        block = pindexLast->GetBlockHeader();
-        if (block.IsForgeMined(params)) {
-            hammerHashTarget += arith_uint256().SetCompact(pindexLast->nBits);
-            forgeBlockCount++;
-        }
-        pindexLast = pindexLast->pprev;
+    // The window covers the forgeDifficultyWindow2 blocks ending at pindexLast; the per-index Forge
+    // counters give its Forge block count and target sum as differences against the block below it
+    if (pindexLast->nHeight - params.forgeDifficultyWindow2 + 1 < std::max(1, params.minForgeCheckBlock)) {   // Not enough sampling window
+        LogPrintf("GetNextForge13WorkRequired: Not enough blocks in sampling window.\n");
+        return bnPowLimit.GetCompact();
     }
 
+    const CBlockIndex* pindexBase = pindexLast->GetAncestor(pindexLast->nHeight - params.forgeDifficultyWindow2);
+    hammerHashTarget = pindexLast->nChainForgeTarget - pindexBase->nChainForgeTarget;
+    forgeBlockCount = pindexLast->nChainForgeBlocks - pindexBase->nChainForgeBlocks;
+
     if (forgeBlockCount == 0)
         return bnPowLimit.GetCompact();
 
@@ -365,28 +382,23 @@ unsigned int GetNextForgeWorkRequired(const CBlockIndex* pindexLast, const Conse
 
     //LogPrintf("GetNextForgeWorkRequired: Height     = %i\n", pindexLast->nHeight);
 
-    int numPowBlocks = 0;
-    CBlockHeader block;
-    while (true) {
-        if (!pindexLast->pprev || pindexLast->nHeight < params.minForgeCheckBlock) {   // Ran out of blocks without finding a Forge block? Return min target
-            LogPrintf("GetNextForgeWorkRequired: No forgemined blocks found in history\n");
-            //LogPrintf("GetNextForgeWorkRequired: This target= %s\n", bnPowLimit.ToString());
-            if (IsForge12Enabled(pindexLast, params))
-            	return bnPowLimit2.GetCompact();
-	    else
-		return bnPowLimit.GetCompact();
-        }
-
-        block = pindexLast->GetBlockHeader();
-        if (block.IsForgeMined(params)) {  // Found the last Forge block; pick up its hammer hash target
-            hammerHashTarget.SetCompact(block.nBits);
-            break;
-        }
-
-        pindexLast = pindexLast->pprev;
-        numPowBlocks++;
+    // The last Forge block sits nPoWBlocksAtTip blocks back; it only counts if the walk down to it
+    // stays at or above minForgeCheckBlock (and off the genesis block)
+    const int nLowest = std::max(1, params.minForgeCheckBlock);
+    int numPowBlocks = pindexLast->nPoWBlocksAtTip;
+    if (pindexLast->nHeight - numPowBlocks < nLowest) {   // Ran out of blocks without finding a Forge block? Return min target
+        pindexLast = pindexLast->GetAncestor(std::min(pindexLast->nHeight, nLowest - 1));
+        LogPrintf("GetNextForgeWorkRequired: No forgemined blocks found in history\n");
+        //LogPrintf("GetNextForgeWorkRequired: This target= %s\n", bnPowLimit.ToString());
+        if (IsForge12Enabled(pindexLast, params))
+            return bnPowLimit2.GetCompact();
+        else
+            return bnPowLimit.GetCompact();
     }
 
+    pindexLast = pindexLast->GetAncestor(pindexLast->nHeight - numPowBlocks);
+    hammerHashTarget.SetCompact(pindexLast->nBits);  // Found the last Forge block; pick up its hammer hash target
+
     //LogPrintf("GetNextForgeWorkRequired: powBlocks  = %i\n", numPowBlocks);
     if (numPowBlocks == 0)
         return bnImpossible.GetCompact();
@@ -434,71 +446,34 @@ bool GetNetworkForgeInfo(int& createdHammers, int& createdBCTs, int& readyHammer
         return false;
 
     // Count hammers in next blockCount blocks
-    CBlock block;
-    CScript scriptPubKeyBCF = GetScriptForDestination(DecodeDestination(consensusParams.hammerCreationAddress));
-    CScript scriptPubKeyCF = GetScriptForDestination(DecodeDestination(consensusParams.forgeCommunityAddress));
-
     for (int i = 0; i < totalHammerLifespan; i++) {
-        if (fHavePruned && !(pindexPrev->nStatus & BLOCK_HAVE_DATA) && pindexPrev->nTx > 0) {
-            LogPrintf("! GetNetworkForgeInfo: Warn: Block not available (pruned data); can't calculate network hammer count.");
+        CHammerPopEntry entry;
+        if (!hammerPopIndex.GetEntry(pindexPrev, consensusParams, entry)) {
+            LogPrintf("! GetNetworkForgeInfo: Warn: Block not available; can't calculate network hammer count.\n");
             return false;
         }
 
-        if (!pindexPrev->GetBlockHeader().IsForgeMined(consensusParams)) {                          // Don't check Forgemined blocks (no BCTs will be found in them)
-            if (!ReadBlockFromDisk(block, pindexPrev, consensusParams)) {
-                LogPrintf("! GetNetworkForgeInfo: Warn: Block not available (not found on disk); can't calculate network hammer count.");
-                return false;
+        if (entry.nBCTs > 0) {
+            if (i < consensusParams.hammerGestationBlocks) {
+                createdHammers += entry.nHammers;
+                createdBCTs += entry.nBCTs;
+            } else {
+                readyHammers += entry.nHammers;
+                readyBCTs += entry.nBCTs;
             }
-            int blockHeight = pindexPrev->nHeight;
-            CAmount hammerCost = GetHammerCost(blockHeight, consensusParams);
-            if (block.vtx.size() > 0) {
-                for(const auto& tx : block.vtx) {
-                    CAmount hammerFeePaid;
-                    if (tx->IsBCT(consensusParams, scriptPubKeyBCF, &hammerFeePaid)) {                 // If it's a BCT, total its hammers
-                        if (tx->vout.size() > 1 && tx->vout[1].scriptPubKey == scriptPubKeyCF) {    // If it has a community fund contrib...
-                            CAmount donationAmount = tx->vout[1].nValue;
-                            CAmount expectedDonationAmount = (hammerFeePaid + donationAmount) / consensusParams.communityContribFactor;  // ...check for valid donation amount
-                            if (donationAmount != expectedDonationAmount)
-                                continue;
-                            hammerFeePaid += donationAmount;                                           // Add donation amount back to total paid
-                        }
-                        int hammerCount = hammerFeePaid / hammerCost;
-                        if (i < consensusParams.hammerGestationBlocks) {
-                            createdHammers += hammerCount;
-                            createdBCTs++;
-                        } else {
-                            readyHammers += hammerCount; 
-                            readyBCTs++;
-                        }
-
-                        // Add these hammers to pop graph
-                        if (recalcGraph) {
-                            /*
-                            int hammerStart = blockHeight + consensusParams.hammerGestationBlocks;
-                            int hammerStop = hammerStart + consensusParams.hammerLifespanBlocks;
-                            hammerStart -= tipHeight;
-                            hammerStop -= tipHeight;
-                            for (int j = hammerStart; j < hammerStop; j++) {
-                                if (j > 0 && j < totalHammerLifespan) {
-                                    if (i < consensusParams.hammerGestationBlocks) // THIS IS WRONG
-                                        hammerPopGraph[j].createdPop += hammerCount;
-                                    else
-                                        hammerPopGraph[j].readyPop += hammerCount;
-                                }
-                            }*/
-                            int hammerBornBlock = blockHeight;
-                            int hammerReadysBlock = hammerBornBlock + consensusParams.hammerGestationBlocks;
-                            int hammerDiesBlock = hammerReadysBlock + consensusParams.hammerLifespanBlocks;
-                            for (int j = hammerBornBlock; j < hammerDiesBlock; j++) {
-                                int graphPos = j - tipHeight;
-                                if (graphPos > 0 && graphPos < totalHammerLifespan) {
-                                    if (j < hammerReadysBlock)
-                                        hammerPopGraph[graphPos].createdPop += hammerCount;
-                                    else
-                                        hammerPopGraph[graphPos].readyPop += hammerCount;
-                                }
-                            }
-                        }
+
+            // Add these hammers to pop graph
+            if (recalcGraph) {
+                int hammerBornBlock = pindexPrev->nHeight;
+                int hammerReadysBlock = hammerBornBlock + consensusParams.hammerGestationBlocks;
+                int hammerDiesBlock = hammerReadysBlock + consensusParams.hammerLifespanBlocks;
+                for (int j = hammerBornBlock; j < hammerDiesBlock; j++) {
+                    int graphPos = j - tipHeight;
+                    if (graphPos > 0 && graphPos < totalHammerLifespan) {
+                        if (j < hammerReadysBlock)
+                            hammerPopGraph[graphPos].createdPop += entry.nHammers;
+                        else
+                            hammerPopGraph[graphPos].readyPop += entry.nHammers;
                     }
                 }
             }
@@ -514,7 +489,7 @@ bool GetNetworkForgeInfo(int& createdHammers, int& createdBCTs, int& readyHammer
 }
 
 // Thor: Forge: Check the forge proof for given block
-bool CheckForgeProof(const CBlock* pblock, const Consensus::Params& consensusParams) {
+static bool CheckForgeProofUncached(const CBlock* pblock, const Consensus::Params& consensusParams) {
     bool verbose = LogAcceptCategory(BCLog::FORGE);
 
     if (verbose)
@@ -543,19 +518,13 @@ bool CheckForgeProof(const CBlock* pblock, const Consensus::Params& consensusPar
 
     // LitecoinCash: Hive 1.1: Check that there aren't too many consecutive Hive blocks
     if (IsForge11Enabled(pindexPrev, consensusParams)) {
-        int forgeBlocksAtTip = 0;
-        CBlockIndex* pindexTemp = pindexPrev;
-        while (pindexTemp->GetBlockHeader().IsForgeMined(consensusParams)) {
-            assert(pindexTemp->pprev);
-            pindexTemp = pindexTemp->pprev;
-            forgeBlocksAtTip++;
-        }
+        int forgeBlocksAtTip = pindexPrev->nForgeBlocksAtTip;
         if (forgeBlocksAtTip >= consensusParams.maxConsecutiveForgeBlocks) {
             LogPrintf("CheckForgeProof: Too many Forge blocks without a POW block.\n");
             return false;
         }
     } else {
-        if (pindexPrev->GetBlockHeader().IsForgeMined(consensusParams)) {
+        if (pindexPrev->IsForgeMined(consensusParams)) {
             LogPrint(BCLog::FORGE, "CheckForgeProof: Forge block must follow a POW block.\n");
             return false;
         }
@@ -618,17 +587,17 @@ bool CheckForgeProof(const CBlock* pblock, const Consensus::Params& consensusPar
         LogPrintf("CheckForgeProof: bctTxId             = %s\n", txidStr);
 
     // Check hammer hash against target
-    std::string deterministicRandString = GetDeterministicRandString(pindexPrev);
+    CDeterministicRand deterministicRand = GetDeterministicRand(pindexPrev);
     if (verbose)
-        LogPrintf("CheckForgeProof: detRandString       = %s\n", deterministicRandString);
+        LogPrintf("CheckForgeProof: detRandString       = %s\n", deterministicRand.ToString());
     arith_uint256 hammerHashTarget;
     hammerHashTarget.SetCompact(GetNextForgeWorkRequired(pindexPrev, consensusParams));
     if (verbose)
         LogPrintf("CheckForgeProof: hammerHashTarget       = %s\n", hammerHashTarget.ToString());
-    std::string hashHex = (CHashWriter(SER_GETHASH, 0) << deterministicRandString << txidStr << hammerNonce).GetHash().GetHex();
-    arith_uint256 hammerHash = arith_uint256(hashHex);
+    uint256 hammerHashRaw = CHammerHasher(deterministicRand).ForBCT(txidStr).GetHash(hammerNonce);
+    arith_uint256 hammerHash = UintToArith256(hammerHashRaw);
     if (verbose)
-        LogPrintf("CheckForgeProof: hammerHash             = %s\n", hashHex);
+        LogPrintf("CheckForgeProof: hammerHash             = %s\n", hammerHashRaw.GetHex());
     if (hammerHash >= hammerHashTarget) {
         LogPrintf("CheckForgeProof: Hammer does not meet hash target!\n");
         return false;
@@ -659,7 +628,7 @@ bool CheckForgeProof(const CBlock* pblock, const Consensus::Params& consensusPar
         return false;
     }
     CHashWriter ss(SER_GETHASH, 0);
-    ss << deterministicRandString;
+    ss << deterministicRand;
     uint256 mhash = ss.GetHash();
     CPubKey pubkey;
     if (!pubkey.RecoverCompact(mhash, messageSig)) {
@@ -684,6 +653,8 @@ bool CheckForgeProof(const CBlock* pblock, const Consensus::Params& consensusPar
         Coin coin;
         CTransactionRef bct = nullptr;
         CBlockIndex foundAt;
+        CBCTLocator bctLocator;
+        bool bctLocated = false;
 
         if (pcoinsTip && pcoinsTip->GetCoin(outHammerCreation, coin)) {        // First try the UTXO set (this pathway will hit on incoming blocks)
             if (verbose)
@@ -691,6 +662,13 @@ bool CheckForgeProof(const CBlock* pblock, const Consensus::Params& consensusPar
             bctValue = coin.out.nValue;
             bctScriptPubKey = coin.out.scriptPubKey;
             bctFoundHeight = coin.nHeight;
+        } else if (pbctindex && pbctindex->Lookup(uint256S(txidStr), pindexPrev, bctLocator)) {   // Then the BCT index, if enabled (a single key lookup during reindex)
+            if (verbose)
+                LogPrintf("CheckForgeProof: Using BCT index for outHammerCreation\n");
+            bctLocated = true;
+            bctFoundHeight = bctLocator.nHeight;
+            bctValue = bctLocator.hammerValue;
+            bctScriptPubKey = bctLocator.scriptPubKey;
         } else {                                                            // UTXO set isn't available when eg reindexing, so drill into block db (not too bad, since Alice put her BCT height in the coinbase tx)
             if (verbose)
                 LogPrintf("! CheckForgeProof: Warn: Using deep drill for outHammerCreation\n");
@@ -717,6 +695,14 @@ bool CheckForgeProof(const CBlock* pblock, const Consensus::Params& consensusPar
                         return false;
                     }
                     donationAmount = coin.out.nValue;
+                } else if (bctLocated || (pbctindex && pbctindex->Lookup(uint256S(txidStr), pindexPrev, bctLocator))) {   // Then the BCT index
+                    if (verbose)
+                        LogPrintf("CheckForgeProof: Using BCT index for outCommFund\n");
+                    if (!bctLocator.fCommunityContrib) {
+                        LogPrintf("CheckForgeProof: Community contrib was indicated but not found\n");
+                        return false;
+                    }
+                    donationAmount = bctLocator.donationAmount;
                 } else {                                                                        // Fallback if we couldn't use UTXO set
                     if (verbose)
                         LogPrintf("! CheckForgeProof: Warn: Using deep drill for outCommFund\n");
@@ -810,3 +796,22 @@ bool CheckForgeProof(const CBlock* pblock, const Consensus::Params& consensusPar
 
     return true;
 }
+
+static CForgeProofCache forgeProofCache;
+
+void InitForgeProofCache() {
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxforgeproofcachesize", DEFAULT_MAX_FORGE_PROOF_CACHE_SIZE)), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
+    size_t nElems = forgeProofCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for forge proof cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
+
+void GetForgeProofCacheStats(uint64_t& nHits, uint64_t& nMisses) {
+    nHits = forgeProofCache.nHits.load();
+    nMisses = forgeProofCache.nMisses.load();
+}
+
+// Thor: Forge: Check the forge proof for given block, unless it's already been found valid
+bool CheckForgeProof(const CBlock* pblock, const Consensus::Params& consensusParams) {
+    return forgeProofCache.Check(*pblock, [pblock, &consensusParams] { return CheckForgeProofUncached(pblock, consensusParams); });
+}
@@ -15,6 +15,9 @@ class CBlockIndex;
 class uint256;
 class CBlock;
 
+// Thor: Forge: Default size of the validated forge proof cache, in MiB
+static const unsigned int DEFAULT_MAX_FORGE_PROOF_CACHE_SIZE = 2;
+
 struct HammerPopGraphPoint {
     int createdPop;
     int readyPop;
@@ -24,6 +27,8 @@ unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHead
 unsigned int CalculateNextWorkRequired(const CBlockIndex* pindexLast, int64_t nFirstBlockTime, const Consensus::Params&);
 unsigned int GetNextForgeWorkRequired(const CBlockIndex* pindexLast, const Consensus::Params& params);                       // Thor: Forge: Get the current Hammer Hash Target
 bool CheckForgeProof(const CBlock* pblock, const Consensus::Params& params);                                                 // Thor: Forge: Check the forge proof for given block
+void InitForgeProofCache();                                                                                                   // Thor: Forge: Size the validated forge proof cache from -maxforgeproofcachesize
+void GetForgeProofCacheStats(uint64_t& nHits, uint64_t& nMisses);                                                             // Thor: Forge: Validated forge proof cache hits and misses since startup
 bool GetNetworkForgeInfo(int& createdHammers, int& createdBCTs, int& readyHammers, int& readyBCTs, CAmount& potentialLifespanRewards, const Consensus::Params& consensusParams, bool recalcGraph = false); // Thor: Forge: Get count of all live and gestating BCTs on the network
 
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
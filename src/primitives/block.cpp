@@ -24,6 +24,17 @@ uint256 CBlockHeader::GetPoWHash() const // Removed the " if fork then pow is sh
     return thash;
 }
 
+void GetPoWHashes(const std::vector<const CBlockHeader*>& headers, std::vector<uint256>& hashes, int maxLanes)
+{
+    hashes.resize(headers.size());
+    std::vector<const char*> vInput(headers.size());
+    std::vector<char*> vOutput(headers.size());
+    for (size_t i = 0; i < headers.size(); i++) {
+        vInput[i] = BEGIN(headers[i]->nVersion);
+        vOutput[i] = BEGIN(hashes[i]);
+    }
+    scrypt_1024_1_1_256_multi(vInput.data(), vOutput.data(), headers.size(), maxLanes);
+}
 
 
 std::string CBlock::ToString() const
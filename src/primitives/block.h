@@ -129,6 +129,10 @@ public:
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
  */
+/** Thor: Scrypt PoW hashes of many headers at once, hashed together by the multi-lane
+ *  scrypt kernels (at most maxLanes wide, 0 = widest available) */
+void GetPoWHashes(const std::vector<const CBlockHeader*>& headers, std::vector<uint256>& hashes, int maxLanes = 0);
+
 struct CBlockLocator
 {
     std::vector<uint256> vHave;
@@ -71,8 +71,8 @@ int ClientModel::getNumConnections(unsigned int flags) const
 
 int ClientModel::getNumBlocks() const
 {
-    LOCK(cs_main);
-    return chainActive.Height();
+    CTipSnapshotRef tip = GetTipSnapshot();
+    return tip ? tip->nHeight : -1;
 }
 
 int ClientModel::getHeaderTipHeight() const
@@ -117,10 +117,9 @@ quint64 ClientModel::getTotalBytesSent() const
 
 QDateTime ClientModel::getLastBlockDate() const
 {
-    LOCK(cs_main);
-
-    if (chainActive.Tip())
-        return QDateTime::fromTime_t(chainActive.Tip()->GetBlockTime());
+    CTipSnapshotRef tip = GetTipSnapshot();
+    if (tip)
+        return QDateTime::fromTime_t(tip->nTime);
 
     return QDateTime::fromTime_t(Params().GenesisBlock().GetBlockTime()); // Genesis block's time of current network
 }
@@ -137,11 +136,12 @@ size_t ClientModel::getMempoolDynamicUsage() const
 
 double ClientModel::getVerificationProgress(const CBlockIndex *tipIn) const
 {
-    CBlockIndex *tip = const_cast<CBlockIndex *>(tipIn);
+    const CBlockIndex *tip = tipIn;
     if (!tip)
     {
-        LOCK(cs_main);
-        tip = chainActive.Tip();
+        CTipSnapshotRef snapshot = GetTipSnapshot();
+        if (snapshot)
+            tip = snapshot->pindex;
     }
     return GuessVerificationProgress(Params().TxData(), tip);
 }
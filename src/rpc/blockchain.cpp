@@ -6,6 +6,7 @@
 #include <rpc/blockchain.h>
 
 #include <amount.h>
+#include <bctindex.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
@@ -15,6 +16,7 @@
 #include <core_io.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <primitives/transaction.h>
 #include <rpc/server.h>
 #include <streams.h>
@@ -66,7 +68,7 @@ double GetDifficulty(const CChain& chain, const CBlockIndex* blockindex, bool ge
     const Consensus::Params& consensusParams = Params().GetConsensus();
     if (!getForgeDifficulty) {
         // LitecoinCash: Hive 1.1: Allow there to be multiple hive blocks in the way
-        while (blockindex->GetBlockHeader().IsForgeMined(consensusParams)) {
+        while (blockindex->IsForgeMined(consensusParams)) {
             assert (blockindex->pprev);
             blockindex = blockindex->pprev;
         }
@@ -74,7 +76,7 @@ double GetDifficulty(const CChain& chain, const CBlockIndex* blockindex, bool ge
 
     // Thor: Forge: If tip is PoW and we want forgemined, step back until we find a Forge block
     if (getForgeDifficulty) {
-        while (!blockindex->GetBlockHeader().IsForgeMined(consensusParams)) {
+        while (!blockindex->IsForgeMined(consensusParams)) {
             if (!blockindex->pprev || blockindex->nHeight < consensusParams.minForgeCheckBlock) {   // Ran out of blocks without finding a Forge block? Return min target
                 LogPrint(BCLog::FORGE, "GetDifficulty: No forgemined blocks found in history\n");
                 return 1;
@@ -117,7 +119,7 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
     // Only report confirmations if the block is on the main chain
     if (chainActive.Contains(blockindex))
         confirmations = chainActive.Height() - blockindex->nHeight + 1;
-    result.push_back(Pair("type", blockindex->GetBlockHeader().IsForgeMined(Params().GetConsensus()) ? "forge" : "pow"));
+    result.push_back(Pair("type", blockindex->IsForgeMined(Params().GetConsensus()) ? "forge" : "pow"));
     result.push_back(Pair("confirmations", confirmations));
     result.push_back(Pair("height", blockindex->nHeight));
     result.push_back(Pair("version", blockindex->nVersion));
@@ -148,7 +150,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     // Only report confirmations if the block is on the main chain
     if (chainActive.Contains(blockindex))
         confirmations = chainActive.Height() - blockindex->nHeight + 1;
-    result.push_back(Pair("type", block.GetBlockHeader().IsForgeMined(Params().GetConsensus()) ? "forge" : "pow"));
+    result.push_back(Pair("type", block.IsForgeMined(Params().GetConsensus()) ? "forge" : "pow"));
     result.push_back(Pair("confirmations", confirmations));
     result.push_back(Pair("strippedsize", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS)));
     result.push_back(Pair("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION)));
@@ -199,8 +201,9 @@ UniValue getblockcount(const JSONRPCRequest& request)
             + HelpExampleRpc("getblockcount", "")
         );
 
-    LOCK(cs_main);
-    return chainActive.Height();
+    // Thor: Answered from the published tip, without cs_main
+    CTipSnapshotRef tip = GetTipSnapshot();
+    return tip ? tip->nHeight : -1;
 }
 
 UniValue getbestblockhash(const JSONRPCRequest& request)
@@ -216,8 +219,11 @@ UniValue getbestblockhash(const JSONRPCRequest& request)
             + HelpExampleRpc("getbestblockhash", "")
         );
 
-    LOCK(cs_main);
-    return chainActive.Tip()->GetBlockHash().GetHex();
+    // Thor: Answered from the published tip, without cs_main
+    CTipSnapshotRef tip = GetTipSnapshot();
+    if (!tip)
+        throw JSONRPCError(RPC_IN_WARMUP, "No best block yet");
+    return tip->hashBlock.GetHex();
 }
 
 void RPCNotifyBlockChange(bool ibd, const CBlockIndex * pindex)
@@ -1249,6 +1255,34 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
             "        }\n"
             "     }\n"
             "  }\n"
+            "  \"blockreads\": {               (object) PoW / Forge proof checks when reading blocks from disk\n"
+            "     \"verifyblockreads\": xx,    (boolean) whether fully validated blocks are re-checked on read\n"
+            "     \"pow_verified\": xx,        (numeric) PoW block reads that checked the proof of work\n"
+            "     \"pow_trusted\": xx,         (numeric) PoW block reads that skipped the check\n"
+            "     \"forge_verified\": xx,      (numeric) Forge block reads that checked the forge proof\n"
+            "     \"forge_trusted\": xx,       (numeric) Forge block reads that skipped the check\n"
+            "     \"verify_time\": xx,         (numeric) total seconds spent checking proofs on read\n"
+            "     \"time_saved\": xx,          (numeric) estimated seconds saved by skipped checks, at the average check cost\n"
+            "     \"raw_reads\": xx,           (numeric) blocks read as stored, to serve to peers, with no proof check or deserialization\n"
+            "     \"raw_bytes\": xx            (numeric) bytes read by those\n"
+            "  }\n"
+            "  \"indexpow\": {                 (object) background PoW check of block index entries loaded at startup\n"
+            "     \"running\": xx,             (boolean) whether the verifier is still running\n"
+            "     \"height\": xx,              (numeric) height up to which every PoW block on the active chain is verified\n"
+            "     \"progress\": xx,            (numeric) estimate of verification progress [0..1]\n"
+            "     \"verified\": xx,            (numeric) entries verified by the verifier since startup\n"
+            "     \"failed\": xx               (numeric) entries whose stored header failed its PoW check\n"
+            "  }\n"
+            "  \"bctindex\": {                 (object) BCT index lookups by Forge proof checks since startup\n"
+            "     \"enabled\": xx,             (boolean) whether -bctindex is enabled\n"
+            "     \"hits\": xx,                (numeric) BCTs located by the index\n"
+            "     \"misses\": xx               (numeric) lookups that fell back to reading the block\n"
+            "  }\n"
+            "  \"forgeproofcache\": {          (object) validated forge proof cache lookups since startup\n"
+            "     \"hits\": xx,                (numeric) forge proofs found already validated\n"
+            "     \"misses\": xx,              (numeric) forge proofs that had to be checked\n"
+            "     \"hitrate\": xx              (numeric) hits / (hits + misses)\n"
+            "  }\n"
             "  \"warnings\" : \"...\",           (string) any network and blockchain warnings.\n"
             "}\n"
             "\nExamples:\n"
@@ -1300,6 +1334,45 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
     obj.push_back(Pair("softforks",             softforks));
     obj.push_back(Pair("bip9_softforks", bip9_softforks));
 
+    // Thor: Forge: Block read proof-check stats
+    BlockReadStats readStats = GetBlockReadStats();
+    double powAvg = readStats.nPoWVerified ? (double)readStats.nPoWVerifyMicros / readStats.nPoWVerified : 0;
+    double forgeAvg = readStats.nForgeVerified ? (double)readStats.nForgeVerifyMicros / readStats.nForgeVerified : 0;
+    UniValue blockreads(UniValue::VOBJ);
+    blockreads.push_back(Pair("verifyblockreads", fVerifyBlockReads));
+    blockreads.push_back(Pair("pow_verified", readStats.nPoWVerified));
+    blockreads.push_back(Pair("pow_trusted", readStats.nPoWTrusted));
+    blockreads.push_back(Pair("forge_verified", readStats.nForgeVerified));
+    blockreads.push_back(Pair("forge_trusted", readStats.nForgeTrusted));
+    blockreads.push_back(Pair("verify_time", (readStats.nPoWVerifyMicros + readStats.nForgeVerifyMicros) * 0.000001));
+    blockreads.push_back(Pair("time_saved", (powAvg * readStats.nPoWTrusted + forgeAvg * readStats.nForgeTrusted) * 0.000001));
+    blockreads.push_back(Pair("raw_reads", readStats.nRawReads));
+    blockreads.push_back(Pair("raw_bytes", readStats.nRawBytes));
+    obj.push_back(Pair("blockreads", blockreads));
+
+    IndexPoWStats indexPoWStats = GetIndexPoWStats();
+    int nIndexPoWHeight = std::min(indexPoWStats.nHeight, chainActive.Height());
+    int nIndexPoWTotal = chainActive.Height() - SKIP_BLOCKHEADER_POW + 1;
+    UniValue indexpow(UniValue::VOBJ);
+    indexpow.push_back(Pair("running", indexPoWStats.fRunning));
+    indexpow.push_back(Pair("height", nIndexPoWHeight));
+    indexpow.push_back(Pair("progress", nIndexPoWTotal > 0 ? std::max(0, nIndexPoWHeight - SKIP_BLOCKHEADER_POW + 1) / (double)nIndexPoWTotal : 1.0));
+    indexpow.push_back(Pair("verified", indexPoWStats.nVerified));
+    indexpow.push_back(Pair("failed", indexPoWStats.nFailed));
+    obj.push_back(Pair("indexpow", indexpow));
+    UniValue bctindex(UniValue::VOBJ);
+    bctindex.push_back(Pair("enabled", pbctindex != nullptr));
+    bctindex.push_back(Pair("hits", pbctindex ? pbctindex->GetHits() : 0));
+    bctindex.push_back(Pair("misses", pbctindex ? pbctindex->GetMisses() : 0));
+    obj.push_back(Pair("bctindex", bctindex));
+    uint64_t nForgeProofCacheHits, nForgeProofCacheMisses;
+    GetForgeProofCacheStats(nForgeProofCacheHits, nForgeProofCacheMisses);
+    UniValue forgeproofcache(UniValue::VOBJ);
+    forgeproofcache.push_back(Pair("hits", nForgeProofCacheHits));
+    forgeproofcache.push_back(Pair("misses", nForgeProofCacheMisses));
+    forgeproofcache.push_back(Pair("hitrate", nForgeProofCacheHits + nForgeProofCacheMisses > 0 ? nForgeProofCacheHits / (double)(nForgeProofCacheHits + nForgeProofCacheMisses) : 0.0));
+    obj.push_back(Pair("forgeproofcache", forgeproofcache));
+
     obj.push_back(Pair("warnings", GetWarnings("statusbar")));
     return obj;
 }
@@ -103,6 +103,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "setforgeparams", 0, "forgecheckdelay"},        // LitecoinCash: Hive: Mining optimisations: Set hive mining params
     { "setforgeparams", 1, "forgecheckthreads"},      // LitecoinCash: Hive: Mining optimisations: Set hive mining params
     { "setforgeparams", 2, "forgeearlyabort"},
+    { "submitforgesolution", 2, "nonce" },            // Thor: Forge: Remote worker protocol
     { "getforgeinfo", 1, "min_gold_confirms" },     // Thor: Forge: Get forge info
     { "decoderawtransaction", 1, "iswitness" },
     { "signrawtransaction", 1, "prevtxs" },
@@ -11,6 +11,7 @@
 #include <consensus/params.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <httpserver.h>
 #include <init.h>
 #include <validation.h>
 #include <miner.h>
@@ -26,6 +27,7 @@
 #include <validationinterface.h>
 #include <warnings.h>
 
+#include <limits>
 #include <memory>
 #include <stdint.h>
 
@@ -133,6 +135,175 @@ UniValue getforgeparams(const JSONRPCRequest& request)
     return obj;
 }
 
+// Thor: Forge: Remote worker protocol: long polls waiting in getforgework. Each holds an RPC thread, so they're kept
+// two short of -rpcthreads to leave threads for submitforgesolution and everything else
+static std::atomic<int> nForgeWorkLongPolls(0);
+
+static int GetMaxForgeWorkLongPolls()
+{
+    return std::max((int)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS) - 2, 0);
+}
+
+// Thor: Forge: Remote worker protocol: get the hammers to check
+UniValue getforgework(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "getforgework ( \"longpollid\" )\n"
+            "\nGet the wallet's ready hammers to check for the next Forge block, for a remote worker (requires -forgework).\n"
+            "Work is published on every tip change and goes idle as soon as the tip moves again or the work is solved.\n"
+            "A long poll holds an RPC thread, so at most -rpcthreads minus 2 of them wait at once; any more return straight away.\n"
+            "Run with -rpcthreads at least 2 more than the number of workers.\n"
+            "\nArguments:\n"
+            "1. \"longpollid\"       (string, optional) Wait (for up to a minute) until the work differs from this work id\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"workid\" : \"xxx\",             (string) Id of this work, to pass to submitforgesolution and as longpollid; \"idle\" if there is none\n"
+            "  \"height\" : n,                  (numeric) Height of the block a solution would mint\n"
+            "  \"previousblockhash\" : \"xxx\",  (string) Hash of the current tip\n"
+            "  \"randstring\" : \"xxx\",         (string) The deterministic rand string\n"
+            "  \"target\" : \"xxx\",             (string) The hammer hash target\n"
+            "  \"chunks\" : [                   (array) Chunks of hammers to check, as the node cut them; the node checks its own slot of the split (see -forgeworkers) itself\n"
+            "    [                            (array) Hammer ranges in the chunk, possibly from several BCTs\n"
+            "      {\n"
+            "        \"txid\" : \"xxx\",         (string) The BCT txid\n"
+            "        \"offset\" : n,            (numeric) First hammer nonce\n"
+            "        \"count\" : n              (numeric) Number of hammers\n"
+            "      }, ...\n"
+            "    ], ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getforgework", "")
+            + HelpExampleCli("getforgework", "\"1234\"")
+            + HelpExampleRpc("getforgework", "")
+       );
+
+    if (!gArgs.GetBoolArg("-forgework", DEFAULT_FORGE_WORK))
+        throw JSONRPCError(RPC_METHOD_NOT_FOUND, "Forge work is not published (start with -forgework)");
+
+    std::string longPollId = request.params.size() > 0 ? request.params[0].get_str() : "";
+    bool fLongPoll = false;
+    if (!longPollId.empty()) {
+        if (nForgeWorkLongPolls.fetch_add(1) < GetMaxForgeWorkLongPolls()) {
+            fLongPoll = true;
+        } else {
+            nForgeWorkLongPolls--;
+            static std::atomic<bool> fWarned(false);
+            if (!fWarned.exchange(true))
+                LogPrintf("getforgework: Too many long polls for -rpcthreads=%d; raise it to at least 2 more than the number of Forge workers\n", gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS));
+        }
+    }
+    CForgeWork work;
+    GetForgeWork(work, longPollId, fLongPoll ? 60 * 1000 : 0);
+    if (fLongPoll)
+        nForgeWorkLongPolls--;
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("workid", work.workId));
+    obj.push_back(Pair("height", work.nHeight));
+    obj.push_back(Pair("previousblockhash", work.hashPrevBlock.GetHex()));
+    obj.push_back(Pair("randstring", work.deterministicRandString));
+    obj.push_back(Pair("target", work.hammerHashTarget.GetHex()));
+    UniValue chunks(UniValue::VARR);
+    for (const std::vector<CForgeWorkRange>& chunk : work.chunks) {
+        UniValue ranges(UniValue::VARR);
+        for (const CForgeWorkRange& range : chunk) {
+            UniValue bct(UniValue::VOBJ);
+            bct.push_back(Pair("txid", range.txid));
+            bct.push_back(Pair("offset", range.offset));
+            bct.push_back(Pair("count", range.count));
+            ranges.push_back(bct);
+        }
+        chunks.push_back(ranges);
+    }
+    obj.push_back(Pair("chunks", chunks));
+
+    return obj;
+}
+
+// Thor: Forge: Remote worker protocol: hand back a solution
+UniValue submitforgesolution(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 3)
+        throw std::runtime_error(
+            "submitforgesolution \"workid\" \"txid\" nonce\n"
+            "\nSubmit a hammer meeting the target of the current Forge work. The node signs the proof and mints the block.\n"
+            "\nArguments:\n"
+            "1. \"workid\"           (string, required) The work id from getforgework\n"
+            "2. \"txid\"             (string, required) The BCT txid\n"
+            "3. nonce              (numeric, required) The hammer nonce\n"
+            "\nResult:\n"
+            "null if the solution was accepted for minting, else a string with the reason it wasn't (\"stale\", \"unknown-hammer\" or \"high-hash\")\n"
+            "\nExamples:\n"
+            + HelpExampleCli("submitforgesolution", "\"1234\" \"mytxid\" 42")
+            + HelpExampleRpc("submitforgesolution", "\"1234\", \"mytxid\", 42")
+       );
+
+    if (!gArgs.GetBoolArg("-forgework", DEFAULT_FORGE_WORK))
+        throw JSONRPCError(RPC_METHOD_NOT_FOUND, "Forge work is not published (start with -forgework)");
+
+    int64_t nonce = request.params[2].get_int64();
+    if (nonce < 0 || nonce > std::numeric_limits<uint32_t>::max())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Nonce out of range");
+
+    std::string result = SubmitForgeSolution(request.params[0].get_str(), ParseHashV(request.params[1], "txid"), (uint32_t)nonce);
+    if (!result.empty())
+        return result;
+
+    return NullUniValue;
+}
+
+// Thor: Forge: Hammer check statistics
+UniValue getforgecheckstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getforgecheckstats\n"
+            "\nGet statistics of the hammer checks run since startup.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"checks\" : n,                      (numeric) Forge checks run\n"
+            "  \"solutions\" : n,                   (numeric) Forge checks that found a solution\n"
+            "  \"avg_solution_ms\" : n,             (numeric) Average time to first solution, over checks that found one\n"
+            "  \"last_hammers\" : n,                (numeric) Hammers to check in the last check\n"
+            "  \"last_check_ms\" : n,               (numeric) Duration of the last check\n"
+            "  \"last_solution_ms\" : n,            (numeric) Time to first solution in the last check, or -1 if it found none\n"
+            "  \"threads\" : [                      (array) Per thread, the thread running the check first\n"
+            "    {\n"
+            "      \"chunks\" : n,                  (numeric) Chunks of hammers checked\n"
+            "      \"hammers\" : n,                 (numeric) Hammers checked\n"
+            "      \"hammers_per_sec\" : n          (numeric) Hammers checked per second of checking\n"
+            "    }, ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getforgecheckstats", "")
+            + HelpExampleRpc("getforgecheckstats", "")
+       );
+
+    CHammerCheckStats stats = GetHammerCheckStats();
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("checks", stats.nChecks));
+    obj.push_back(Pair("solutions", stats.nSolutions));
+    obj.push_back(Pair("avg_solution_ms", stats.nSolutions > 0 ? stats.nSolutionMicros / 1000.0 / stats.nSolutions : 0.0));
+    obj.push_back(Pair("last_hammers", stats.nLastHammers));
+    obj.push_back(Pair("last_check_ms", stats.nLastCheckMicros / 1000.0));
+    obj.push_back(Pair("last_solution_ms", stats.nLastSolutionMicros < 0 ? -1.0 : stats.nLastSolutionMicros / 1000.0));
+    UniValue threads(UniValue::VARR);
+    for (const CHammerCheckThreadStats& threadStats : stats.vThreads) {
+        UniValue thread(UniValue::VOBJ);
+        thread.push_back(Pair("chunks", threadStats.nChunks));
+        thread.push_back(Pair("hammers", threadStats.nHammers));
+        thread.push_back(Pair("hammers_per_sec", threadStats.nTimeMicros > 0 ? threadStats.nHammers * 1000000.0 / threadStats.nTimeMicros : 0.0));
+        threads.push_back(thread);
+    }
+    obj.push_back(Pair("threads", threads));
+
+    return obj;
+}
+
 UniValue getnetworkhashps(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 2)
@@ -528,10 +699,13 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
         {
             checktxtime = std::chrono::steady_clock::now() + std::chrono::minutes(1);
 
-            WaitableLock lock(csBestBlock);
-            while (chainActive.Tip()->GetBlockHash() == hashWatchedChain && IsRPCRunning())
+            // Thor: Wait on the published tip, which unlike chainActive is safe to read without cs_main
+            while (IsRPCRunning())
             {
-                if (cvBlockChange.wait_until(lock, checktxtime) == std::cv_status::timeout)
+                CTipSnapshotRef tip = WaitForTipChange(hashWatchedChain, checktxtime);
+                if (tip && tip->hashBlock != hashWatchedChain)
+                    break;
+                if (std::chrono::steady_clock::now() >= checktxtime)
                 {
                     // Timeout: Check transactions for update
                     if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLastLP)
@@ -554,33 +728,45 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     bool fSupportsSegwit = setClientRules.find(segwit_info.name) != setClientRules.end();
 
     // Update block
+    // Thor: Incremental templates: Within 5 seconds of the last full selection, a mempool change is only
+    // taken when CreateNewBlock can carry on from its cached selection; rebuilds from scratch stay throttled
     static CBlockIndex* pindexPrev;
     static int64_t nStart;
     static std::unique_ptr<CBlockTemplate> pblocktemplate;
     // Cache whether the last invocation was with segwit support, to avoid returning
     // a segwit-block to a non-segwit caller.
     static bool fLastTemplateSupportsSegwit = true;
-    if (pindexPrev != chainActive.Tip() ||
-        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 5) ||
-        fLastTemplateSupportsSegwit != fSupportsSegwit)
+    const bool fNewTip = pindexPrev != chainActive.Tip() || fLastTemplateSupportsSegwit != fSupportsSegwit;
+    if (fNewTip || mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast)
     {
+        const bool fCachedOnly = !fNewTip && GetTime() - nStart <= 5;
+
         // Clear pindexPrev so future calls make a new block, despite any failures from here on
+        CBlockIndex* pindexPrevOld = pindexPrev;
         pindexPrev = nullptr;
 
         // Store the pindexBest used before CreateNewBlock, to avoid races
-        nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
+        const unsigned int nTransactionsUpdatedNew = mempool.GetTransactionsUpdated();
         CBlockIndex* pindexPrevNew = chainActive.Tip();
-        nStart = GetTime();
-        fLastTemplateSupportsSegwit = fSupportsSegwit;
 
         // Create new block
         CScript scriptDummy = CScript() << OP_TRUE;
-        pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptDummy, fSupportsSegwit);
-        if (!pblocktemplate)
+        std::unique_ptr<CBlockTemplate> pblocktemplateNew = BlockAssembler(Params()).CreateNewBlock(scriptDummy, fSupportsSegwit, nullptr, true, fCachedOnly);
+        if (pblocktemplateNew) {
+            pblocktemplate = std::move(pblocktemplateNew);
+            nTransactionsUpdatedLast = nTransactionsUpdatedNew;
+            fLastTemplateSupportsSegwit = fSupportsSegwit;
+            if (!fCachedOnly)
+                nStart = GetTime();
+
+            // Need to update only after we know CreateNewBlock succeeded
+            pindexPrev = pindexPrevNew;
+        } else if (fCachedOnly) {
+            // Too soon to select from scratch; keep the last template
+            pindexPrev = pindexPrevOld;
+        } else {
             throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-
-        // Need to update only after we know CreateNewBlock succeeded
-        pindexPrev = pindexPrevNew;
+        }
     }
     CBlock* pblock = &pblocktemplate->block; // pointer for convenience
     const Consensus::Params& consensusParams = Params().GetConsensus();
@@ -1046,6 +1232,9 @@ static const CRPCCommand commands[] =
 
     { "mining",             "setforgeparams",          &setforgeparams,          {"forgecheckdelay", "forgecheckthreads", "forgeearlyout"} },  // LitecoinCash: Hive: Mining optimisations: Set forge mining params
     { "mining",             "getforgeparams",          &getforgeparams,          {} },  // LitecoinCash: Hive: Mining optimisations: Get forge mining params
+    { "mining",             "getforgecheckstats",      &getforgecheckstats,      {} },  // Thor: Forge: Hammer check statistics
+    { "mining",             "getforgework",            &getforgework,            {"longpollid"} },  // Thor: Forge: Remote worker protocol
+    { "mining",             "submitforgesolution",     &submitforgesolution,     {"workid", "txid", "nonce"} },  // Thor: Forge: Remote worker protocol
 
 };
 
@@ -610,6 +610,30 @@ UniValue logging(const JSONRPCRequest& request)
     return result;
 }
 
+// Thor: Lock contention counts gathered under -debug=lock
+UniValue getlockcontention(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getlockcontention\n"
+            "\nReturns how many times each lock has been waited for while another thread held it.\n"
+            "Waits are only counted while the \"lock\" logging category is enabled (-debug=lock).\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"name\": n,     (numeric) Number of contended acquisitions of the named lock, e.g. cs_main\n"
+            "  ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getlockcontention", "")
+            + HelpExampleRpc("getlockcontention", "")
+        );
+
+    UniValue result(UniValue::VOBJ);
+    for (const auto& entry : GetLockContentionCounts())
+        result.pushKV(entry.first, entry.second);
+    return result;
+}
+
 UniValue echo(const JSONRPCRequest& request)
 {
     if (request.fHelp)
@@ -650,6 +674,7 @@ static const CRPCCommand commands[] =
     { "hidden",             "echo",                   &echo,                   {"arg0","arg1","arg2","arg3","arg4","arg5","arg6","arg7","arg8","arg9"}},
     { "hidden",             "echojson",               &echo,                   {"arg0","arg1","arg2","arg3","arg4","arg5","arg6","arg7","arg8","arg9"}},
     { "hidden",             "getinfo",                &getinfo_deprecated,     {}},
+    { "hidden",             "getlockcontention",      &getlockcontention,      {}},
 };
 
 void RegisterMiscRPCCommands(CRPCTable &t)
@@ -109,6 +109,14 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
             "    \"bytesrecv_per_msg\": {\n"
             "       \"addr\": n,              (numeric) The total bytes received aggregated by message type\n"
             "       ...\n"
+            "    },\n"
+            "    \"queuetime_per_msg\": {  (json object) How long received messages waited to be processed, by message type\n"
+            "       \"addr\": {\n"
+            "         \"count\": n,           (numeric) The number of messages processed\n"
+            "         \"avg\": n,             (numeric) The average wait in seconds\n"
+            "         \"max\": n              (numeric) The longest wait in seconds\n"
+            "       },\n"
+            "       ...\n"
             "    }\n"
             "  }\n"
             "  ,...\n"
@@ -184,6 +192,16 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
         }
         obj.push_back(Pair("bytesrecv_per_msg", recvPerMsgCmd));
 
+        UniValue queueTimePerMsgCmd(UniValue::VOBJ);
+        for (const mapMsgCmdQueueTime::value_type &i : stats.mapRecvQueueTimePerMsgCmd) {
+            UniValue queueTime(UniValue::VOBJ);
+            queueTime.push_back(Pair("count", i.second.nCount));
+            queueTime.push_back(Pair("avg", 0.000001 * i.second.nTotalMicros / i.second.nCount));
+            queueTime.push_back(Pair("max", 0.000001 * i.second.nMaxMicros));
+            queueTimePerMsgCmd.push_back(Pair(i.first, queueTime));
+        }
+        obj.push_back(Pair("queuetime_per_msg", queueTimePerMsgCmd));
+
         ret.push_back(obj);
     }
 
@@ -367,6 +385,14 @@ UniValue getnettotals(const JSONRPCRequest& request)
             "    \"serve_historical_blocks\": true|false,  (boolean) True if serving historical blocks\n"
             "    \"bytes_left_in_cycle\": t,               (numeric) Bytes left in current time cycle\n"
             "    \"time_left_in_cycle\": t                 (numeric) Seconds left in current time cycle\n"
+            "  },\n"
+            "  \"recvbuffers\":\n"
+            "  {\n"
+            "    \"allocations\": n,     (numeric) Message buffers allocated\n"
+            "    \"reuses\": n,          (numeric) Message buffers reused from the pool instead\n"
+            "    \"copiedbytes\": n,     (numeric) Message bytes copied after being received\n"
+            "    \"inplacebytes\": n,    (numeric) Message bytes received straight into their message buffer\n"
+            "    \"pooledbytes\": n      (numeric) Bytes held in the pool for reuse\n"
             "  }\n"
             "}\n"
             "\nExamples:\n"
@@ -389,6 +415,15 @@ UniValue getnettotals(const JSONRPCRequest& request)
     outboundLimit.push_back(Pair("bytes_left_in_cycle", g_connman->GetOutboundTargetBytesLeft()));
     outboundLimit.push_back(Pair("time_left_in_cycle", g_connman->GetMaxOutboundTimeLeftInCycle()));
     obj.push_back(Pair("uploadtarget", outboundLimit));
+
+    CRecvBufferStats recvStats = g_recv_buffer_pool.GetStats();
+    UniValue recvBuffers(UniValue::VOBJ);
+    recvBuffers.push_back(Pair("allocations", recvStats.nAllocations));
+    recvBuffers.push_back(Pair("reuses", recvStats.nReuses));
+    recvBuffers.push_back(Pair("copiedbytes", recvStats.nCopiedBytes));
+    recvBuffers.push_back(Pair("inplacebytes", recvStats.nInPlaceBytes));
+    recvBuffers.push_back(Pair("pooledbytes", recvStats.nPooledBytes));
+    obj.push_back(Pair("recvbuffers", recvBuffers));
     return obj;
 }
 
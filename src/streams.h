@@ -138,6 +138,52 @@ private:
     size_t nPos;
 };
 
+/* Minimal stream for reading from a borrowed range of bytes, such as a network
+ * receive buffer, without copying it first
+ *
+ * The referenced bytes must outlive the reader.
+ */
+class CSpanReader
+{
+public:
+    CSpanReader(int nTypeIn, int nVersionIn, const char* pbeginIn, const char* pendIn) : nType(nTypeIn), nVersion(nVersionIn), pbegin(pbeginIn), pend(pendIn) {}
+
+    template<typename T>
+    CSpanReader& operator>>(T& obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+
+    void read(char* pch, size_t nSize)
+    {
+        if (nSize > size())
+            throw std::ios_base::failure("CSpanReader::read(): end of data");
+        memcpy(pch, pbegin, nSize);
+        pbegin += nSize;
+    }
+
+    void ignore(size_t nSize)
+    {
+        if (nSize > size())
+            throw std::ios_base::failure("CSpanReader::ignore(): end of data");
+        pbegin += nSize;
+    }
+
+    size_t size() const { return pend - pbegin; }
+    bool empty() const { return pbegin == pend; }
+    const char* data() const { return pbegin; }
+    int GetVersion() const { return nVersion; }
+    int GetType() const { return nType; }
+
+private:
+    const int nType;
+    const int nVersion;
+    const char* pbegin;
+    const char* pend;
+};
+
 /** Double ended buffer combining vector and stream-like interfaces.
  *
  * >> and << read and write unformatted data using the above serialization templates.
@@ -411,6 +457,12 @@ public:
         clear();
     }
 
+    /** Exchange the underlying buffer with another, rewinding the stream. No data is copied. */
+    void SwapBuffer(vector_type& vchOther) {
+        vch.swap(vchOther);
+        nReadPos = 0;
+    }
+
     /**
      * XOR the contents of this stream with a certain key.
      *
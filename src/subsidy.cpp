@@ -0,0 +1,111 @@
+// Copyright (c) 2009-2010 Satoshi Nakamoto
+// Copyright (c) 2009-2017 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <subsidy.h>
+
+#include <consensus/params.h>
+
+#include <algorithm>
+#include <limits>
+#include <set>
+
+CAmount CalculateBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
+{
+    // LitecoinCash: Issue premine on 1st post-fork block
+   /* if (nHeight == consensusParams.lastScryptBlock + 1)
+        return consensusParams.premineAmount * COIN * COIN_SCALE;*/
+
+    int halvings = nHeight / consensusParams.nSubsidyHalvingInterval;
+    // LitecoinCash: Force block reward to zero when right shift is undefined, and don't attempt to issue past total money supply
+    if (halvings >= 64 || nHeight >= consensusParams.totalMoneySupplyHeight)
+        return 0;
+
+    if (nHeight == 1)
+        return 500000 * COIN * COIN_SCALE;
+    if (nHeight == 2)
+        return 500000 * COIN * COIN_SCALE;
+    if (nHeight == 3)
+	return 500000 * COIN * COIN_SCALE;
+    if (nHeight == 4)
+	return 500000 * COIN * COIN_SCALE;
+
+    CAmount nSubsidy = 5 * COIN * COIN_SCALE;
+    // Subsidy is cut in half every 210,000 blocks which will occur approximately every 4 years.
+    nSubsidy >>= halvings;
+
+    // Thor: Slow-start the first n blocks  blocks to prevent early miners having an unfair advantage
+    int64_t blocksSinceFork = nHeight - consensusParams.lastScryptBlock;
+    if (blocksSinceFork > 0 && blocksSinceFork < consensusParams.slowStartBlocks) {
+        CAmount incrementPerBlock = nSubsidy / consensusParams.slowStartBlocks;
+        nSubsidy = blocksSinceFork * incrementPerBlock;
+    }
+
+    return nSubsidy;
+}
+
+// Thor: Forge: Return the current cost for a single worker hammer
+CAmount CalculateHammerCost(int nHeight, const Consensus::Params& consensusParams)
+{
+    if(nHeight >= consensusParams.totalMoneySupplyHeight)
+        return consensusParams.minHammerCost;
+
+    CAmount blockReward = CalculateBlockSubsidy(nHeight, consensusParams);
+    CAmount hammerCost = blockReward / consensusParams.hammerCostFactor;
+    return hammerCost <= consensusParams.minHammerCost ? consensusParams.minHammerCost : hammerCost;
+}
+
+void BuildSubsidySchedule(Consensus::Params& consensusParams)
+{
+    // Both formulas are constant between these heights: the premine blocks, each slow-start
+    // block, each halving and the total money supply height.
+    std::set<int64_t> boundaries = {0, 1, 2, 3, 4, 5};
+    for (int64_t i = 1; i <= consensusParams.slowStartBlocks; i++)
+        boundaries.insert(consensusParams.lastScryptBlock + i);
+    for (int64_t halvings = 1; halvings <= 64; halvings++) {
+        int64_t nHeight = halvings * consensusParams.nSubsidyHalvingInterval;
+        if (nHeight > consensusParams.totalMoneySupplyHeight)
+            break;
+        boundaries.insert(nHeight);
+    }
+    boundaries.insert(consensusParams.totalMoneySupplyHeight);
+
+    std::vector<Consensus::SubsidyScheduleEntry>& schedule = consensusParams.subsidySchedule;
+    schedule.clear();
+    for (int64_t nHeight : boundaries) {
+        if (nHeight < 0 || nHeight > std::numeric_limits<int>::max())
+            continue;
+        Consensus::SubsidyScheduleEntry entry;
+        entry.nHeight = nHeight;
+        entry.nSubsidy = CalculateBlockSubsidy(nHeight, consensusParams);
+        entry.nHammerCost = CalculateHammerCost(nHeight, consensusParams);
+        if (!schedule.empty() && schedule.back().nSubsidy == entry.nSubsidy && schedule.back().nHammerCost == entry.nHammerCost)
+            continue;
+        schedule.push_back(entry);
+    }
+}
+
+// Thor: Find the schedule entry covering nHeight, or nullptr if there is no schedule for these params
+static const Consensus::SubsidyScheduleEntry* LookupSubsidySchedule(int nHeight, const Consensus::Params& consensusParams)
+{
+    const std::vector<Consensus::SubsidyScheduleEntry>& schedule = consensusParams.subsidySchedule;
+    if (schedule.empty() || nHeight < schedule.front().nHeight)
+        return nullptr;
+
+    auto it = std::upper_bound(schedule.begin(), schedule.end(), nHeight,
+        [](int nHeight, const Consensus::SubsidyScheduleEntry& entry) { return nHeight < entry.nHeight; });
+    return &*(it - 1);
+}
+
+CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
+{
+    const Consensus::SubsidyScheduleEntry* entry = LookupSubsidySchedule(nHeight, consensusParams);
+    return entry ? entry->nSubsidy : CalculateBlockSubsidy(nHeight, consensusParams);
+}
+
+CAmount GetHammerCost(int nHeight, const Consensus::Params& consensusParams)
+{
+    const Consensus::SubsidyScheduleEntry* entry = LookupSubsidySchedule(nHeight, consensusParams);
+    return entry ? entry->nHammerCost : CalculateHammerCost(nHeight, consensusParams);
+}
@@ -0,0 +1,32 @@
+// Copyright (c) 2009-2010 Satoshi Nakamoto
+// Copyright (c) 2009-2017 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SUBSIDY_H
+#define BITCOIN_SUBSIDY_H
+
+#include <amount.h>
+
+namespace Consensus { struct Params; }
+
+CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams);
+CAmount GetHammerCost(int nHeight, const Consensus::Params& consensusParams);  // Thor: Forge: Get the cost of a hammer at given height
+
+/**
+ * Thor: The emission schedule as a formula, evaluated for a single height. GetBlockSubsidy()
+ * and GetHammerCost() return the same values from consensusParams.subsidySchedule when it
+ * has been built, and fall back to these otherwise.
+ */
+CAmount CalculateBlockSubsidy(int nHeight, const Consensus::Params& consensusParams);
+CAmount CalculateHammerCost(int nHeight, const Consensus::Params& consensusParams);
+
+/**
+ * Thor: Fill consensusParams.subsidySchedule with one entry per height at which the subsidy
+ * or hammer cost changes. Call once all the emission fields (halving interval, slow start,
+ * total money supply height, hammer cost factor) have been set; hammerCostFactor must be
+ * non-zero.
+ */
+void BuildSubsidySchedule(Consensus::Params& consensusParams);
+
+#endif // BITCOIN_SUBSIDY_H
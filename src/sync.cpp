@@ -21,6 +21,29 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+// Thor: Lock contention counts for -debug=lock
+static std::mutex mutexLockContention;
+static std::map<std::string, uint64_t> mapLockContention;
+
+void CountLockContention(const char* pszName, const char* pszFile, int nLine)
+{
+    if (!LogAcceptCategory(BCLog::LOCK))
+        return;
+
+    uint64_t nCount;
+    {
+        std::lock_guard<std::mutex> lock(mutexLockContention);
+        nCount = ++mapLockContention[pszName];
+    }
+    LogPrint(BCLog::LOCK, "LOCKCONTENTION: %s at %s:%d (%u so far)\n", pszName, pszFile, nLine, nCount);
+}
+
+std::map<std::string, uint64_t> GetLockContentionCounts()
+{
+    std::lock_guard<std::mutex> lock(mutexLockContention);
+    return mapLockContention;
+}
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
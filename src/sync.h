@@ -9,8 +9,10 @@
 #include <threadsafety.h>
 
 #include <condition_variable>
+#include <map>
 #include <thread>
 #include <mutex>
+#include <string>
 
 
 ////////////////////////////////////////////////
@@ -112,6 +114,11 @@ typedef std::unique_lock<std::mutex> WaitableLock;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/** Thor: Count a wait on a lock another thread holds (only while -debug=lock is on) */
+void CountLockContention(const char* pszName, const char* pszFile, int nLine);
+/** Thor: Number of waits counted on each lock, by name */
+std::map<std::string, uint64_t> GetLockContentionCounts();
+
 /** Wrapper around std::unique_lock<CCriticalSection> */
 class SCOPED_LOCKABLE CCriticalBlock
 {
@@ -121,14 +128,13 @@ private:
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(lock.mutex()));
-#ifdef DEBUG_LOCKCONTENTION
         if (!lock.try_lock()) {
+#ifdef DEBUG_LOCKCONTENTION
             PrintLockContention(pszName, pszFile, nLine);
 #endif
+            CountLockContention(pszName, pszFile, nLine);
             lock.lock();
-#ifdef DEBUG_LOCKCONTENTION
         }
-#endif
     }
 
     bool TryEnter(const char* pszName, const char* pszFile, int nLine)
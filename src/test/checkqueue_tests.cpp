@@ -16,6 +16,7 @@
 #include <mutex>
 #include <condition_variable>
 
+#include <set>
 #include <unordered_set>
 #include <memory>
 #include <random.h>
@@ -73,6 +74,18 @@ struct UniqueCheck {
     void swap(UniqueCheck& x) { std::swap(x.check_id, check_id); };
 };
 
+// Thor: Records the threads checks ran on
+struct ThreadCheck {
+    static std::mutex m;
+    static std::set<std::thread::id> threads;
+    bool operator()()
+    {
+        std::lock_guard<std::mutex> l(m);
+        threads.insert(std::this_thread::get_id());
+        return true;
+    }
+    void swap(ThreadCheck& x){};
+};
 
 struct MemoryCheck {
     static std::atomic<size_t> fake_allocated_memory;
@@ -131,6 +144,8 @@ std::atomic<uint64_t> FrozenCleanupCheck::nFrozen{0};
 std::condition_variable FrozenCleanupCheck::cv{};
 std::mutex UniqueCheck::m;
 std::unordered_multiset<size_t> UniqueCheck::results;
+std::mutex ThreadCheck::m;
+std::set<std::thread::id> ThreadCheck::threads;
 std::atomic<size_t> FakeCheckCheckCompletion::n_calls{0};
 std::atomic<size_t> MemoryCheck::fake_allocated_memory{0};
 
@@ -139,6 +154,7 @@ typedef CCheckQueue<FakeCheckCheckCompletion> Correct_Queue;
 typedef CCheckQueue<FakeCheck> Standard_Queue;
 typedef CCheckQueue<FailingCheck> Failing_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
+typedef CCheckQueue<ThreadCheck> Thread_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
 typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
 
@@ -380,6 +396,33 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_FrozenCleanup)
     BOOST_REQUIRE(!fails);
 }
 
+// Thor: Test that workers beyond SetMaxWorkers take no work, and take it again once allowed
+BOOST_AUTO_TEST_CASE(test_CheckQueue_MaxWorkers)
+{
+    auto queue = std::unique_ptr<Thread_Queue>(new Thread_Queue {1});
+    boost::thread_group tg;
+    for (auto x = 0; x < nScriptCheckThreads; ++x) {
+       tg.create_thread([&]{queue->Thread();});
+    }
+
+    for (int nMaxWorkers : {0, 1, 0, nScriptCheckThreads}) {
+        queue->SetMaxWorkers(nMaxWorkers);
+        ThreadCheck::threads.clear();
+        {
+            CCheckQueueControl<ThreadCheck> control(queue.get());
+            for (int i = 0; i < 100; i++) {
+                std::vector<ThreadCheck> vChecks(100);
+                control.Add(vChecks);
+                MilliSleep(1);
+            }
+        }
+        BOOST_CHECK_LE(ThreadCheck::threads.size(), (size_t)nMaxWorkers + 1);
+        if (nMaxWorkers == 0)
+            BOOST_CHECK(ThreadCheck::threads.count(std::this_thread::get_id()));
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
 
 /** Test that CCheckQueueControl is threadsafe */
 BOOST_AUTO_TEST_CASE(test_CheckQueueControl_Locks)
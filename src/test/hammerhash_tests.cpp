@@ -0,0 +1,120 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <hammerhash.h>
+#include <hash.h>
+#include <test/test_bitcoin.h>
+#include <uint256.h>
+#include <validation.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(hammerhash_tests, BasicTestingSetup)
+
+// Build a rand string the way GetDeterministicRandString does: six block hashes as hex
+static std::string SampleRandString()
+{
+    std::string deterministicRandString;
+    for (int i = 0; i < 6; i++)
+        deterministicRandString += (CHashWriter(SER_GETHASH, 0) << std::string("block") << i).GetHash().GetHex();
+    return deterministicRandString;
+}
+
+BOOST_AUTO_TEST_CASE(hammerhash_matches_hashwriter)
+{
+    const std::string deterministicRandString = SampleRandString();
+    const std::string txid = uint256S("3c1ff40d1c5cd1f2ee27da72fda68e9ec8e36dde3ca3a1b4a2a7e9d5e0b4a5f1").GetHex();
+    const int hammerCount = 5000;
+
+    // A target around 1 in 64, so both outcomes are exercised
+    arith_uint256 hammerHashTarget = ~arith_uint256() >> 6;
+
+    CHammerHasher bctHasher = CHammerHasher(deterministicRandString).ForBCT(txid);
+    int solutions = 0;
+    for (int i = 0; i < hammerCount; i++) {
+        // The original CheckBin / CheckForgeProof path
+        std::string hashHex = (CHashWriter(SER_GETHASH, 0) << deterministicRandString << txid << i).GetHash().GetHex();
+        arith_uint256 hammerHash = arith_uint256(hashHex);
+
+        BOOST_CHECK_EQUAL(bctHasher.GetHash(i).GetHex(), hashHex);
+        BOOST_CHECK_EQUAL(bctHasher.CheckHash(i, hammerHashTarget), hammerHash < hammerHashTarget);
+        if (hammerHash < hammerHashTarget)
+            solutions++;
+    }
+    BOOST_CHECK(solutions > 0 && solutions < hammerCount);
+}
+
+BOOST_AUTO_TEST_CASE(hammerhash_shared_prefix)
+{
+    // Deriving several BCT hashers from one rand string hasher must not leak state between them
+    const std::string deterministicRandString = SampleRandString();
+    CHammerHasher randHasher(deterministicRandString);
+    for (int j = 0; j < 4; j++) {
+        std::string txid = ArithToUint256(arith_uint256(j + 1)).GetHex();
+        CHammerHasher bctHasher = randHasher.ForBCT(txid);
+        for (uint32_t nonce : {0u, 1u, 999u, 0xffffffffu}) {
+            uint256 expected = (CHashWriter(SER_GETHASH, 0) << deterministicRandString << txid << nonce).GetHash();
+            BOOST_CHECK(bctHasher.GetHash(nonce) == expected);
+        }
+    }
+
+    // Short strings use a single byte length prefix; the rand string above needs three
+    uint256 expected = (CHashWriter(SER_GETHASH, 0) << std::string() << std::string("x") << 7).GetHash();
+    BOOST_CHECK(CHammerHasher("").ForBCT("x").GetHash(7) == expected);
+}
+
+// The original GetDeterministicRandString: step back through pprev one block at a time
+static std::string WalkRandString(const CBlockIndex* pindexPrev)
+{
+    std::string deterministicRandString = "";
+    int heights[] = { 0, 13, 173, 471, 1363, 12103 };
+    int hits = 0, steps = 0;
+    while (hits < 6) {
+        if (steps == heights[hits]) {
+            deterministicRandString += pindexPrev->phashBlock->GetHex();
+            hits++;
+        }
+        if (!pindexPrev->pprev)
+            break;
+        pindexPrev = pindexPrev->pprev;
+        steps++;
+    }
+    return deterministicRandString;
+}
+
+BOOST_AUTO_TEST_CASE(hammerhash_deterministic_rand)
+{
+    const int nBlocks = 13000;
+    std::vector<uint256> vHashes(nBlocks);
+    std::vector<CBlockIndex> vIndex(nBlocks);
+    for (int i = 0; i < nBlocks; i++) {
+        vHashes[i] = (CHashWriter(SER_GETHASH, 0) << std::string("block") << i).GetHash();
+        vIndex[i].phashBlock = &vHashes[i];
+        vIndex[i].nHeight = i;
+        vIndex[i].pprev = (i == 0) ? nullptr : &vIndex[i - 1];
+        vIndex[i].BuildSkip();
+    }
+
+    // Chains too short for some of the ancestors, exactly long enough, and long; twice
+    // each so the second lookup is served from the cache
+    for (int nHeight : {0, 12, 13, 500, 12102, 12103, 12999, 12999, 500, 0}) {
+        const CBlockIndex* pindexPrev = &vIndex[nHeight];
+        CDeterministicRand deterministicRand = GetDeterministicRand(pindexPrev);
+        std::string deterministicRandString = WalkRandString(pindexPrev);
+        BOOST_CHECK_EQUAL(deterministicRand.ToString(), deterministicRandString);
+        BOOST_CHECK_EQUAL(GetDeterministicRandString(pindexPrev), deterministicRandString);
+
+        // Serializes, signs and hashes exactly like the string did
+        BOOST_CHECK((CHashWriter(SER_GETHASH, 0) << deterministicRand).GetHash() == (CHashWriter(SER_GETHASH, 0) << deterministicRandString).GetHash());
+        std::string txid = vHashes[nHeight].GetHex();
+        BOOST_CHECK(CHammerHasher(deterministicRand).ForBCT(txid).GetHash(nHeight) == CHammerHasher(deterministicRandString).ForBCT(txid).GetHash(nHeight));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
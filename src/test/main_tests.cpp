@@ -66,6 +66,43 @@ BOOST_AUTO_TEST_CASE(block_subsidy_money_limit)	// Thor: Change money limit test
     BOOST_CHECK_EQUAL(nSum, 8399999998750000ULL);
 }
 
+// Thor: The precomputed schedule must agree with the per-height formulas everywhere
+static void TestSubsidySchedule(const Consensus::Params& consensusParams, int nStep)
+{
+    BOOST_REQUIRE(!consensusParams.subsidySchedule.empty());
+    BOOST_CHECK_EQUAL(consensusParams.subsidySchedule.front().nHeight, 0);
+
+    // Either side of every step
+    for (const Consensus::SubsidyScheduleEntry& entry : consensusParams.subsidySchedule) {
+        for (int nHeight = std::max(0, entry.nHeight - 2); nHeight <= entry.nHeight + 2; nHeight++) {
+            BOOST_CHECK_EQUAL(GetBlockSubsidy(nHeight, consensusParams), CalculateBlockSubsidy(nHeight, consensusParams));
+            BOOST_CHECK_EQUAL(GetHammerCost(nHeight, consensusParams), CalculateHammerCost(nHeight, consensusParams));
+        }
+    }
+
+    // Across the whole emission and a halving interval past it, at nStep apart
+    int nMismatches = 0;
+    int nEnd = consensusParams.totalMoneySupplyHeight + consensusParams.nSubsidyHalvingInterval;
+    for (int nHeight = 0; nHeight < nEnd; nHeight += nStep) {
+        if (GetBlockSubsidy(nHeight, consensusParams) != CalculateBlockSubsidy(nHeight, consensusParams) ||
+            GetHammerCost(nHeight, consensusParams) != CalculateHammerCost(nHeight, consensusParams))
+            nMismatches++;
+    }
+    BOOST_CHECK_EQUAL(nMismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(subsidy_schedule_matches_formula)
+{
+    // Every step is checked either side; a coarse stride is enough for the heights between them
+    TestSubsidySchedule(CreateChainParams(CBaseChainParams::MAIN)->GetConsensus(), 997);
+    TestSubsidySchedule(CreateChainParams(CBaseChainParams::TESTNET)->GetConsensus(), 997);
+
+    // Params without a schedule are computed per height
+    const auto regtestParams = CreateChainParams(CBaseChainParams::REGTEST);
+    BOOST_CHECK(regtestParams->GetConsensus().subsidySchedule.empty());
+    BOOST_CHECK_EQUAL(GetBlockSubsidy(1, regtestParams->GetConsensus()), 500000 * COIN * COIN_SCALE);
+}
+
 bool ReturnFalse() { return false; }
 bool ReturnTrue() { return true; }
 
@@ -82,4 +119,72 @@ BOOST_AUTO_TEST_CASE(test_combiner_all)
     Test.disconnect(&ReturnTrue);
     BOOST_CHECK(Test());
 }
+
+static std::vector<unsigned char> SerializeBlock(const CBlock& block, int nVersion)
+{
+    CDataStream ss(SER_NETWORK, nVersion);
+    ss << block;
+    return std::vector<unsigned char>(ss.begin(), ss.end());
+}
+
+BOOST_AUTO_TEST_CASE(strip_block_witness)
+{
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << 1 << OP_0;
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = 1;
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+
+    // A segwit spend between two legacy ones
+    CMutableTransaction tx;
+    tx.vin.resize(2);
+    tx.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    tx.vin[1].prevout = COutPoint(InsecureRand256(), 1);
+    tx.vin[1].scriptWitness.stack.push_back(std::vector<unsigned char>(72, 0x30));
+    tx.vin[1].scriptWitness.stack.push_back(std::vector<unsigned char>(33, 0x02));
+    tx.vout.resize(2);
+    tx.vout[0].scriptPubKey = CScript() << OP_0 << std::vector<unsigned char>(20, 0x14);
+    tx.vout[0].nValue = 2;
+    tx.vout[1].nValue = 3;
+    tx.nLockTime = 77;
+    block.vtx.push_back(MakeTransactionRef(tx));
+    tx.vin[1].scriptWitness.SetNull();
+    tx.nLockTime = 78;
+    block.vtx.push_back(MakeTransactionRef(tx));
+
+    std::vector<unsigned char> full = SerializeBlock(block, PROTOCOL_VERSION);
+    std::vector<unsigned char> expected = SerializeBlock(block, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS);
+    BOOST_CHECK(full.size() > expected.size());
+    std::vector<unsigned char> stripped;
+    BOOST_CHECK(StripBlockWitness(full, stripped));
+    BOOST_CHECK(stripped == expected);
+
+    // Stripping a block without witnesses leaves it as it was
+    BOOST_CHECK(StripBlockWitness(expected, stripped));
+    BOOST_CHECK(stripped == expected);
+
+    // Truncated or padded, it doesn't parse
+    full.pop_back();
+    BOOST_CHECK(!StripBlockWitness(full, stripped));
+    expected.push_back(0);
+    BOOST_CHECK(!StripBlockWitness(expected, stripped));
+}
+
+BOOST_AUTO_TEST_CASE(read_raw_block)
+{
+    const CBlockIndex* pindex = chainActive.Genesis();
+    BOOST_REQUIRE(pindex && (pindex->nStatus & BLOCK_HAVE_DATA));
+
+    std::vector<unsigned char> raw;
+    BOOST_CHECK(ReadRawBlockFromDisk(raw, pindex, Params().MessageStart()));
+    BOOST_CHECK(raw == SerializeBlock(Params().GenesisBlock(), PROTOCOL_VERSION));
+
+    // Wrong network magic
+    CMessageHeader::MessageStartChars messageStart;
+    memcpy(messageStart, Params().MessageStart(), sizeof(messageStart));
+    messageStart[0] ^= 0xff;
+    BOOST_CHECK(!ReadRawBlockFromDisk(raw, pindex, messageStart));
+}
 BOOST_AUTO_TEST_SUITE_END()
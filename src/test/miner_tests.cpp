@@ -17,10 +17,12 @@
 #include <uint256.h>
 #include <util.h>
 #include <utilstrencodings.h>
+#include <validationinterface.h>
 
 #include <test/test_bitcoin.h>
 
 #include <memory>
+#include <set>
 
 #include <boost/test/unit_test.hpp>
 
@@ -39,10 +41,10 @@ private:
 
 static CFeeRate blockMinFeeRate = CFeeRate(DEFAULT_BLOCK_MIN_TX_FEE);
 
-static BlockAssembler AssemblerForTest(const CChainParams& params) {
+static BlockAssembler AssemblerForTest(const CChainParams& params, size_t nBlockMaxWeight = MAX_BLOCK_WEIGHT) {
     BlockAssembler::Options options;
 
-    options.nBlockMaxWeight = MAX_BLOCK_WEIGHT;
+    options.nBlockMaxWeight = nBlockMaxWeight;
     options.blockMinFeeRate = blockMinFeeRate;
     return BlockAssembler(params, options);
 }
@@ -376,6 +378,7 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
         next->pprev = prev;
         next->nHeight = prev->nHeight + 1;
         next->BuildSkip();
+        next->BuildForgeCounters(chainparams.GetConsensus());
         chainActive.SetTip(next);
     }
     BOOST_CHECK(pblocktemplate = AssemblerForTest(chainparams).CreateNewBlock(scriptPubKey));
@@ -388,6 +391,7 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
         next->pprev = prev;
         next->nHeight = prev->nHeight + 1;
         next->BuildSkip();
+        next->BuildForgeCounters(chainparams.GetConsensus());
         chainActive.SetTip(next);
     }
     BOOST_CHECK(pblocktemplate = AssemblerForTest(chainparams).CreateNewBlock(scriptPubKey));
@@ -520,4 +524,178 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+// Thor: Incremental templates: A one-in, one-out transaction spending prevout
+static CMutableTransaction CacheTestTx(const COutPoint& prevout)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = prevout;
+    tx.vin[0].scriptSig = CScript() << OP_1;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = COIN;
+    tx.vout[0].scriptPubKey = CScript() << OP_1;
+    return tx;
+}
+
+// Thor: Incremental templates: Add a transaction to the mempool and, if fNotify, tell the template cache about it
+// as AcceptToMemoryPool would
+static uint256 AddToMempool(const CMutableTransaction& tx, CAmount nFee, bool fNotify = true)
+{
+    TestMemPoolEntryHelper entry;
+    CTransactionRef ptx = MakeTransactionRef(tx);
+    mempool.addUnchecked(ptx->GetHash(), entry.Fee(nFee).Time(GetTime()).FromTx(*ptx));
+    if (fNotify) {
+        GetMainSignals().TransactionAddedToMempool(ptx);
+        SyncWithValidationInterfaceQueue();
+    }
+    return ptx->GetHash();
+}
+
+static std::set<uint256> TemplateTxids(const CBlockTemplate& tmpl)
+{
+    std::set<uint256> txids;
+    for (size_t i = 1; i < tmpl.block.vtx.size(); i++)
+        txids.insert(tmpl.block.vtx[i]->GetHash());
+    return txids;
+}
+
+// Thor: Incremental templates: Check a template against one selected from scratch
+static void CheckMatchesFromScratch(const CBlockTemplate& tmpl, size_t nBlockMaxWeight = MAX_BLOCK_WEIGHT)
+{
+    InvalidateBlockTemplateCache();
+    std::unique_ptr<CBlockTemplate> scratch = AssemblerForTest(Params(), nBlockMaxWeight).CreateNewBlock(CScript() << OP_TRUE, true, nullptr, false);
+    BOOST_CHECK(TemplateTxids(tmpl) == TemplateTxids(*scratch));
+    BOOST_CHECK_EQUAL(tmpl.vTxFees[0], scratch->vTxFees[0]);
+}
+
+BOOST_AUTO_TEST_CASE(CreateNewBlock_template_cache)
+{
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    mempool.clear();
+    RegisterBlockTemplateCache();
+    GetMainSignals().RegisterWithMempoolSignals(mempool);
+
+    const uint256 hash1 = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 10000);
+    const uint256 hash2 = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 20000);
+    std::unique_ptr<CBlockTemplate> pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 3);
+    BOOST_CHECK(pblocktemplate->block.vtx[1]->GetHash() == hash2);
+
+    // New transactions, a child of a selected one among them, are appended to the cached selection
+    // even where a selection from scratch would have put them first
+    const uint256 hash3 = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 50000);
+    const uint256 hash4 = AddToMempool(CacheTestTx(COutPoint(hash1, 0)), 40000);
+    pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 5);
+    BOOST_CHECK(pblocktemplate->block.vtx[1]->GetHash() == hash2);
+    BOOST_CHECK(pblocktemplate->block.vtx[2]->GetHash() == hash1);
+    BOOST_CHECK(pblocktemplate->block.vtx[3]->GetHash() == hash3);
+    BOOST_CHECK(pblocktemplate->block.vtx[4]->GetHash() == hash4);
+    CheckMatchesFromScratch(*pblocktemplate);
+
+    // Without a notification the cached selection is carried on as it is
+    pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    const uint256 hash5 = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 10000, false);
+    pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK(!TemplateTxids(*pblocktemplate).count(hash5));
+
+    // Removing a selected transaction drops the selection
+    BOOST_CHECK(TemplateTxids(*pblocktemplate).count(hash2));
+    mempool.removeRecursive(*mempool.get(hash2));
+    SyncWithValidationInterfaceQueue();
+    pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK(!TemplateTxids(*pblocktemplate).count(hash2));
+    BOOST_CHECK(TemplateTxids(*pblocktemplate).count(hash5));
+    CheckMatchesFromScratch(*pblocktemplate);
+
+    // So does a tip change
+    pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    const uint256 hash6 = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 10000, false);
+    uint256 hashOtherTip = InsecureRand256();
+    CBlockIndex indexOtherTip;
+    indexOtherTip.phashBlock = &hashOtherTip;
+    GetMainSignals().UpdatedBlockTip(&indexOtherTip, nullptr, false);
+    SyncWithValidationInterfaceQueue();
+    pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK(TemplateTxids(*pblocktemplate).count(hash6));
+
+    // And a fee delta, whoever sets it
+    const uint256 hash7 = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 10000, false);
+    mempool.PrioritiseTransaction(hash3, -40000);
+    pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK(TemplateTxids(*pblocktemplate).count(hash7));
+    CheckMatchesFromScratch(*pblocktemplate);
+    mempool.ClearPrioritisation(hash3);
+
+    GetMainSignals().UnregisterWithMempoolSignals(mempool);
+    UnregisterBlockTemplateCache();
+    mempool.clear();
+}
+
+BOOST_AUTO_TEST_CASE(CreateNewBlock_template_cache_rebuild)
+{
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    mempool.clear();
+    RegisterBlockTemplateCache();
+
+    // A transaction whose parent wasn't selected is only taken with it, by a selection from scratch
+    const uint256 hashParent = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 0);
+    std::unique_ptr<CBlockTemplate> pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 1);
+    const uint256 hashChild = AddToMempool(CacheTestTx(COutPoint(hashParent, 0)), 50000);
+    pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 3);
+    BOOST_CHECK(pblocktemplate->block.vtx[1]->GetHash() == hashParent);
+    BOOST_CHECK(pblocktemplate->block.vtx[2]->GetHash() == hashChild);
+    CheckMatchesFromScratch(*pblocktemplate);
+    mempool.clear();
+
+    // Room for two transactions
+    const size_t nTxWeight = WITNESS_SCALE_FACTOR * ::GetSerializeSize(CacheTestTx(COutPoint()), SER_NETWORK, PROTOCOL_VERSION);
+    const size_t nBlockMaxWeight = 4000 + 2 * nTxWeight + 1;
+    const uint256 hashA = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 20000);
+    const uint256 hashB = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 30000);
+    pblocktemplate = AssemblerForTest(Params(), nBlockMaxWeight).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 3);
+
+    // A full block keeps its selection for a transaction paying less than any selected one...
+    const uint256 hashLow = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 10000);
+    pblocktemplate = AssemblerForTest(Params(), nBlockMaxWeight).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK(TemplateTxids(*pblocktemplate) == std::set<uint256>({hashA, hashB}));
+    BOOST_CHECK(!TemplateTxids(*pblocktemplate).count(hashLow));
+    CheckMatchesFromScratch(*pblocktemplate, nBlockMaxWeight);
+
+    // ...and is selected from scratch for one paying more
+    pblocktemplate = AssemblerForTest(Params(), nBlockMaxWeight).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    const uint256 hashHigh = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 40000);
+    pblocktemplate = AssemblerForTest(Params(), nBlockMaxWeight).CreateNewBlock(scriptPubKey, true, nullptr, false);
+    BOOST_CHECK(TemplateTxids(*pblocktemplate) == std::set<uint256>({hashHigh, hashB}));
+    CheckMatchesFromScratch(*pblocktemplate, nBlockMaxWeight);
+
+    UnregisterBlockTemplateCache();
+    mempool.clear();
+}
+
+BOOST_AUTO_TEST_CASE(CreateNewBlock_template_cache_tested)
+{
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+    mempool.clear();
+    RegisterBlockTemplateCache();
+
+    BOOST_CHECK(AssemblerForTest(Params()).CreateNewBlock(scriptPubKey));
+
+    // A body that passed TestBlockValidity isn't tested again for what is appended to it (here a transaction
+    // whose input doesn't exist, which AcceptToMemoryPool would have turned away)...
+    const uint256 hash = AddToMempool(CacheTestTx(COutPoint(InsecureRand256(), 0)), 10000);
+    std::unique_ptr<CBlockTemplate> pblocktemplate = AssemblerForTest(Params()).CreateNewBlock(scriptPubKey);
+    BOOST_CHECK(TemplateTxids(*pblocktemplate).count(hash));
+
+    // ...but a selection from scratch is
+    InvalidateBlockTemplateCache();
+    BOOST_CHECK_EXCEPTION(AssemblerForTest(Params()).CreateNewBlock(scriptPubKey), std::runtime_error, HasReason("bad-txns-inputs-missingorspent"));
+
+    UnregisterBlockTemplateCache();
+    mempool.clear();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
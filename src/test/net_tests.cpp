@@ -10,6 +10,7 @@
 #include <streams.h>
 #include <net.h>
 #include <netbase.h>
+#include <netmessagemaker.h>
 #include <chainparams.h>
 #include <util.h>
 
@@ -185,4 +186,124 @@ BOOST_AUTO_TEST_CASE(cnode_simple_test)
     BOOST_CHECK(pnode2->fFeeler == false);
 }
 
+#ifndef WIN32
+// Thor: A message serialized once and queued to several peers reaches each of them whole
+BOOST_AUTO_TEST_CASE(shared_message_send)
+{
+    CConnman connman(0x1337, 0x1337);
+    CSerializedNetMsg msg = CNetMsgMaker(PROTOCOL_VERSION).Make(NetMsgType::PING, (uint64_t)0x0102030405060708);
+    std::vector<unsigned char> payload = msg.data;
+    CSharedNetMsgRef shared = MakeSharedNetMsg(std::move(msg));
+
+    // What PushMessage used to build for each peer
+    CMessageHeader hdr(Params().MessageStart(), NetMsgType::PING, payload.size());
+    uint256 hash = Hash(payload.begin(), payload.end());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+    std::vector<unsigned char> expected;
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, expected, 0, hdr};
+    expected.insert(expected.end(), payload.begin(), payload.end());
+    BOOST_CHECK(shared->size() == expected.size());
+
+    for (NodeId id = 0; id < 2; id++) {
+        int fds[2];
+        BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        CNode node(id, NODE_NETWORK, 0, fds[0], CAddress(), 0, 0, CAddress(), "", false);
+        connman.PushMessage(&node, shared);
+        connman.PushMessage(&node, shared);
+        {
+            LOCK(node.cs_vSend);
+            BOOST_CHECK(node.vSendMsg.empty());
+            BOOST_CHECK_EQUAL(node.nSendSize, 0U);
+        }
+
+        std::vector<unsigned char> received(expected.size() * 2 + 1);
+        ssize_t nBytes = recv(fds[1], received.data(), received.size(), MSG_DONTWAIT);
+        BOOST_REQUIRE_EQUAL(nBytes, (ssize_t)expected.size() * 2);
+        BOOST_CHECK(std::equal(expected.begin(), expected.end(), received.begin()));
+        BOOST_CHECK(std::equal(expected.begin(), expected.end(), received.begin() + expected.size()));
+        close(fds[1]);
+    }
+    BOOST_CHECK_EQUAL(shared.use_count(), 1);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(message_queue_time)
+{
+    CNode node(0, NODE_NETWORK, 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", false);
+    node.RecordQueueTime(NetMsgType::INV, 1000);
+    node.RecordQueueTime(NetMsgType::INV, 3000);
+    node.RecordQueueTime("nosuchcmd", 500);
+
+    CNodeStats stats;
+    node.copyStats(stats);
+    BOOST_CHECK_EQUAL(stats.mapRecvQueueTimePerMsgCmd.size(), 2U);
+    const CMsgQueueTime& inv = stats.mapRecvQueueTimePerMsgCmd[NetMsgType::INV];
+    BOOST_CHECK_EQUAL(inv.nCount, 2U);
+    BOOST_CHECK_EQUAL(inv.nTotalMicros, 4000);
+    BOOST_CHECK_EQUAL(inv.nMaxMicros, 3000);
+    // Unknown commands are lumped together, so peers can't grow the map
+    const CMsgQueueTime& other = stats.mapRecvQueueTimePerMsgCmd["*other*"];
+    BOOST_CHECK_EQUAL(other.nCount, 1U);
+    BOOST_CHECK_EQUAL(other.nMaxMicros, 500);
+}
+
+BOOST_AUTO_TEST_CASE(message_recv_in_place)
+{
+    CNode node(0, NODE_NETWORK, 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", false);
+    std::vector<unsigned char> payload(300000);
+    for (size_t i = 0; i < payload.size(); i++)
+        payload[i] = i % 251;
+    CMessageHeader hdr(Params().MessageStart(), NetMsgType::BLOCK, payload.size());
+    uint256 hash = Hash(payload.begin(), payload.end());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+    CDataStream wire(SER_NETWORK, INIT_PROTO_VERSION);
+    wire << hdr;
+    wire.write((const char*)payload.data(), payload.size());
+    // A second, small message behind it
+    CSerializedNetMsg ping = CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::PING, uint64_t(42));
+    wire << CMessageHeader(Params().MessageStart(), NetMsgType::PING, ping.data.size());
+    wire.write((const char*)ping.data.data(), ping.data.size());
+
+    CRecvBufferStats statsBefore = g_recv_buffer_pool.GetStats();
+    size_t nPos = 0;
+    bool complete = false;
+    unsigned int nBytes = 0;
+    // Nothing to receive into until a header has arrived
+    BOOST_CHECK(node.GetRecvBuffer(nBytes) == nullptr);
+    // The header and the start of the body arrive in the socket handler's buffer
+    BOOST_CHECK(node.ReceiveMsgBytes(&wire[0], 1000, complete));
+    nPos += 1000;
+    while (char* pch = node.GetRecvBuffer(nBytes)) {
+        BOOST_CHECK(nBytes > 0 && nBytes <= MAX_RECV_AHEAD);
+        nBytes = std::min<unsigned int>(nBytes, 74000);
+        memcpy(pch, &wire[nPos], nBytes);
+        BOOST_CHECK(node.ReceiveMsgBytes(pch, nBytes, complete));
+        nPos += nBytes;
+    }
+    // What's left is too little to receive in place, and arrives with the ping
+    BOOST_CHECK(wire.size() - nPos < MIN_RECV_IN_PLACE + ping.data.size() + CMessageHeader::HEADER_SIZE);
+    BOOST_CHECK(node.ReceiveMsgBytes(&wire[nPos], wire.size() - nPos, complete));
+    BOOST_CHECK(complete);
+
+    std::list<CNetMessage> msgs;
+    BOOST_CHECK_EQUAL(node.TakeCompleteMessages(msgs), wire.size());
+    BOOST_REQUIRE_EQUAL(msgs.size(), 2U);
+    CNetMessage& msg = msgs.front();
+    BOOST_CHECK_EQUAL(msg.hdr.GetCommand(), NetMsgType::BLOCK);
+    BOOST_CHECK(msg.GetMessageHash() == hash);
+    BOOST_REQUIRE_EQUAL(msg.vRecv.size(), payload.size());
+    BOOST_CHECK(memcmp(msg.vRecv.data(), payload.data(), payload.size()) == 0);
+    uint64_t nonce;
+    msgs.back().vRecv >> nonce;
+    BOOST_CHECK_EQUAL(nonce, 42U);
+
+    CRecvBufferStats stats = g_recv_buffer_pool.GetStats();
+    uint64_t nInPlace = stats.nInPlaceBytes - statsBefore.nInPlaceBytes;
+    BOOST_CHECK(nInPlace >= payload.size() - 1000 - MIN_RECV_IN_PLACE);
+    BOOST_CHECK(nInPlace + stats.nCopiedBytes - statsBefore.nCopiedBytes >= payload.size() + ping.data.size());
+    // Once processed, the buffers go back to the pool
+    msgs.clear();
+    BOOST_CHECK(g_recv_buffer_pool.GetStats().nPooledBytes >= stats.nPooledBytes + payload.size());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,9 +4,11 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <forgeproofcache.h>
 #include <pow.h>
 #include <random.h>
 #include <util.h>
+#include <validation.h>
 #include <test/test_bitcoin.h>
 
 #include <boost/test/unit_test.hpp>
@@ -83,4 +85,160 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+// Thor: Forge: The hammer hash target as it was computed by walking back through pprev, before the
+// per-index Forge counters (pre-1.1 EMA and Forge 1.3 SMA; the synthetic chains never activate 1.1/1.2)
+static unsigned int WalkForgeWorkRequired(const CBlockIndex* pindexLast, const Consensus::Params& params)
+{
+    if (IsForge13Enabled(pindexLast->nHeight)) {
+        const arith_uint256 bnPowLimit = UintToArith256(params.powLimitForge2);
+        arith_uint256 hammerHashTarget = 0;
+        int forgeBlockCount = 0;
+        for (int i = 0; i < params.forgeDifficultyWindow2; i++) {
+            if (!pindexLast->pprev || pindexLast->nHeight < params.minForgeCheckBlock)
+                return bnPowLimit.GetCompact();
+            if (pindexLast->GetBlockHeader().IsForgeMined(params)) {
+                hammerHashTarget += arith_uint256().SetCompact(pindexLast->nBits);
+                forgeBlockCount++;
+            }
+            pindexLast = pindexLast->pprev;
+        }
+        if (forgeBlockCount == 0)
+            return bnPowLimit.GetCompact();
+        hammerHashTarget /= forgeBlockCount;
+        hammerHashTarget *= params.forgeDifficultyWindow2 / params.forgeBlockSpacingTarget;
+        hammerHashTarget /= forgeBlockCount;
+        if (hammerHashTarget > bnPowLimit)
+            hammerHashTarget = bnPowLimit;
+        return hammerHashTarget.GetCompact();
+    }
+
+    const arith_uint256 bnPowLimit = UintToArith256(params.powLimitForge);
+    const arith_uint256 bnPowLimit2 = UintToArith256(params.powLimitForge2);
+    arith_uint256 hammerHashTarget;
+    int numPowBlocks = 0;
+    while (true) {
+        if (!pindexLast->pprev || pindexLast->nHeight < params.minForgeCheckBlock)
+            return bnPowLimit.GetCompact();
+        if (pindexLast->GetBlockHeader().IsForgeMined(params)) {
+            hammerHashTarget.SetCompact(pindexLast->nBits);
+            break;
+        }
+        pindexLast = pindexLast->pprev;
+        numPowBlocks++;
+    }
+    if (numPowBlocks == 0)
+        return arith_uint256().GetCompact();
+    int interval = params.forgeTargetAdjustAggression / params.forgeBlockSpacingTarget;
+    hammerHashTarget *= (interval - 1) * params.forgeBlockSpacingTarget + numPowBlocks + numPowBlocks;
+    hammerHashTarget /= (interval + 1) * params.forgeBlockSpacingTarget;
+    if (hammerHashTarget > bnPowLimit2)
+        hammerHashTarget = bnPowLimit;
+    return hammerHashTarget.GetCompact();
+}
+
+static void BuildForgeChain(std::vector<CBlockIndex>& blocks, const Consensus::Params& params)
+{
+    const arith_uint256 bnPowLimit = UintToArith256(params.powLimitForge);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        blocks[i].pprev = i ? &blocks[i - 1] : nullptr;
+        blocks[i].nHeight = i;
+        blocks[i].nTime = 1585891944 + i * params.nPowTargetSpacing;
+        // Runs of up to four Forge blocks, each with its own target
+        if (InsecureRandRange(3) == 0 && !(i > 0 && blocks[i - 1].nForgeBlocksAtTip >= 4)) {
+            blocks[i].nNonce = params.forgeNonceMarker;
+            blocks[i].nBits = arith_uint256(bnPowLimit >> InsecureRandRange(32)).GetCompact();
+        } else {
+            blocks[i].nNonce = 0;
+            blocks[i].nBits = 0x1e0ffff0;
+        }
+        blocks[i].BuildSkip();
+        blocks[i].BuildForgeCounters(params);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(forge_counters)
+{
+    const auto chainParams = CreateChainParams(CBaseChainParams::MAIN);
+    const Consensus::Params& params = chainParams->GetConsensus();
+
+    // Rooted at genesis, so the walk runs out below minForgeCheckBlock, and long enough to reach Forge 1.3
+    std::vector<CBlockIndex> blocks(nTypoFork + 200);
+    BuildForgeChain(blocks, params);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (i == 2000)
+            i = nTypoFork - 200;
+        int forgeAtTip = 0, powAtTip = 0, forgeBlocks = 0;
+        for (const CBlockIndex* pindex = &blocks[i]; pindex && pindex->GetBlockHeader().IsForgeMined(params); pindex = pindex->pprev)
+            forgeAtTip++;
+        for (const CBlockIndex* pindex = &blocks[i]; pindex && !pindex->GetBlockHeader().IsForgeMined(params); pindex = pindex->pprev)
+            powAtTip++;
+        for (const CBlockIndex* pindex = &blocks[i]; pindex; pindex = pindex->pprev)
+            forgeBlocks += pindex->GetBlockHeader().IsForgeMined(params);
+        BOOST_CHECK_EQUAL(blocks[i].nForgeBlocksAtTip, forgeAtTip);
+        BOOST_CHECK_EQUAL(blocks[i].nPoWBlocksAtTip, powAtTip);
+        BOOST_CHECK_EQUAL(blocks[i].nChainForgeBlocks, forgeBlocks);
+        BOOST_CHECK_EQUAL(GetNextForgeWorkRequired(&blocks[i], params), WalkForgeWorkRequired(&blocks[i], params));
+    }
+
+    // The synthetic chain went through the deployment state cache
+    versionbitscache.Clear();
+}
+
+/* Thor: Forge: Only passing forge proofs are cached, and entries only hit under the salt they were made with */
+BOOST_AUTO_TEST_CASE(forge_proof_cache)
+{
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(2);
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    CBlock failingBlock = block;
+    failingBlock.nNonce = 1;
+
+    int nChecks = 0;
+    auto fnPass = [&nChecks] { nChecks++; return true; };
+    auto fnFail = [&nChecks] { nChecks++; return false; };
+
+    const uint256 salt = uint256S("01");
+    CForgeProofCache cache(salt);
+    cache.setup_bytes(1 << 20);
+
+    // A valid proof is checked once, and hits after that without being checked again
+    BOOST_CHECK(cache.Check(block, fnPass));
+    BOOST_CHECK_EQUAL(nChecks, 1);
+    BOOST_CHECK_EQUAL(cache.nHits.load(), 0U);
+    BOOST_CHECK_EQUAL(cache.nMisses.load(), 1U);
+    BOOST_CHECK(cache.Check(block, fnFail));
+    BOOST_CHECK_EQUAL(nChecks, 1);
+    BOOST_CHECK_EQUAL(cache.nHits.load(), 1U);
+    BOOST_CHECK_EQUAL(cache.nMisses.load(), 1U);
+
+    // A failing proof is never inserted, so it's checked every time
+    BOOST_CHECK(!cache.Check(failingBlock, fnFail));
+    BOOST_CHECK(!cache.Check(failingBlock, fnFail));
+    BOOST_CHECK_EQUAL(nChecks, 3);
+    BOOST_CHECK_EQUAL(cache.nHits.load(), 1U);
+    BOOST_CHECK_EQUAL(cache.nMisses.load(), 3U);
+
+    // The entry commits to the coinbase, which carries the proof
+    CBlock otherProofBlock = block;
+    coinbase.vout[0].nValue = 1;
+    otherProofBlock.vtx[0] = MakeTransactionRef(coinbase);
+    BOOST_CHECK(!cache.Check(otherProofBlock, fnFail));
+    BOOST_CHECK_EQUAL(nChecks, 4);
+
+    // A different salt gives a different entry, so it misses
+    uint256 entry, sameSaltEntry, otherSaltEntry;
+    cache.ComputeEntry(entry, block);
+    CForgeProofCache(salt).ComputeEntry(sameSaltEntry, block);
+    CForgeProofCache otherSaltCache(uint256S("02"));
+    otherSaltCache.ComputeEntry(otherSaltEntry, block);
+    BOOST_CHECK(entry == sameSaltEntry);
+    BOOST_CHECK(entry != otherSaltEntry);
+    BOOST_CHECK(otherSaltCache.Check(block, fnPass));
+    BOOST_CHECK_EQUAL(nChecks, 5);
+    BOOST_CHECK_EQUAL(otherSaltCache.nHits.load(), 0U);
+    BOOST_CHECK_EQUAL(otherSaltCache.nMisses.load(), 1U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -32,4 +32,34 @@ BOOST_AUTO_TEST_CASE(scrypt_hashtest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(scrypt_multi)
+{
+    // Hash 23 inputs (a mix of the vectors above and derived ones) through every
+    // lane width, so each width also has to hand its tail to the narrower kernels
+    const char* inputhex[2] = { "020000004c1271c211717198227392b029a64a7971931d351b387bb80db027f270411e398a07046f7d4a08dd815412a8712f874a7ebf0507e3878bd24e20a3b73fd750a667d2f451eac7471b00de6659", "010000007824bc3a8a1b4628485eee3024abd8626721f7f870f8ad4d2f33a27155167f6a4009d1285049603888fe85a84b6c803a53305a8d497965a5e896e1a00568359589faf551eac7471b0065434e" };
+    const size_t count = 23;
+    std::vector<std::vector<unsigned char>> inputs(count);
+    std::vector<uint256> expected(count);
+    std::vector<const char*> vInput(count);
+    char scratchpad[SCRYPT_SCRATCHPAD_SIZE];
+    for (size_t i = 0; i < count; i++) {
+        inputs[i] = ParseHex(inputhex[i % 2]);
+        inputs[i][76] ^= i; // vary the nonce
+        vInput[i] = (const char*)&inputs[i][0];
+        scrypt_1024_1_1_256_sp_generic(vInput[i], BEGIN(expected[i]), scratchpad);
+    }
+    BOOST_CHECK_EQUAL(expected[0].ToString(), "00000000002bef4107f882f6115e0b01f348d21195dacd3582aa2dabd7985806");
+
+    (void) scrypt_detect_multi();
+    for (int lanes = 1; lanes <= scrypt_multi_lanes(); lanes *= 2) {
+        std::vector<uint256> hashes(count);
+        std::vector<char*> vOutput(count);
+        for (size_t i = 0; i < count; i++)
+            vOutput[i] = BEGIN(hashes[i]);
+        scrypt_1024_1_1_256_multi(vInput.data(), vOutput.data(), count, lanes);
+        for (size_t i = 0; i < count; i++)
+            BOOST_CHECK_MESSAGE(hashes[i] == expected[i], strprintf("lanes=%d input=%u", lanes, i));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
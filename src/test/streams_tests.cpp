@@ -71,6 +71,30 @@ BOOST_AUTO_TEST_CASE(streams_vector_writer)
     vch.clear();
 }
 
+BOOST_AUTO_TEST_CASE(streams_span_reader)
+{
+    const char bytes[] = { 1, 2, 0, 3, 4, 5, 6 };
+    CSpanReader reader(SER_NETWORK, INIT_PROTO_VERSION, bytes, bytes + sizeof(bytes));
+    BOOST_CHECK_EQUAL(reader.size(), 7U);
+
+    unsigned char a, b;
+    uint16_t c;
+    reader >> a >> b >> c;
+    BOOST_CHECK_EQUAL(a, 1);
+    BOOST_CHECK_EQUAL(b, 2);
+    BOOST_CHECK_EQUAL(c, 0x0300);
+    BOOST_CHECK_EQUAL(reader.size(), 3U);
+
+    // Reading past the end throws and leaves the reader where it was
+    uint32_t d;
+    BOOST_CHECK_THROW(reader >> d, std::ios_base::failure);
+    BOOST_CHECK_EQUAL(reader.size(), 3U);
+    reader.ignore(2);
+    reader >> a;
+    BOOST_CHECK_EQUAL(a, 6);
+    BOOST_CHECK(reader.empty());
+}
+
 BOOST_AUTO_TEST_CASE(streams_serializedata_xor)
 {
     std::vector<char> in;
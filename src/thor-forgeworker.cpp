@@ -0,0 +1,386 @@
+// Copyright (c) 2018 The Thor Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
+#include <arith_uint256.h>
+#include <chainparamsbase.h>
+#include <clientversion.h>
+#include <fs.h>
+#include <hammerhash.h>
+#include <rpc/client.h>
+#include <rpc/protocol.h>
+#include <uint256.h>
+#include <util.h>
+#include <utilstrencodings.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+
+#include <event2/buffer.h>
+#include <event2/keyvalq_struct.h>
+#include <support/events.h>
+
+#include <univalue.h>
+
+// Thor: Forge: Remote hammer check worker.
+//
+// Long polls a node running with -forgework for the hammers to check (getforgework), sweeps its
+// share of them on all cores, and hands any hammer meeting the target back (submitforgesolution);
+// the node signs the proof and mints the block. The node checks its own slot of the split and publishes
+// the remaining chunks, which several hosts can split with -workercount/-workerindex. A sweep is dropped as soon as the long poll reports that the work
+// changed, ie the tip moved or another worker solved it.
+
+static const char DEFAULT_RPCCONNECT[] = "127.0.0.1";
+static const int DEFAULT_HTTP_CLIENT_TIMEOUT = 900;
+static const int CONTINUE_EXECUTION = -1;
+
+static std::string HelpMessageForgeWorker()
+{
+    const auto defaultBaseParams = CreateBaseChainParams(CBaseChainParams::MAIN);
+    const auto testnetBaseParams = CreateBaseChainParams(CBaseChainParams::TESTNET);
+    std::string strUsage;
+    strUsage += HelpMessageGroup(_("Options:"));
+    strUsage += HelpMessageOpt("-?", _("This help message"));
+    strUsage += HelpMessageOpt("-conf=<file>", strprintf(_("Specify configuration file (default: %s)"), BITCOIN_CONF_FILENAME));
+    strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory"));
+    AppendParamsHelpMessages(strUsage);
+    strUsage += HelpMessageOpt("-rpcconnect=<ip>", strprintf(_("Get work from node running on <ip> (default: %s)"), DEFAULT_RPCCONNECT));
+    strUsage += HelpMessageOpt("-rpcport=<port>", strprintf(_("Connect to JSON-RPC on <port> (default: %u or testnet: %u)"), defaultBaseParams->RPCPort(), testnetBaseParams->RPCPort()));
+    strUsage += HelpMessageOpt("-rpcuser=<user>", _("Username for JSON-RPC connections"));
+    strUsage += HelpMessageOpt("-rpcpassword=<pw>", _("Password for JSON-RPC connections"));
+    strUsage += HelpMessageOpt("-rpcclienttimeout=<n>", strprintf(_("Timeout in seconds during HTTP requests, or 0 for no timeout. (default: %d)"), DEFAULT_HTTP_CLIENT_TIMEOUT));
+    strUsage += HelpMessageOpt("-threads=<n>", _("Number of threads to check hammers with (default: all cores)"));
+    strUsage += HelpMessageOpt("-workercount=<n>", _("Number of workers sharing the node's published hammers, as set by its -forgeworkers (default: 1)"));
+    strUsage += HelpMessageOpt("-workerindex=<n>", _("Index of this worker among them, from 0 (default: 0)"));
+
+    return strUsage;
+}
+
+//
+// Exception thrown on connection error; the worker waits and retries.
+//
+class CConnectionFailed : public std::runtime_error
+{
+public:
+
+    explicit inline CConnectionFailed(const std::string& msg) :
+        std::runtime_error(msg)
+    {}
+
+};
+
+static int AppInitForgeWorker(int argc, char* argv[])
+{
+    gArgs.ParseParameters(argc, argv);
+    if (gArgs.IsArgSet("-?") || gArgs.IsArgSet("-h") || gArgs.IsArgSet("-help") || gArgs.IsArgSet("-version")) {
+        std::string strUsage = strprintf(_("%s Forge worker version"), _(PACKAGE_NAME)) + " " + FormatFullVersion() + "\n";
+        if (!gArgs.IsArgSet("-version")) {
+            strUsage += "\n" + _("Usage:") + "\n" +
+                  "  thor-forgeworker [options]  " + strprintf(_("Check hammers for %s (started with -forgework)"), _(PACKAGE_NAME)) + "\n";
+
+            strUsage += "\n" + HelpMessageForgeWorker();
+        }
+
+        fprintf(stdout, "%s", strUsage.c_str());
+        return EXIT_SUCCESS;
+    }
+    if (!fs::is_directory(GetDataDir(false))) {
+        fprintf(stderr, "Error: Specified data directory \"%s\" does not exist.\n", gArgs.GetArg("-datadir", "").c_str());
+        return EXIT_FAILURE;
+    }
+    try {
+        gArgs.ReadConfigFile(gArgs.GetArg("-conf", BITCOIN_CONF_FILENAME));
+    } catch (const std::exception& e) {
+        fprintf(stderr,"Error reading configuration file: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    // Check for -testnet or -regtest parameter (BaseParams() calls are only valid after this clause)
+    try {
+        SelectBaseParams(ChainNameFromCommandLine());
+    } catch (const std::exception& e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    if (gArgs.GetArg("-workercount", 1) < 1 || gArgs.GetArg("-workerindex", 0) < 0 || gArgs.GetArg("-workerindex", 0) >= gArgs.GetArg("-workercount", 1)) {
+        fprintf(stderr, "Error: -workerindex must be between 0 and -workercount - 1\n");
+        return EXIT_FAILURE;
+    }
+    return CONTINUE_EXECUTION;
+}
+
+/** Reply structure for request_done to fill in */
+struct HTTPReply
+{
+    HTTPReply(): status(0), error(-1) {}
+
+    int status;
+    int error;
+    std::string body;
+};
+
+static void http_request_done(struct evhttp_request *req, void *ctx)
+{
+    HTTPReply *reply = static_cast<HTTPReply*>(ctx);
+
+    if (req == nullptr) {
+        reply->status = 0;
+        return;
+    }
+
+    reply->status = evhttp_request_get_response_code(req);
+
+    struct evbuffer *buf = evhttp_request_get_input_buffer(req);
+    if (buf)
+    {
+        size_t size = evbuffer_get_length(buf);
+        const char *data = (const char*)evbuffer_pullup(buf, size);
+        if (data)
+            reply->body = std::string(data, size);
+        evbuffer_drain(buf, size);
+    }
+}
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010300
+static void http_error_cb(enum evhttp_request_error err, void *ctx)
+{
+    HTTPReply *reply = static_cast<HTTPReply*>(ctx);
+    reply->error = err;
+}
+#endif
+
+/** Call a method on the node and return its result; throws on connection or RPC errors */
+static UniValue CallRPC(const std::string& strMethod, const UniValue& params)
+{
+    std::string host;
+    int port = BaseParams().RPCPort();
+    SplitHostPort(gArgs.GetArg("-rpcconnect", DEFAULT_RPCCONNECT), port, host);
+    port = gArgs.GetArg("-rpcport", port);
+
+    raii_event_base base = obtain_event_base();
+    raii_evhttp_connection evcon = obtain_evhttp_connection_base(base.get(), host, port);
+    evhttp_connection_set_timeout(evcon.get(), gArgs.GetArg("-rpcclienttimeout", DEFAULT_HTTP_CLIENT_TIMEOUT));
+
+    HTTPReply response;
+    raii_evhttp_request req = obtain_evhttp_request(http_request_done, (void*)&response);
+    if (req == nullptr)
+        throw std::runtime_error("create http request failed");
+#if LIBEVENT_VERSION_NUMBER >= 0x02010300
+    evhttp_request_set_error_cb(req.get(), http_error_cb);
+#endif
+
+    // Get credentials
+    std::string strRPCUserColonPass;
+    if (gArgs.GetArg("-rpcpassword", "") == "") {
+        if (!GetAuthCookie(&strRPCUserColonPass))
+            throw std::runtime_error("Could not locate RPC credentials. No authentication cookie could be found, and RPC password is not set.");
+    } else {
+        strRPCUserColonPass = gArgs.GetArg("-rpcuser", "") + ":" + gArgs.GetArg("-rpcpassword", "");
+    }
+
+    struct evkeyvalq* output_headers = evhttp_request_get_output_headers(req.get());
+    assert(output_headers);
+    evhttp_add_header(output_headers, "Host", host.c_str());
+    evhttp_add_header(output_headers, "Connection", "close");
+    evhttp_add_header(output_headers, "Authorization", (std::string("Basic ") + EncodeBase64(strRPCUserColonPass)).c_str());
+
+    std::string strRequest = JSONRPCRequestObj(strMethod, params, 1).write() + "\n";
+    struct evbuffer* output_buffer = evhttp_request_get_output_buffer(req.get());
+    assert(output_buffer);
+    evbuffer_add(output_buffer, strRequest.data(), strRequest.size());
+
+    int r = evhttp_make_request(evcon.get(), req.get(), EVHTTP_REQ_POST, "/");
+    req.release(); // ownership moved to evcon in above call
+    if (r != 0)
+        throw CConnectionFailed("send http request failed");
+
+    event_base_dispatch(base.get());
+
+    if (response.status == 0)
+        throw CConnectionFailed(strprintf("couldn't connect to server (code %d)", response.error));
+    else if (response.status == HTTP_UNAUTHORIZED)
+        throw std::runtime_error("incorrect rpcuser or rpcpassword (authorization failed)");
+    else if (response.status >= 400 && response.status != HTTP_BAD_REQUEST && response.status != HTTP_NOT_FOUND && response.status != HTTP_INTERNAL_SERVER_ERROR)
+        throw std::runtime_error(strprintf("server returned HTTP error %d", response.status));
+    else if (response.body.empty())
+        throw std::runtime_error("no response from server");
+
+    UniValue reply(UniValue::VSTR);
+    if (!reply.read(response.body) || !reply.isObject())
+        throw std::runtime_error("couldn't parse reply from server");
+    const UniValue& error = find_value(reply, "error");
+    if (!error.isNull()) {
+        if (find_value(error, "code").isNum() && find_value(error, "code").get_int() == RPC_IN_WARMUP)
+            throw CConnectionFailed("server in warmup");
+        throw std::runtime_error("server error: " + error.write());
+    }
+
+    return find_value(reply, "result");
+}
+
+/** A unit of work, as received from getforgework: the node's chunks of hammers */
+struct CForgeJob
+{
+    std::string workId;
+    CHammerHasher randHasher;
+    arith_uint256 hammerHashTarget;
+    std::vector<std::vector<std::pair<std::string, std::pair<int, int>>>> vChunks;  // Each a list of (txid, (offset, count))
+    std::atomic<size_t> nNextChunk;
+    std::atomic<bool> fAbort;
+
+    explicit CForgeJob(const UniValue& work) : nNextChunk(0), fAbort(false)
+    {
+        workId = find_value(work, "workid").get_str();
+        randHasher = CHammerHasher(find_value(work, "randstring").get_str());
+        hammerHashTarget = UintToArith256(uint256S(find_value(work, "target").get_str()));
+
+        // This worker's share: every workercount'th of the node's chunks, from workerindex
+        int nWorkerCount = gArgs.GetArg("-workercount", 1);
+        int nWorkerIndex = gArgs.GetArg("-workerindex", 0);
+        const std::vector<UniValue>& chunks = find_value(work, "chunks").getValues();
+        for (size_t nChunk = nWorkerIndex; nChunk < chunks.size(); nChunk += nWorkerCount) {
+            vChunks.emplace_back();
+            for (const UniValue& range : chunks[nChunk].getValues())
+                vChunks.back().emplace_back(find_value(range, "txid").get_str(), std::make_pair(find_value(range, "offset").get_int(), find_value(range, "count").get_int()));
+        }
+    }
+};
+
+static std::mutex mutexJob;
+static std::condition_variable condJob;
+static std::shared_ptr<CForgeJob> currentJob;
+
+static void SubmitSolution(const std::shared_ptr<CForgeJob>& job, const std::string& txid, uint32_t nonce)
+{
+    UniValue params(UniValue::VARR);
+    params.push_back(job->workId);
+    params.push_back(txid);
+    params.push_back((int64_t)nonce);
+    try {
+        UniValue result = CallRPC("submitforgesolution", params);
+        fprintf(stdout, "Solution hammer #%u from BCT %s for work %s: %s\n", nonce, txid.c_str(), job->workId.c_str(), result.isNull() ? "accepted" : result.get_str().c_str());
+    } catch (const std::exception& e) {
+        fprintf(stderr, "Couldn't submit solution: %s\n", e.what());
+    }
+}
+
+/** Check chunks of the current job until it runs out, is solved or is replaced */
+static void ThreadCheckHammers()
+{
+    std::shared_ptr<CForgeJob> job;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutexJob);
+            condJob.wait(lock, [&job] { return currentJob && currentJob != job; });
+            job = currentJob;
+        }
+
+        size_t nChunk;
+        while (!job->fAbort.load() && (nChunk = job->nNextChunk++) < job->vChunks.size()) {
+            for (const auto& range : job->vChunks[nChunk]) {
+                if (job->fAbort.load())
+                    break;
+                const std::string& txid = range.first;
+                int offset = range.second.first;
+                int count = range.second.second;
+                CHammerHasher bctHasher = job->randHasher.ForBCT(txid);
+                for (int i = offset; i < offset + count; i++) {
+                    if (bctHasher.CheckHash(i, job->hammerHashTarget)) {
+                        if (!job->fAbort.exchange(true))
+                            SubmitSolution(job, txid, i);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static int ForgeWorkerLoop()
+{
+    int nThreads = gArgs.GetArg("-threads", 0);
+    if (nThreads <= 0)
+        nThreads = GetNumCores();
+    for (int i = 0; i < nThreads; i++)
+        std::thread(ThreadCheckHammers).detach();
+    fprintf(stdout, "Checking hammers with %i threads (worker %i of %i)\n", nThreads, (int)gArgs.GetArg("-workerindex", 0), (int)gArgs.GetArg("-workercount", 1));
+
+    std::string workId;
+    while (true) {
+        UniValue work;
+        int64_t nStart = GetTimeMillis();
+        try {
+            UniValue params(UniValue::VARR);
+            if (!workId.empty())
+                params.push_back(workId);
+            work = CallRPC("getforgework", params);
+        } catch (const CConnectionFailed& e) {
+            fprintf(stderr, "%s; retrying\n", e.what());
+            MilliSleep(1000);
+            continue;
+        }
+        if (find_value(work, "workid").get_str() == workId) {
+            // Long poll timed out, or the node had no RPC thread to spare for one; then poll every second instead
+            if (GetTimeMillis() - nStart < 1000)
+                MilliSleep(1000);
+            continue;
+        }
+
+        // Drop whatever the threads are on, and start them on the new work
+        std::shared_ptr<CForgeJob> job = std::make_shared<CForgeJob>(work);
+        workId = job->workId;
+        {
+            std::lock_guard<std::mutex> lock(mutexJob);
+            if (currentJob)
+                currentJob->fAbort.store(true);
+            currentJob = job;
+        }
+        condJob.notify_all();
+        if (workId == "idle")
+            fprintf(stdout, "No work\n");
+        else
+            fprintf(stdout, "Work %s: %u chunks at height %i\n", workId.c_str(), (unsigned int)job->vChunks.size(), find_value(work, "height").get_int());
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    SetupEnvironment();
+    setvbuf(stdout, nullptr, _IOLBF, 0);    // Progress lines should show up promptly when logged to a file
+    if (!SetupNetworking()) {
+        fprintf(stderr, "Error: Initializing networking failed\n");
+        return EXIT_FAILURE;
+    }
+
+    try {
+        int ret = AppInitForgeWorker(argc, argv);
+        if (ret != CONTINUE_EXECUTION)
+            return ret;
+    }
+    catch (const std::exception& e) {
+        PrintExceptionContinue(&e, "AppInitForgeWorker()");
+        return EXIT_FAILURE;
+    } catch (...) {
+        PrintExceptionContinue(nullptr, "AppInitForgeWorker()");
+        return EXIT_FAILURE;
+    }
+
+    int ret = EXIT_FAILURE;
+    try {
+        ret = ForgeWorkerLoop();
+    }
+    catch (const std::exception& e) {
+        PrintExceptionContinue(&e, "ForgeWorkerLoop()");
+    } catch (...) {
+        PrintExceptionContinue(nullptr, "ForgeWorkerLoop()");
+    }
+    return ret;
+}
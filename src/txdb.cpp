@@ -7,6 +7,7 @@
 
 #include <chainparams.h>
 #include <hash.h>
+#include <hammerpopindex.h>
 #include <random.h>
 #include <pow.h>
 #include <uint256.h>
@@ -29,6 +30,7 @@ static const char DB_HEAD_BLOCKS = 'H';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
+static const char DB_HAMMER_POP = 'h';  // Thor: Forge
 
 namespace {
 
@@ -259,6 +261,15 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+// Thor: Forge: Hammer population index entries, keyed by block hash
+bool CBlockTreeDB::ReadHammerPop(const uint256 &hash, CHammerPopEntry &entry) {
+    return Read(std::make_pair(DB_HAMMER_POP, hash), entry);
+}
+
+bool CBlockTreeDB::WriteHammerPop(const uint256 &hash, const CHammerPopEntry &entry) {
+    return Write(std::make_pair(DB_HAMMER_POP, hash), entry);
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
 {
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
@@ -292,7 +303,8 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 // CheckProofOfWork() uses the scrypt hash which is discarded after a block is accepted.
                 // While it is technically feasible to verify the PoW, doing so takes several minutes as it
                 // requires recomputing every PoW hash during every Thor startup.
-                // We opt instead to simply trust the data that is on your local disk.
+                // We opt instead to simply trust the data that is on your local disk here, and let
+                // ThreadVerifyIndexPoW re-check entries not yet marked BLOCK_POW_VERIFIED after startup.
                 //if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, consensusParams))
                 //    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
 
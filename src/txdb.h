@@ -17,6 +17,7 @@
 
 class CBlockIndex;
 class CCoinsViewDBCursor;
+struct CHammerPopEntry;
 class uint256;
 
 //! No need to periodic flush if at least this much space still available.
@@ -123,6 +124,8 @@ public:
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &vect);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    bool ReadHammerPop(const uint256 &hash, CHammerPopEntry &entry);        // Thor: Forge
+    bool WriteHammerPop(const uint256 &hash, const CHammerPopEntry &entry); // Thor: Forge
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
 };
 
@@ -644,6 +644,7 @@ public:
 
     boost::signals2::signal<void (CTransactionRef)> NotifyEntryAdded;
     boost::signals2::signal<void (CTransactionRef, MemPoolRemovalReason)> NotifyEntryRemoved;
+    boost::signals2::signal<void (const uint256&)> NotifyFeeDeltaChanged;   // Thor: Incremental templates
 
 private:
     /** UpdateForDescendants is used by UpdateTransactionsFromBlock to update
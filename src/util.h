@@ -104,6 +104,7 @@ namespace BCLog {
         QT          = (1 << 19),
         LEVELDB     = (1 << 20),
         FORGE        = (1 << 21),    // Thor: Forge logging
+        LOCK        = (1 << 22),    // Thor: Lock contention
         ALL         = ~(uint32_t)0,
     };
 }
@@ -312,6 +313,15 @@ int GetNumVirtualCores();
 
 void RenameThread(const char* name);
 
+/**
+ * On platforms that support it, tell the kernel the calling thread is
+ * CPU-intensive and non-interactive. See SCHED_BATCH in sched(7) for details.
+ *
+ * @return The return value of pthread_setschedparam(), or 1 on systems
+ * without SCHED_BATCH.
+ */
+int ScheduleBatchPriority(void);
+
 /**
  * .. and a wrapper that just calls func once
  */
@@ -14,6 +14,7 @@
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <crypto/scrypt.h>
 #include <cuckoocache.h>
 #include <hash.h>
 #include <init.h>
@@ -48,6 +49,9 @@
 #include <boost/thread.hpp>
 
 #include <miner.h>  // Thor: Forge
+#include <hammerhash.h> // Thor: Forge
+#include <hammerpopindex.h> // Thor: Forge
+#include <bctindex.h> // Thor: Forge
 #include <merkleblock.h> // Thor: Forge for merkle transaction check in block
 
 #if defined(NDEBUG)
@@ -157,7 +161,7 @@ public:
 
     bool ActivateBestChain(CValidationState &state, const CChainParams& chainparams, std::shared_ptr<const CBlock> pblock);
 
-    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex);
+    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW = true);
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock);
 
     // Block (dis)connection on a given view:
@@ -217,6 +221,7 @@ bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
 bool fCheckBlockIndex = false;
 bool fCheckpointsEnabled = DEFAULT_CHECKPOINTS_ENABLED;
+bool fVerifyBlockReads = DEFAULT_VERIFY_BLOCK_READS;
 size_t nCoinCacheUsage = 5000 * 300;
 uint64_t nPruneTarget = 0;
 int64_t nMaxTipAge = DEFAULT_MAX_TIP_AGE;
@@ -1090,7 +1095,31 @@ static bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMes
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
+// Thor: Forge: Block read proof-check counters
+static std::atomic<uint64_t> nBlockReadPoWVerified(0);
+static std::atomic<uint64_t> nBlockReadPoWTrusted(0);
+static std::atomic<int64_t> nBlockReadPoWVerifyMicros(0);
+static std::atomic<uint64_t> nBlockReadForgeVerified(0);
+static std::atomic<uint64_t> nBlockReadForgeTrusted(0);
+static std::atomic<int64_t> nBlockReadForgeVerifyMicros(0);
+static std::atomic<uint64_t> nBlockReadRaw(0);
+static std::atomic<uint64_t> nBlockReadRawBytes(0);
+
+BlockReadStats GetBlockReadStats()
+{
+    BlockReadStats stats;
+    stats.nPoWVerified = nBlockReadPoWVerified;
+    stats.nPoWTrusted = nBlockReadPoWTrusted;
+    stats.nPoWVerifyMicros = nBlockReadPoWVerifyMicros;
+    stats.nForgeVerified = nBlockReadForgeVerified;
+    stats.nForgeTrusted = nBlockReadForgeTrusted;
+    stats.nForgeVerifyMicros = nBlockReadForgeVerifyMicros;
+    stats.nRawReads = nBlockReadRaw;
+    stats.nRawBytes = nBlockReadRawBytes;
+    return stats;
+}
+
+static bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams, bool fCheckProof)
 {
     block.SetNull();
 
@@ -1108,26 +1137,51 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
     }
 
     // Thor: Forge: Check PoW or Forge work depending on blocktype
-    if (block.IsForgeMined(consensusParams)) {
-        if (!CheckForgeProof(&block, consensusParams))
+    bool fForge = block.IsForgeMined(consensusParams);
+    if (!fCheckProof) {
+        if (fForge)
+            nBlockReadForgeTrusted++;
+        else
+            nBlockReadPoWTrusted++;
+        return true;
+    }
+
+    int64_t nTimeStart = GetTimeMicros();
+    if (fForge) {
+        bool fValid = CheckForgeProof(&block, consensusParams);
+        nBlockReadForgeVerifyMicros += GetTimeMicros() - nTimeStart;
+        nBlockReadForgeVerified++;
+        if (!fValid)
             return error("ReadBlockFromDisk: Errors in Forge block header at %s", pos.ToString());
     } else {
-        if (!CheckProofOfWork(block.GetPoWHash(), block.nBits, consensusParams))
+        bool fValid = CheckProofOfWork(block.GetPoWHash(), block.nBits, consensusParams);
+        nBlockReadPoWVerifyMicros += GetTimeMicros() - nTimeStart;
+        nBlockReadPoWVerified++;
+        if (!fValid)
             return error("ReadBlockFromDisk: Errors in PoW block header at %s", pos.ToString());
     }
 
     return true;
 }
 
+bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams)
+{
+    return ReadBlockFromDisk(block, pos, consensusParams, true);
+}
+
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
     CDiskBlockPos blockPos;
+    bool fCheckProof;
     {
         LOCK(cs_main);
         blockPos = pindex->GetBlockPos();
+        // Thor: Forge: Blocks which passed full validation had their proofs checked on the way in; matching
+        // the hash below against the index is enough to know we read back the same block
+        fCheckProof = fVerifyBlockReads || !pindex->IsValid(BLOCK_VALID_SCRIPTS);
     }
 
-    if (!ReadBlockFromDisk(block, blockPos, consensusParams))
+    if (!ReadBlockFromDisk(block, blockPos, consensusParams, fCheckProof))
         return false;
     if (block.GetHash() != pindex->GetBlockHash())
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
@@ -1135,75 +1189,181 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
     return true;
 }
 
-CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
+bool ReadRawBlockFromDisk(std::vector<unsigned char>& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& messageStart)
 {
-    // LitecoinCash: Issue premine on 1st post-fork block
-   /* if (nHeight == consensusParams.lastScryptBlock + 1)
-        return consensusParams.premineAmount * COIN * COIN_SCALE;*/
-
-    int halvings = nHeight / consensusParams.nSubsidyHalvingInterval;
-    // LitecoinCash: Force block reward to zero when right shift is undefined, and don't attempt to issue past total money supply
-    if (halvings >= 64 || nHeight >= consensusParams.totalMoneySupplyHeight)
-        return 0;
+    CDiskBlockPos hpos;
+    {
+        LOCK(cs_main);
+        hpos = pindex->GetBlockPos();
+    }
+    // The block is stored behind the message start and its size, as WriteBlockToDisk wrote them
+    if (hpos.nPos < CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int))
+        return error("ReadRawBlockFromDisk: Invalid block position %s", hpos.ToString());
+    hpos.nPos -= CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int);
 
-    if (nHeight == 1)
-        return 500000 * COIN * COIN_SCALE;
-    if (nHeight == 2)
-        return 500000 * COIN * COIN_SCALE;
-    if (nHeight == 3)
-	return 500000 * COIN * COIN_SCALE;
-    if (nHeight == 4)
-	return 500000 * COIN * COIN_SCALE;
+    CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("ReadRawBlockFromDisk: OpenBlockFile failed for %s", hpos.ToString());
 
-    CAmount nSubsidy = 5 * COIN * COIN_SCALE;
-    // Subsidy is cut in half every 210,000 blocks which will occur approximately every 4 years.
-    nSubsidy >>= halvings;
+    try {
+        CMessageHeader::MessageStartChars blockStart;
+        unsigned int nSize;
+        filein >> FLATDATA(blockStart) >> nSize;
+        if (memcmp(blockStart, messageStart, CMessageHeader::MESSAGE_START_SIZE))
+            return error("ReadRawBlockFromDisk: Block magic mismatch at %s", hpos.ToString());
+        if (nSize > MAX_BLOCK_SERIALIZED_SIZE)
+            return error("ReadRawBlockFromDisk: Block size %u too large at %s", nSize, hpos.ToString());
+        block.resize(nSize);
+        filein.read((char*)block.data(), nSize);
+    }
+    catch (const std::exception& e) {
+        return error("%s: Read error - %s at %s", __func__, e.what(), hpos.ToString());
+    }
 
-    // Thor: Slow-start the first n blocks  blocks to prevent early miners having an unfair advantage
-    int64_t blocksSinceFork = nHeight - consensusParams.lastScryptBlock;
-    if (blocksSinceFork > 0 && blocksSinceFork < consensusParams.slowStartBlocks) {
-        CAmount incrementPerBlock = nSubsidy / consensusParams.slowStartBlocks;
-        nSubsidy = blocksSinceFork * incrementPerBlock;
+    // Make sure it's the block we were asked for, as ReadBlockFromDisk does with the whole block
+    CBlockHeader header;
+    try {
+        CSpanReader(SER_DISK, CLIENT_VERSION, (const char*)block.data(), (const char*)block.data() + block.size()) >> header;
     }
+    catch (const std::exception& e) {
+        return error("%s: Deserialize error - %s at %s", __func__, e.what(), hpos.ToString());
+    }
+    if (header.GetHash() != pindex->GetBlockHash())
+        return error("ReadRawBlockFromDisk: GetHash() doesn't match index for %s at %s", pindex->ToString(), hpos.ToString());
 
-    return nSubsidy;
+    nBlockReadRaw++;
+    nBlockReadRawBytes += block.size();
+    return true;
 }
 
-// Thor: Forge: Return the current cost for a single worker hammer
-CAmount GetHammerCost(int nHeight, const Consensus::Params& consensusParams)
+bool StripBlockWitness(const std::vector<unsigned char>& block, std::vector<unsigned char>& stripped)
 {
-    if(nHeight >= consensusParams.totalMoneySupplyHeight)
-        return consensusParams.minHammerCost;
-
-    CAmount blockReward = GetBlockSubsidy(nHeight, consensusParams);
-    CAmount hammerCost = blockReward / consensusParams.hammerCostFactor;
-    return hammerCost <= consensusParams.minHammerCost ? consensusParams.minHammerCost : hammerCost;
+    // Walk the serialization the way UnserializeTransaction does, copying all but the witness
+    // marker, flag and stacks
+    const char* pbegin = (const char*)block.data();
+    CSpanReader s(SER_NETWORK, PROTOCOL_VERSION, pbegin, pbegin + block.size());
+    stripped.clear();
+    stripped.reserve(block.size());
+    auto copyFrom = [&](const char* pch) {
+        stripped.insert(stripped.end(), (const unsigned char*)pch, (const unsigned char*)s.data());
+    };
+    try {
+        CBlockHeader header;
+        s >> header;
+        uint64_t nTx = ReadCompactSize(s);
+        copyFrom(pbegin);
+        for (uint64_t i = 0; i < nTx; i++) {
+            const char* pchTx = s.data();
+            s.ignore(4);            // nVersion
+            const char* pchIns = s.data();
+            uint64_t nIn = ReadCompactSize(s);
+            bool fWitness = false;
+            if (nIn == 0) {
+                // The witness marker; blocks that passed validation have no other use for an empty vin
+                unsigned char flags;
+                s >> flags;
+                if (flags != 1)
+                    return false;
+                fWitness = true;
+                pchIns = s.data();
+                nIn = ReadCompactSize(s);
+            }
+            for (uint64_t j = 0; j < nIn; j++) {
+                s.ignore(sizeof(uint256) + 4);      // prevout
+                s.ignore(ReadCompactSize(s));       // scriptSig
+                s.ignore(4);                        // nSequence
+            }
+            uint64_t nOut = ReadCompactSize(s);
+            for (uint64_t j = 0; j < nOut; j++) {
+                s.ignore(8);                        // nValue
+                s.ignore(ReadCompactSize(s));       // scriptPubKey
+            }
+            if (!fWitness) {
+                s.ignore(4);        // nLockTime
+                copyFrom(pchTx);
+                continue;
+            }
+            stripped.insert(stripped.end(), (const unsigned char*)pchTx, (const unsigned char*)pchTx + 4);
+            copyFrom(pchIns);
+            for (uint64_t j = 0; j < nIn; j++) {
+                uint64_t nItems = ReadCompactSize(s);
+                for (uint64_t k = 0; k < nItems; k++)
+                    s.ignore(ReadCompactSize(s));
+            }
+            const char* pchLockTime = s.data();
+            s.ignore(4);
+            copyFrom(pchLockTime);
+        }
+    }
+    catch (const std::ios_base::failure&) {
+        return false;
+    }
+    return s.empty();
 }
 
 bool IsInitialBlockDownload()
 {
     // Once this function has returned false, it must remain false.
     static std::atomic<bool> latchToFalse{false};
-    // Optimization: pre-test latch before taking the lock.
     if (latchToFalse.load(std::memory_order_relaxed))
         return false;
 
-    LOCK(cs_main);
-    if (latchToFalse.load(std::memory_order_relaxed))
-        return false;
+    // Thor: Read the published tip rather than taking cs_main
     if (fImporting || fReindex)
         return true;
-    if (chainActive.Tip() == nullptr)
+    CTipSnapshotRef tip = GetTipSnapshot();
+    if (!tip)
         return true;
-    if (chainActive.Tip()->nChainWork < nMinimumChainWork)
+    if (tip->nChainWork < nMinimumChainWork)
         return true;
-    if (chainActive.Tip()->GetBlockTime() < (GetTime() - nMaxTipAge))
+    if (tip->nTime < (GetTime() - nMaxTipAge))
         return true;
-    LogPrintf("Leaving InitialBlockDownload (latching to false)\n");
-    latchToFalse.store(true, std::memory_order_relaxed);
+    if (!latchToFalse.exchange(true, std::memory_order_relaxed))
+        LogPrintf("Leaving InitialBlockDownload (latching to false)\n");
     return false;
 }
 
+// Thor: Swapped whole with std::atomic_load/atomic_store, so readers never see a half-written tip
+static CTipSnapshotRef tipSnapshot;
+
+CTipSnapshotRef GetTipSnapshot()
+{
+    return std::atomic_load(&tipSnapshot);
+}
+
+void PublishTipSnapshot()
+{
+    AssertLockHeld(cs_main);
+
+    std::shared_ptr<CTipSnapshot> snapshot;
+    const CBlockIndex* pindex = chainActive.Tip();
+    if (pindex) {
+        snapshot = std::make_shared<CTipSnapshot>();
+        snapshot->pindex = pindex;
+        snapshot->nHeight = pindex->nHeight;
+        snapshot->hashBlock = pindex->GetBlockHash();
+        snapshot->nTime = pindex->GetBlockTime();
+        snapshot->nMedianTimePast = pindex->GetMedianTimePast();
+        snapshot->nChainWork = pindex->nChainWork;
+    }
+
+    // Publish under csBestBlock so a waiter can't miss the change between checking and waiting
+    {
+        WaitableLock lock(csBestBlock);
+        std::atomic_store(&tipSnapshot, CTipSnapshotRef(snapshot));
+    }
+    cvBlockChange.notify_all();
+}
+
+CTipSnapshotRef WaitForTipChange(const uint256& hashTip, const std::chrono::steady_clock::time_point& deadline)
+{
+    WaitableLock lock(csBestBlock);
+    CTipSnapshotRef tip = GetTipSnapshot();
+    if (!tip || tip->hashBlock == hashTip)
+        cvBlockChange.wait_until(lock, deadline);
+    return GetTipSnapshot();
+}
+
 CBlockIndex *pindexBestForkTip = nullptr, *pindexBestForkBase = nullptr;
 
 static void AlertNotify(const std::string& strMessage)
@@ -1638,6 +1798,8 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
+    hammerPopIndex.BlockDisconnected(pindex);   // Thor: Forge
+
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
@@ -1705,6 +1867,16 @@ static bool WriteTxIndexDataForBlock(const CBlock& block, CValidationState& stat
     return true;
 }
 
+// Thor: Forge: Record the hammers created by this block in the hammer population index
+static bool WriteHammerPopDataForBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex, const Consensus::Params& consensusParams)
+{
+    if (!hammerPopIndex.BlockConnected(block, pindex, consensusParams)) {
+        return AbortNode(state, "Failed to write hammer population index");
+    }
+
+    return true;
+}
+
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
 void ThreadScriptCheck() {
@@ -2036,6 +2208,9 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     if (!WriteTxIndexDataForBlock(block, state, pindex))
         return false;
 
+    if (!WriteHammerPopDataForBlock(block, state, pindex, chainparams.GetConsensus()))
+        return false;
+
     assert(pindex->phashBlock);
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
@@ -2191,7 +2366,7 @@ void static UpdateTip(const CBlockIndex *pindexNew, const CChainParams& chainPar
     // New best block
     mempool.AddTransactionsUpdated(1);
 
-    cvBlockChange.notify_all();
+    PublishTipSnapshot();   // Thor: Also wakes cvBlockChange
 
     std::vector<std::string> warningMessages;
     if (!IsInitialBlockDownload())
@@ -2215,7 +2390,7 @@ void static UpdateTip(const CBlockIndex *pindexNew, const CChainParams& chainPar
         {
             int32_t nExpectedVersion = ComputeBlockVersion(pindex->pprev, chainParams.GetConsensus());
             // Thor: Forge: Don't warn about unexpected version in Forgemined blocks
-            if (pindex->nVersion > VERSIONBITS_LAST_OLD_BLOCK_VERSION && (pindex->nVersion & ~nExpectedVersion) != 0 && !pindex->GetBlockHeader().IsForgeMined(chainParams.GetConsensus()))
+            if (pindex->nVersion > VERSIONBITS_LAST_OLD_BLOCK_VERSION && (pindex->nVersion & ~nExpectedVersion) != 0 && !pindex->IsForgeMined(chainParams.GetConsensus()))
                 ++nUpgraded;
             pindex = pindex->pprev;
         }
@@ -2849,6 +3024,7 @@ CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block)
         pindexNew->nHeight = pindexNew->pprev->nHeight + 1;
         pindexNew->BuildSkip();
     }
+    pindexNew->BuildForgeCounters(Params().GetConsensus());   // Thor: Forge
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + GetBlockProof(*pindexNew);
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
@@ -3034,8 +3210,8 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
     if (!CheckBlockHeader(block, state, consensusParams, fCheckPOW))
         return false;
 
-    // Thor: Forge: Check Forge proof
-    if (block.IsForgeMined(consensusParams))
+    // Thor: Forge: Check Forge proof; it stands in for the PoW, so fCheckPOW covers it too
+    if (fCheckPOW && block.IsForgeMined(consensusParams))
         if (!CheckForgeProof(&block, consensusParams))
             return state.DoS(100, false, REJECT_INVALID, "bad-forge-proof", false, "proof of forge failed");
 
@@ -3096,25 +3272,52 @@ bool IsWitnessEnabled(const CBlockIndex* pindexPrev, const Consensus::Params& pa
     return (VersionBitsState(pindexPrev, params, Consensus::DEPLOYMENT_SEGWIT, versionbitscache) == THRESHOLD_ACTIVE);
 }
 
+// Thor: Forge: Activation height of each Forge deployment once its state is final on the active
+// chain (INT_MAX if it failed); 0 while still pending. Read without cs_main.
+static std::atomic<int> nForgeDeploymentHeight[Consensus::MAX_VERSION_BITS_DEPLOYMENTS];
+
+// Thor: Forge: Check if a Forge deployment is active for the block after pindexPrev. Once the state
+// a deployment settled in is buried a full confirmation window deep in the active chain, a reorg
+// cannot realistically undo it, so its activation height is cached and the query becomes a height
+// comparison. Until then it goes through the versionbits cache under cs_main.
+static bool IsForgeDeploymentActive(const CBlockIndex* pindexPrev, const Consensus::Params& params, Consensus::DeploymentPos pos)
+{
+    if (params.vDeployments[pos].nStartTime == Consensus::BIP9Deployment::ALWAYS_ACTIVE)
+        return true;
+
+    int nFinalHeight = nForgeDeploymentHeight[pos].load(std::memory_order_relaxed);
+    if (nFinalHeight != 0)
+        return (pindexPrev ? pindexPrev->nHeight + 1 : 0) >= nFinalHeight;
+
+    LOCK(cs_main);
+    ThresholdState state = VersionBitsState(pindexPrev, params, pos, versionbitscache);
+    if ((state == THRESHOLD_ACTIVE || state == THRESHOLD_FAILED) && pindexPrev && chainActive.Contains(pindexPrev)) {
+        int nSinceHeight = VersionBitsStateSinceHeight(pindexPrev, params, pos, versionbitscache);
+        if (nSinceHeight > 0 && pindexPrev->nHeight + 1 - nSinceHeight >= (int)params.nMinerConfirmationWindow) {
+            nFinalHeight = state == THRESHOLD_ACTIVE ? nSinceHeight : std::numeric_limits<int>::max();
+            nForgeDeploymentHeight[pos].store(nFinalHeight, std::memory_order_relaxed);
+            LogPrint(BCLog::FORGE, "%s: deployment %d is final from height %d (%s)\n", __func__, pos, nSinceHeight, state == THRESHOLD_ACTIVE ? "active" : "failed");
+        }
+    }
+    return state == THRESHOLD_ACTIVE;
+}
+
 // Thor: Forge: Check if Forge is activated at given point
 bool IsForgeEnabled(const CBlockIndex* pindexPrev, const Consensus::Params& params)
 {
-    LOCK(cs_main);
-    return (VersionBitsState(pindexPrev, params, Consensus::DEPLOYMENT_FORGE, versionbitscache) == THRESHOLD_ACTIVE);
+    return IsForgeDeploymentActive(pindexPrev, params, Consensus::DEPLOYMENT_FORGE);
 }
 
 // Thor: Forge: Check if Forge 1.1 is activated at given point
 bool IsForge11Enabled(const CBlockIndex* pindexPrev, const Consensus::Params& params)
 {
-    LOCK(cs_main);
-    return (VersionBitsState(pindexPrev, params, Consensus::DEPLOYMENT_FORGE_1_1, versionbitscache) == THRESHOLD_ACTIVE);
+    return IsForgeDeploymentActive(pindexPrev, params, Consensus::DEPLOYMENT_FORGE_1_1);
 }
 
 // Thor: Forge: Check if Forge 1.2 is activated at given point
 bool IsForge12Enabled(const CBlockIndex* pindexPrev, const Consensus::Params& params)
 {
-    LOCK(cs_main);
-    return (VersionBitsState(pindexPrev, params, Consensus::DEPLOYMENT_FORGE_1_2, versionbitscache) == THRESHOLD_ACTIVE);
+    return IsForgeDeploymentActive(pindexPrev, params, Consensus::DEPLOYMENT_FORGE_1_2);
 }
 
 // Thor: Forge: Check if Hive 1.3 is activated at given point
@@ -3124,26 +3327,43 @@ bool IsForge13Enabled(int nHeight)
 }
 
 // Thor: Forge: Get the well-rooted deterministic random string (see whitepaper section 4.1)
-std::string GetDeterministicRandString(const CBlockIndex* pindexPrev) {
-    //LOCK(cs_main);  // Lock maybe not needed
-
-    std::string deterministicRandString = "";
-    int heights[] = { 0, 13, 173, 471, 1363, 12103 };
-    int hits = 0, steps = 0;
-    while (hits < 6) {
-        if (steps == heights[hits]) {
-            assert(pindexPrev->phashBlock);
-            deterministicRandString += pindexPrev->phashBlock->GetHex();
-            hits++;
+CDeterministicRand GetDeterministicRand(const CBlockIndex* pindexPrev)
+{
+    // The rand only depends on pindexPrev's ancestry, so cached entries never go stale. A
+    // handful covers the tip being checked, mined on and read back while the chain moves.
+    static CCriticalSection cs_randCache;
+    static std::pair<uint256, CDeterministicRand> randCache[8];
+    static unsigned int nRandCacheNext = 0;
+
+    assert(pindexPrev->phashBlock);
+    const uint256& hashPrev = *pindexPrev->phashBlock;
+    {
+        LOCK(cs_randCache);
+        for (const auto& entry : randCache) {
+            if (entry.second.nHashes > 0 && entry.first == hashPrev)
+                return entry.second;
         }
+    }
 
-        if (!pindexPrev->pprev)
+    // Walk the skip list to each ancestor instead of stepping through pprev
+    static const int heights[CDeterministicRand::MAX_HASHES] = { 0, 13, 173, 471, 1363, 12103 };
+    CDeterministicRand rand;
+    for (int step : heights) {
+        if (step > pindexPrev->nHeight)
             break;
-
-        pindexPrev = pindexPrev->pprev;
-        steps++;
+        const CBlockIndex* pindex = pindexPrev->GetAncestor(pindexPrev->nHeight - step);
+        assert(pindex->phashBlock);
+        rand.hashes[rand.nHashes++] = *pindex->phashBlock;
     }
-    return deterministicRandString;
+
+    LOCK(cs_randCache);
+    randCache[nRandCacheNext++ % 8] = std::make_pair(hashPrev, rand);
+    return rand;
+}
+
+std::string GetDeterministicRandString(const CBlockIndex* pindexPrev)
+{
+    return GetDeterministicRand(pindexPrev).ToString();
 }
 
 // Thor: Forge: Get tx by given hash, from a block at given chain height
@@ -3381,7 +3601,7 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     return true;
 }
 
-bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -3400,7 +3620,7 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), fCheckPOW))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -3429,8 +3649,12 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             }
         }
     }
-    if (pindex == nullptr)
+    if (pindex == nullptr) {
         pindex = AddToBlockIndex(block);
+        // Thor: CheckBlockHeader (or PrecheckHeadersPoW) has just checked the scrypt PoW
+        if (pindex->nHeight >= SKIP_BLOCKHEADER_POW && !block.IsForgeMined(chainparams.GetConsensus()))
+            pindex->nStatus |= BLOCK_POW_VERIFIED;
+    }
 
     if (ppindex)
         *ppindex = pindex;
@@ -3440,15 +3664,127 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
     return true;
 }
 
+/**
+ * Thor: Scrypt-hash a run of linked headers several at a time with the multi-lane kernels.
+ * Writes whether each header meets its target; returns false at the first chunk that has a
+ * failure, which stops the rest of the headers message from being hashed.
+ */
+class CHeaderPoWCheck
+{
+private:
+    std::vector<const CBlockHeader*> chunk;
+    const Consensus::Params* pconsensusParams;
+    char* pfValid;          // One flag per header in chunk; each check writes only its own
+
+public:
+    CHeaderPoWCheck() : pconsensusParams(nullptr), pfValid(nullptr) {}
+    CHeaderPoWCheck(std::vector<const CBlockHeader*>&& chunkIn, const Consensus::Params& consensusParams, char* pfValidIn) :
+        chunk(std::move(chunkIn)), pconsensusParams(&consensusParams), pfValid(pfValidIn) {}
+
+    bool operator()() {
+        std::vector<uint256> vHashes;
+        GetPoWHashes(chunk, vHashes);
+        bool fAllValid = true;
+        for (size_t i = 0; i < chunk.size(); i++) {
+            pfValid[i] = CheckProofOfWork(vHashes[i], chunk[i]->nBits, *pconsensusParams);
+            fAllValid &= (bool)pfValid[i];
+        }
+        return fAllValid;
+    }
+
+    void swap(CHeaderPoWCheck& check) {
+        chunk.swap(check.chunk);
+        std::swap(pconsensusParams, check.pconsensusParams);
+        std::swap(pfValid, check.pfValid);
+    }
+};
+
+// Thor: Workers for PrecheckHeadersPoW, one chunk at a time so a failure stops the others quickly
+static CCheckQueue<CHeaderPoWCheck> headerpowcheckqueue(1);
+
+void ThreadHeaderPoWCheck() {
+    RenameThread("thor-headerpow");
+    headerpowcheckqueue.Thread();
+}
+
+/**
+ * Thor: Scrypt-hash the PoW of a headers message before it is accepted, outside cs_main,
+ * spread over the header PoW check workers and hashed several headers at a time by the
+ * multi-lane scrypt kernels. vPoWValid[i] is set when header i is known to meet its target;
+ * headers below SKIP_BLOCKHEADER_POW, Forge headers, failures, headers after a failing chunk
+ * and anything not chained to a known block are left to CheckBlockHeader. Headers already in
+ * mapBlockIndex are skipped.
+ *
+ * The first header is hashed on its own and the batch is only started when it passes, so a
+ * message of bad headers costs one hash before the peer is penalised, as it did before.
+ */
+static void PrecheckHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, std::vector<bool>& vPoWValid)
+{
+    vPoWValid.assign(headers.size(), false);
+    if (headers.size() < 2)
+        return;
+
+    // Headers we already have are accepted by AcceptBlockHeader without a PoW check, so don't hash them here either
+    std::vector<const CBlockHeader*> vHeaders;
+    {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(headers[0].hashPrevBlock);
+        if (mi == mapBlockIndex.end())
+            return;
+        int nHeight = mi->second->nHeight + 1;
+
+        uint256 hashPrev = headers[0].hashPrevBlock;
+        for (size_t i = 0; i < headers.size(); i++, nHeight++) {
+            if (headers[i].hashPrevBlock != hashPrev)
+                break;
+            hashPrev = headers[i].GetHash();
+            if (nHeight >= SKIP_BLOCKHEADER_POW && !headers[i].IsForgeMined(consensusParams) && !mapBlockIndex.count(hashPrev))
+                vHeaders.push_back(&headers[i]);
+        }
+    }
+    if (vHeaders.empty())
+        return;
+
+    // Check the first one alone; a failure here leaves CheckBlockHeader to reject it
+    std::vector<char> vValid(vHeaders.size(), false);
+    CHeaderPoWCheck(std::vector<const CBlockHeader*>(1, vHeaders[0]), consensusParams, &vValid[0])();
+    if (vValid[0]) {
+        // The queue hands out its most recently added check first, so add the chunks back to front
+        const size_t nLanes = scrypt_multi_lanes();
+        std::vector<CHeaderPoWCheck> vChecks;
+        for (size_t nEnd = vHeaders.size(); nEnd > 1; ) {
+            size_t nBegin = std::max<size_t>(1, nEnd >= nLanes ? nEnd - nLanes : 0);
+            vChecks.emplace_back(std::vector<const CBlockHeader*>(vHeaders.begin() + nBegin, vHeaders.begin() + nEnd), consensusParams, &vValid[nBegin]);
+            nEnd = nBegin;
+        }
+
+        if (nScriptCheckThreads) {
+            CCheckQueueControl<CHeaderPoWCheck> control(&headerpowcheckqueue);
+            control.Add(vChecks);
+            control.Wait();
+        } else {
+            for (auto it = vChecks.rbegin(); it != vChecks.rend(); ++it)
+                if (!(*it)())
+                    break;
+        }
+    }
+
+    for (size_t i = 0; i < vHeaders.size(); i++)
+        vPoWValid[vHeaders[i] - &headers[0]] = vValid[i];
+}
+
 // Exposed wrapper for AcceptBlockHeader
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+    std::vector<bool> vPoWValid;
+    PrecheckHeadersPoW(headers, chainparams.GetConsensus(), vPoWValid);
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); i++) {
+            const CBlockHeader& header = headers[i];
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex, !vPoWValid[i])) {
                 if (first_invalid) *first_invalid = header;
                 return false;
             }
@@ -3550,6 +3886,9 @@ bool CChainState::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CVali
         }
         if (!ReceivedBlockTransactions(block, state, pindex, blockPos, chainparams.GetConsensus()))
             return error("AcceptBlock(): ReceivedBlockTransactions failed");
+        // Thor: Forge: Index the block's BCTs now rather than at connect, so on reindex they're found before the Forge blocks that use them are checked
+        if (pbctindex && !pbctindex->WriteBlock(block, pindex, blockPos, chainparams.GetConsensus()))
+            return AbortNode(state, "Failed to write BCT index");
     } catch (const std::runtime_error& e) {
         return AbortNode(state, std::string("System error: ") + e.what());
     }
@@ -3856,6 +4195,7 @@ bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlo
     for (const std::pair<int, CBlockIndex*>& item : vSortedByHeight)
     {
         CBlockIndex* pindex = item.second;
+        pindex->BuildForgeCounters(consensus_params);   // Thor: Forge
         pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
         pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
         // We can link the chain of blocks for which we've received transactions at some point.
@@ -3965,6 +4305,7 @@ bool LoadChainTip(const CChainParams& chainparams)
     if (it == mapBlockIndex.end())
         return false;
     chainActive.SetTip(it->second);
+    PublishTipSnapshot();   // Thor
 
     g_chainstate.PruneBlockIndexCandidates();
 
@@ -4286,6 +4627,7 @@ void UnloadBlockIndex()
 {
     LOCK(cs_main);
     chainActive.SetTip(nullptr);
+    PublishTipSnapshot();   // Thor
     pindexBestInvalid = nullptr;
     pindexBestHeader = nullptr;
     mempool.clear();
@@ -4295,6 +4637,8 @@ void UnloadBlockIndex()
     setDirtyBlockIndex.clear();
     setDirtyFileInfo.clear();
     versionbitscache.Clear();
+    for (std::atomic<int>& nHeight : nForgeDeploymentHeight)   // Thor: Forge
+        nHeight = 0;
     for (int b = 0; b < VERSIONBITS_NUM_BITS; b++) {
         warningcache[b].clear();
     }
@@ -4823,6 +5167,84 @@ bool DumpMempool(void)
     return true;
 }
 
+// Thor: Background block index PoW verifier progress
+static std::atomic<bool> fIndexPoWRunning(false);
+static std::atomic<int> nIndexPoWHeight(SKIP_BLOCKHEADER_POW - 1);
+static std::atomic<uint64_t> nIndexPoWVerified(0);
+static std::atomic<uint64_t> nIndexPoWFailed(0);
+
+IndexPoWStats GetIndexPoWStats()
+{
+    IndexPoWStats stats;
+    stats.fRunning = fIndexPoWRunning;
+    stats.nHeight = nIndexPoWHeight;
+    stats.nVerified = nIndexPoWVerified;
+    stats.nFailed = nIndexPoWFailed;
+    return stats;
+}
+
+void ThreadVerifyIndexPoW(const CChainParams& chainparams)
+{
+    RenameThread("thor-indexpow");
+    ScheduleBatchPriority();
+    const Consensus::Params& consensusParams = chainparams.GetConsensus();
+    const size_t nBatchSize = 256;
+    int nHeight = SKIP_BLOCKHEADER_POW;
+    int64_t nStart = GetTimeMillis();
+
+    fIndexPoWRunning = true;
+    LogPrintf("%s: verifying block index PoW from height %d\n", __func__, nHeight);
+    try {
+        while (true) {
+            std::vector<CBlockIndex*> vIndex;
+            std::vector<CBlockHeader> vHeaders;
+            bool fDone;
+            {
+                LOCK(cs_main);
+                for (; nHeight <= chainActive.Height() && vIndex.size() < nBatchSize; nHeight++) {
+                    CBlockIndex* pindex = chainActive[nHeight];
+                    if ((pindex->nStatus & BLOCK_POW_VERIFIED) || pindex->IsForgeMined(consensusParams))
+                        continue;
+                    vIndex.push_back(pindex);
+                    vHeaders.push_back(pindex->GetBlockHeader());
+                }
+                fDone = nHeight > chainActive.Height();
+            }
+
+            if (!vIndex.empty()) {
+                std::vector<const CBlockHeader*> vpHeaders;
+                for (const CBlockHeader& header : vHeaders)
+                    vpHeaders.push_back(&header);
+                std::vector<uint256> vHashes;
+                GetPoWHashes(vpHeaders, vHashes);
+
+                LOCK(cs_main);
+                for (size_t i = 0; i < vIndex.size(); i++) {
+                    if (CheckProofOfWork(vHashes[i], vHeaders[i].nBits, consensusParams)) {
+                        vIndex[i]->nStatus |= BLOCK_POW_VERIFIED;
+                        setDirtyBlockIndex.insert(vIndex[i]);
+                        nIndexPoWVerified++;
+                    } else {
+                        if (nIndexPoWFailed++ == 0)
+                            SetMiscWarning(_("Warning: A stored block header failed its proof of work check. Your block index may be corrupted, consider running with -reindex."));
+                        LogPrintf("%s: ERROR: block index entry %s at height %d failed its PoW check\n", __func__, vIndex[i]->GetBlockHash().ToString(), vIndex[i]->nHeight);
+                    }
+                }
+            }
+            nIndexPoWHeight = nHeight - 1;
+            if (fDone)
+                break;
+            MilliSleep(10);
+        }
+    } catch (const boost::thread_interrupted&) {
+        fIndexPoWRunning = false;
+        LogPrintf("%s: interrupted at height %d\n", __func__, nHeight);
+        throw;
+    }
+    fIndexPoWRunning = false;
+    LogPrintf("%s: done, %u entries verified, %u failed (%dms)\n", __func__, nIndexPoWVerified, nIndexPoWFailed, GetTimeMillis() - nStart);
+}
+
 //! Guess how far we are in the verification process at the given block index
 double GuessVerificationProgress(const ChainTxData& data, const CBlockIndex *pindex) {
     if (pindex == nullptr)
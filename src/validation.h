@@ -11,11 +11,13 @@
 #endif
 
 #include <amount.h>
+#include <arith_uint256.h>
 #include <coins.h>
 #include <fs.h>
 #include <protocol.h> // For CMessageHeader::MessageStartChars
 #include <policy/feerate.h>
 #include <script/script_error.h>
+#include <subsidy.h> // Thor: GetBlockSubsidy() and GetHammerCost() live here
 #include <sync.h>
 #include <versionbits.h>
 
@@ -29,6 +31,8 @@
 #include <vector>
 
 #include <atomic>
+#include <chrono>
+#include <memory>
 
 class CBlockIndex;
 class CBlockTreeDB;
@@ -41,6 +45,7 @@ class CBlockPolicyEstimator;
 class CTxMemPool;
 class CValidationState;
 struct ChainTxData;
+struct CDeterministicRand;
 
 struct PrecomputedTransactionData;
 struct LockPoints;
@@ -131,6 +136,10 @@ static const int64_t MAX_FEE_ESTIMATION_TIP_AGE = 3 * 60 * 60;
 /** Default for -permitbaremultisig */
 static const bool DEFAULT_PERMIT_BAREMULTISIG = true;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
+/** Default for -verifyblockreads */
+static const bool DEFAULT_VERIFY_BLOCK_READS = false;
+/** Thor: Default for -verifyindexpow, re-check stored header PoW in the background after startup */
+static const bool DEFAULT_VERIFY_INDEX_POW = true;
 static const bool DEFAULT_TXINDEX = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 /** Default for -persistmempool */
@@ -175,6 +184,8 @@ extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
 extern bool fCheckBlockIndex;
 extern bool fCheckpointsEnabled;
+/** Thor: Forge: Re-check PoW / Forge proofs of already-validated blocks when reading them back from disk */
+extern bool fVerifyBlockReads;
 extern size_t nCoinCacheUsage;
 /** A fee rate smaller than this is considered zero fee (for relaying, mining and transaction creation) */
 extern CFeeRate minRelayTxFee;
@@ -276,14 +287,37 @@ bool LoadChainTip(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Thor: Run an instance of the header PoW checking thread */
+void ThreadHeaderPoWCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
+
+/** Thor: The active chain tip as of its last change, for readers that would otherwise only take cs_main to look at it */
+struct CTipSnapshot
+{
+    const CBlockIndex* pindex;      //!< Only what is fixed once a block is indexed (header, height, ancestors) is safe to read without cs_main
+    int nHeight;
+    uint256 hashBlock;
+    int64_t nTime;
+    int64_t nMedianTimePast;
+    arith_uint256 nChainWork;
+};
+typedef std::shared_ptr<const CTipSnapshot> CTipSnapshotRef;
+
+/** Thor: The last published tip, or null before the chain is loaded. Never takes cs_main. */
+CTipSnapshotRef GetTipSnapshot();
+/** Thor: Publish chainActive's tip to GetTipSnapshot() and wake WaitForTipChange(); called wherever the tip is set */
+void PublishTipSnapshot();
+/**
+ * Thor: Block until a tip other than hashTip is published or the deadline passes, and return the
+ * latest snapshot. May also return early (on cvBlockChange being notified at shutdown, say), so
+ * callers loop on their own condition.
+ */
+CTipSnapshotRef WaitForTipChange(const uint256& hashTip, const std::chrono::steady_clock::time_point& deadline);
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
 bool GetTransaction(const uint256& hash, CTransactionRef& tx, const Consensus::Params& params, uint256& hashBlock, bool fAllowSlow = false, CBlockIndex* blockIndex = nullptr);
 /** Find the best known block, and make it the tip of the block chain */
 bool ActivateBestChain(CValidationState& state, const CChainParams& chainparams, std::shared_ptr<const CBlock> pblock = std::shared_ptr<const CBlock>());
-CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams);
-CAmount GetHammerCost(int nHeight, const Consensus::Params& consensusParams);  // Thor: Forge: Get the cost of a hammer at given height
 /** Guess verification progress (as a fraction between 0.0=genesis and 1.0=current tip). */
 double GuessVerificationProgress(const ChainTxData& data, const CBlockIndex* pindex);
 
@@ -400,6 +434,45 @@ void InitScriptExecutionCache();
 /** Functions for disk access for blocks */
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+/**
+ * Thor: Read a block's bytes as stored, without deserializing its transactions or checking its proof;
+ * only the header is checked against the index. For serving blocks which passed validation.
+ */
+bool ReadRawBlockFromDisk(std::vector<unsigned char>& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& messageStart);
+/** Thor: Copy a serialized block, leaving out its witness data, without deserializing it. False if it doesn't parse. */
+bool StripBlockWitness(const std::vector<unsigned char>& block, std::vector<unsigned char>& stripped);
+
+/** Thor: Forge: Proof checks performed (verified) or skipped (trusted) by ReadBlockFromDisk */
+struct BlockReadStats
+{
+    uint64_t nPoWVerified;
+    uint64_t nPoWTrusted;
+    int64_t nPoWVerifyMicros;
+    uint64_t nForgeVerified;
+    uint64_t nForgeTrusted;
+    int64_t nForgeVerifyMicros;
+    uint64_t nRawReads;         //!< Blocks read by ReadRawBlockFromDisk, which checks no proof
+    uint64_t nRawBytes;
+};
+BlockReadStats GetBlockReadStats();
+
+/** Thor: Progress of the background block index PoW verifier */
+struct IndexPoWStats
+{
+    bool fRunning;
+    int nHeight;        //!< Active chain height up to which every PoW header has BLOCK_POW_VERIFIED
+    uint64_t nVerified; //!< Entries checked by the verifier this session
+    uint64_t nFailed;   //!< Entries whose stored header failed its PoW check
+};
+IndexPoWStats GetIndexPoWStats();
+
+/**
+ * Thor: Re-check, at batch scheduling priority, the scrypt PoW of every active chain
+ * block index entry not yet marked BLOCK_POW_VERIFIED, marking them as it goes so a
+ * restart resumes where it left off. LoadBlockIndexGuts trusts the disk to keep
+ * startup fast; this is the deferred integrity check.
+ */
+void ThreadVerifyIndexPoW(const CChainParams& chainparams);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -424,6 +497,7 @@ bool IsForge12Enabled(const CBlockIndex* pindexPrev, const Consensus::Params& pa
 bool IsForge13Enabled(int nHeight);
 
 // Thor: Forge: Get the well-rooted deterministic random string (see whitepaper section 4.1)
+CDeterministicRand GetDeterministicRand(const CBlockIndex* pindexPrev);
 std::string GetDeterministicRandString(const CBlockIndex* pindexPrev);
 
 // Thor: Forge: Get tx by given hash, from a block at given chain height
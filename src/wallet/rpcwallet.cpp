@@ -741,16 +741,11 @@ UniValue gethammercreationtxid(const JSONRPCRequest& request)
     if (!wtx.IsForgeCoinBase())
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Not a gold transaction");
 
-    // Grab the scriptPubKey
-    const CTxOut& txout = wtx.tx->vout[0];
-    CScript goldTxProof = txout.scriptPubKey;
-
-    // Grab the txid (bytes 14-78; byte 13 has val 64 as size marker)
-    if (wtx.tx->vout[0].scriptPubKey.size() < 144)
+    // Look up the txid in the BCT registry (parsed from bytes 14-78 when the gold tx entered the wallet)
+    std::string bctTxIdStr;
+    if (wtx.tx->vout[0].scriptPubKey.size() < 144 || !pwallet->GetGoldBCT(goldTxHash, bctTxIdStr))
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Malformed gold transaction!");  // Should never hit; could probably be an assert.
-    std::vector<unsigned char> bctTxId(&wtx.tx->vout[0].scriptPubKey[14], &wtx.tx->vout[0].scriptPubKey[14 + 64]);
-    std::string bctTxIdStr = std::string(bctTxId.begin(), bctTxId.end());
-    
+
     return bctTxIdStr;
 }
 
@@ -920,6 +920,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
         wtxOrdered.insert(std::make_pair(wtx.nOrderPos, TxPair(&wtx, nullptr)));
         wtx.nTimeSmart = ComputeTimeSmart(wtx);
         AddToSpends(hash);
+        AddToBCTRegistry(wtx);  // Thor: Forge
     }
 
     bool fUpdated = false;
@@ -991,6 +992,7 @@ bool CWallet::LoadToWallet(const CWalletTx& wtxIn)
     wtx.BindWallet(this);
     wtxOrdered.insert(std::make_pair(wtx.nOrderPos, TxPair(&wtx, nullptr)));
     AddToSpends(hash);
+    AddToBCTRegistry(wtx);  // Thor: Forge
     for (const CTxIn& txin : wtx.tx->vin) {
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
@@ -2701,6 +2703,60 @@ OutputType CWallet::TransactionChangeType(OutputType change_type, const std::vec
 
 bool fWalletUnlockForgeMiningOnly = false;  // Thor: Forge: Unlock for forge mining purposes only.
 
+// Thor: Forge: Record a BCT, or a forge coinbase crediting one, in the BCT registry
+void CWallet::AddToBCTRegistry(const CWalletTx& wtx)
+{
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+
+    if (wtx.IsForgeCoinBase()) {
+        // Grab the txid (bytes 14-78; byte 13 has val 64 as size marker)
+        const CScript& forgeProof = wtx.tx->vout[0].scriptPubKey;
+        if (forgeProof.size() < 14 + 64 || wtx.tx->vout.size() < 2)
+            return;
+        std::string bctTxid(forgeProof.begin() + 14, forgeProof.begin() + 14 + 64);
+        mapForgeGoldTxs[bctTxid].insert(wtx.GetHash());
+        mapGoldBCT[wtx.GetHash()] = bctTxid;
+        return;
+    }
+
+    // CBTs aren't BCTs
+    if (wtx.IsCoinBase())
+        return;
+
+    CAmount hammerFeePaid;
+    CScript scriptPubKeyGold;
+    if (!wtx.tx->IsBCT(consensusParams, GetScriptForDestination(DecodeDestination(consensusParams.hammerCreationAddress)), &hammerFeePaid, &scriptPubKeyGold))
+        return;
+
+    // Grab gold address
+    CTxDestination goldDestination;
+    if (!ExtractDestination(scriptPubKeyGold, goldDestination)) {
+        LogPrintf ("** Couldn't extract destination from BCT %s (dest=%s)\n", wtx.GetHash().GetHex(), HexStr(scriptPubKeyGold));
+        return;
+    }
+
+    CBCTRegistryEntry entry;
+    entry.goldAddress = EncodeDestination(goldDestination);
+    entry.communityContrib = false;
+    if (wtx.tx->vout.size() > 1 && wtx.tx->vout[1].scriptPubKey == GetScriptForDestination(DecodeDestination(consensusParams.forgeCommunityAddress))) {
+        hammerFeePaid += wtx.tx->vout[1].nValue;            // Add any community fund contribution back to the total paid
+        entry.communityContrib = true;
+    }
+    entry.hammerFeePaid = hammerFeePaid;
+    mapBCTRegistry[wtx.GetHash()] = entry;
+}
+
+// Thor: Forge: Look up the BCT txid a forge coinbase in this wallet credits
+bool CWallet::GetGoldBCT(const uint256& goldTxid, std::string& bctTxid) const
+{
+    LOCK(cs_wallet);
+    auto it = mapGoldBCT.find(goldTxid);
+    if (it == mapGoldBCT.end())
+        return false;
+    bctTxid = it->second;
+    return true;
+}
+
 // Thor: Forge: Return all BCTs known by this wallet, optionally including dead hammers and optionally scanning for blocks minted by hammers from each BCT
 std::vector<CHammerCreationTransactionInfo> CWallet::GetBCTs(bool includeDead, bool scanRewards, const Consensus::Params& consensusParams, int minGoldConfirmations) {
     std::vector<CHammerCreationTransactionInfo> bcts;
@@ -2710,40 +2766,24 @@ std::vector<CHammerCreationTransactionInfo> CWallet::GetBCTs(bool includeDead, b
 
     int maxDepth = consensusParams.hammerGestationBlocks + consensusParams.hammerLifespanBlocks;
 
-    CScript scriptPubKeyBCF = GetScriptForDestination(DecodeDestination(consensusParams.hammerCreationAddress));
-    CScript scriptPubKeyCF = GetScriptForDestination(DecodeDestination(consensusParams.forgeCommunityAddress));
-
-    for (const std::pair<uint256, CWalletTx>& pairWtx : mapWallet) {
-        const CWalletTx& wtx = pairWtx.second;
-
-        // Skip unconfirmed transactions and orphans
-        if (wtx.GetDepthInMainChain() < 1)
+    LOCK2(cs_main, cs_wallet);
+    for (const std::pair<uint256, CBCTRegistryEntry>& pairBCT : mapBCTRegistry) {
+        auto itWtx = mapWallet.find(pairBCT.first);
+        if (itWtx == mapWallet.end())   // Zapped since it was registered
             continue;
+        const CWalletTx& wtx = itWtx->second;
+        const CBCTRegistryEntry& entry = pairBCT.second;
 
-        // Skip CBTs
-        if (wtx.IsCoinBase())
+        // Skip unconfirmed transactions and orphans
+        int depth = wtx.GetDepthInMainChain();
+        if (depth < 1)
             continue;
 
         // Check it's actually our BCT (otherwise comm fund keyholder for example would see all BCTs as wallet txs)
         if (!IsAllFromMe(*wtx.tx, ISMINE_SPENDABLE))
             continue;
 
-        // Skip non-BCT txs
-        CAmount hammerFeePaid;
-        CScript scriptPubKeyGold;
-        if (!wtx.tx->IsBCT(consensusParams, scriptPubKeyBCF, &hammerFeePaid, &scriptPubKeyGold))
-            continue;
-
-        // Grab gold address
-        CTxDestination goldDestination;
-        if (!ExtractDestination(scriptPubKeyGold, goldDestination)) {
-            LogPrintf ("** Couldn't extract destination from BCT %s (dest=%s)\n", wtx.GetHash().GetHex(), HexStr(scriptPubKeyGold));
-            continue;
-        }
-        std::string goldAddress = EncodeDestination(goldDestination);
-
         // Check lifespan & maturity
-        int depth = wtx.GetDepthInMainChain();
         int blocksLeft = maxDepth - depth;
         blocksLeft++;   // Hammer life starts at zero immediately AFTER the BCT appears in a block.
         bool isReady = false;
@@ -2761,42 +2801,31 @@ std::vector<CHammerCreationTransactionInfo> CWallet::GetBCTs(bool includeDead, b
             }
         }
 
-        // Find hammer count & community donation status
+        // Find hammer count
         int height = chainActive.Height() - depth;
         CAmount hammerCost = GetHammerCost(height, consensusParams);
-        bool communityContrib = false;
-        if (wtx.tx->vout.size() > 1 && wtx.tx->vout[1].scriptPubKey == scriptPubKeyCF) {
-            hammerFeePaid += wtx.tx->vout[1].nValue;            // Add any community fund contribution back to the total paid
-            communityContrib = true;
-        }
-        int hammerCount = hammerFeePaid / hammerCost;
+        int hammerCount = entry.hammerFeePaid / hammerCost;
 
-        // If ready, check for coinbase transactions from blocks minted by a hammer from this BCT
+        // If ready, total up the coinbase transactions from blocks minted by a hammer from this BCT
         std::string bctTxid = wtx.GetHash().GetHex();
         int blocksFound = 0;
         CAmount rewardsPaid = 0;
         if (isReady && scanRewards) {
-            for (const std::pair<uint256, CWalletTx>& pairWtx2 : mapWallet) {
-                const CWalletTx& wtx2 = pairWtx2.second;
-
-                // Skip non-CBTs
-                if (!wtx2.IsForgeCoinBase())
-                    continue;
-
-                // Skip unconfirmed transactions and orphans
-                if (wtx2.GetDepthInMainChain() < minGoldConfirmations)
-                    continue;
-
-                // Grab the txid (bytes 14-78)
-                std::vector<unsigned char> blockTxid(&wtx2.tx->vout[0].scriptPubKey[14], &wtx2.tx->vout[0].scriptPubKey[14 + 64]);
-                std::string blockTxidStr = std::string(blockTxid.begin(), blockTxid.end());
-
-                // Check it
-                if (bctTxid!=blockTxidStr)
-                    continue;
-
-                blocksFound++;
-                rewardsPaid += wtx2.tx->vout[1].nValue;
+            auto itGold = mapForgeGoldTxs.find(bctTxid);
+            if (itGold != mapForgeGoldTxs.end()) {
+                for (const uint256& goldTxid : itGold->second) {
+                    auto itWtx2 = mapWallet.find(goldTxid);
+                    if (itWtx2 == mapWallet.end())
+                        continue;
+                    const CWalletTx& wtx2 = itWtx2->second;
+
+                    // Skip unconfirmed transactions and orphans
+                    if (wtx2.GetDepthInMainChain() < minGoldConfirmations)
+                        continue;
+
+                    blocksFound++;
+                    rewardsPaid += wtx2.tx->vout[1].nValue;
+                }
             }
         }
 
@@ -2808,14 +2837,14 @@ std::vector<CHammerCreationTransactionInfo> CWallet::GetBCTs(bool includeDead, b
         bct.txid = bctTxid;
         bct.time = time;
         bct.hammerCount = hammerCount;
-        bct.hammerFeePaid = hammerFeePaid;
-        bct.communityContrib = communityContrib;
+        bct.hammerFeePaid = entry.hammerFeePaid;
+        bct.communityContrib = entry.communityContrib;
         bct.hammerStatus = status;
-        bct.goldAddress = goldAddress;
+        bct.goldAddress = entry.goldAddress;
         bct.rewardsPaid = rewardsPaid;
         bct.blocksFound = blocksFound;
         bct.blocksLeft = blocksLeft;
-        bct.profit = rewardsPaid - hammerFeePaid;
+        bct.profit = rewardsPaid - entry.hammerFeePaid;
 
         bcts.push_back(bct);
     }
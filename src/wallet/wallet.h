@@ -682,6 +682,14 @@ struct CHammerCreationTransactionInfo
     int blocksLeft;
 };
 
+// Thor: Forge: A wallet BCT as recorded in the BCT registry, parsed once when it enters the wallet
+struct CBCTRegistryEntry
+{
+    CAmount hammerFeePaid;      // Including any community fund contribution
+    bool communityContrib;
+    std::string goldAddress;
+};
+
 struct CHammerRange
 {
     std::string txid;
@@ -735,6 +743,17 @@ private:
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid);
     void AddToSpends(const uint256& wtxid);
 
+    /**
+     * Thor: Forge: BCT registry, so GetBCTs needn't rescan mapWallet (once per BCT for rewards).
+     * Holds the wallet's BCTs, the forge coinbases crediting each BCT (keyed by the BCT txid as
+     * written in the forge proof) and the BCT each forge coinbase credits. Entries are added as
+     * transactions enter mapWallet and checked against it when read.
+     */
+    std::map<uint256, CBCTRegistryEntry> mapBCTRegistry;
+    std::map<std::string, std::set<uint256>> mapForgeGoldTxs;
+    std::map<uint256, std::string> mapGoldBCT;
+    void AddToBCTRegistry(const CWalletTx& wtx);
+
     /* Mark a transaction (and its in-wallet descendants) as conflicting with a particular block. */
     void MarkConflicted(const uint256& hashBlock, const uint256& hashTx);
 
@@ -1005,6 +1024,9 @@ public:
     // Thor: Forge: Return all BCTs known by this wallet, optionally including dead hammers and optionally scanning for blocks minted by hammers from each BCT
     std::vector<CHammerCreationTransactionInfo> GetBCTs(bool includeDead, bool scanRewards, const Consensus::Params& consensusParams, int minGoldConfirmations = 1);
 
+    // Thor: Forge: Look up the BCT txid a forge coinbase in this wallet credits
+    bool GetGoldBCT(const uint256& goldTxid, std::string& bctTxid) const;
+
     /**
      * Insert additional inputs into the transaction by
      * calling CreateTransaction();